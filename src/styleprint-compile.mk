@@ -0,0 +1,23 @@
+# ######################################################################### $
+# styleprint-compile.mk - Rules to compile StylePrintTable xml definitions  $
+# into C with styleprint-compile.                                           $
+#                                                                           $
+# Include this file from an application's Makefile.am (GNU make), and list  $
+# the generated sources:                                                    $
+#                                                                           $
+#   STYLEPRINT_DATADIR := $(shell pkg-config --variable=styleprintdatadir \ $
+#                                            styleprinttable)               $
+#   include $(STYLEPRINT_DATADIR)/styleprint-compile.mk                     $
+#   myapp_SOURCES += report.tpl.c                                           $
+#                                                                           $
+# "report.tpl.c" is then built from "report.xml", and defines               $
+# "const StylePrintStaticTemplate report_template".  The name is made from  $
+# the file name by styleprint-compile, with any character not allowed in a  $
+# C identifier replaced by "_".                                             $
+# $Id::                                                                     $
+# ######################################################################### $
+
+STYLEPRINT_COMPILE ?= styleprint-compile
+
+%.tpl.c: %.xml
+	$(STYLEPRINT_COMPILE) --output=$@ $<
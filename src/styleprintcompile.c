@@ -0,0 +1,373 @@
+/*
+Copyright (c) 2017 David Breeding
+
+This file is part of tableprint.
+
+tableprint is free software: you can redistribute it and/or modify
+it under the terms of the Lesser GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+tableprint is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with tableprint (see the files "COPYING" and "COPYING.LESSER").
+If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* ************************************************************************ *
+ * styleprintcompile.c - styleprint-compile: compile the xml definition of  $
+ * a printout into the static tables of a StylePrintStaticTemplate          $
+ *                                                                          $
+ * usage: styleprint-compile [--name=NAME] [--output=FILE] TEMPLATE.xml     $
+ *                                                                          $
+ * The xml is parsed with the library's own parser, and the resulting       $
+ * GRPINF/CELLINF tree is written out as C source, so that the compiled     $
+ * template is exactly what the parser would have produced at run time.     $
+ * $Id::                                                                    $
+ * ************************************************************************ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <glib/gstdio.h>
+#include "styleprinttablepriv.h"
+
+static gchar *Name = NULL;
+static gchar *Output = NULL;
+
+static GOptionEntry Options[] = {
+    {"name", 'n', 0, G_OPTION_ARG_STRING, &Name,
+        "Name of the StylePrintStaticTemplate (default: from the file name)",
+        "NAME"},
+    {"output", 'o', 0, G_OPTION_ARG_FILENAME, &Output,
+        "Write the C source to FILE (default: standard output)", "FILE"},
+    {NULL}
+};
+
+/* ******************************************************************** *
+ * emit_string() - Write "str" as a C string literal, or NULL.          *
+ * ******************************************************************** */
+
+static void
+emit_string (FILE *fp, const gchar *str)
+{
+    const guchar *p;
+
+    if (!str)
+    {
+        fputs ("NULL", fp);
+        return;
+    }
+
+    fputc ('"', fp);
+
+    for (p = (const guchar *)str; *p; p++)
+    {
+        if ((*p == '"') || (*p == '\\'))
+        {
+            fprintf (fp, "\\%c", *p);
+        }
+        else if ((*p < ' ') || (*p >= 0x7f))
+        {
+            // Octal, so that a following digit cannot extend the escape
+            fprintf (fp, "\\%03o", *p);
+        }
+        else
+        {
+            fputc (*p, fp);
+        }
+    }
+
+    fputc ('"', fp);
+}
+
+/* ******************************************************************** *
+ * emit_font() - Write a font description as a string literal.          *
+ * ******************************************************************** */
+
+static void
+emit_font (FILE *fp, const PangoFontDescription *font)
+{
+    gchar *str = font ? pango_font_description_to_string (font) : NULL;
+
+    emit_string (fp, str);
+    g_free (str);
+}
+
+/* ******************************************************************** *
+ * emit_padding() - Write the array for a ROWPAD, returning its number  *
+ *      (or -1 if "pad" is NULL).                                       *
+ * ******************************************************************** */
+
+static gint
+emit_padding (FILE *fp, ROWPAD *pad, gint *count)
+{
+    if (!pad)
+    {
+        return -1;
+    }
+
+    fprintf (fp, "static const gdouble %s_pad_%d[] = "
+                    "{%.17g, %.17g, %.17g, %.17g};\n\n",
+                Name, *count, pad->left, pad->top, pad->right, pad->bottom);
+    return (*count)++;
+}
+
+/* ******************************************************************** *
+ * emit_group() - Write the tables for "grp", its header and its        *
+ *      descendants, each before whatever refers to it.                 *
+ * Returns: The number of the group's StylePrintStaticGroup.            *
+ * ******************************************************************** */
+
+static gint
+emit_group (FILE *fp, GRPINF *grp, gint *count)
+{
+    gint header = -1,
+         child = -1,
+         pad,
+         me;
+    guint ncells = grp->celldefs ? grp->celldefs->len : 0,
+          idx;
+
+    if (grp->header)
+    {
+        header = emit_group (fp, grp->header, count);
+    }
+
+    if (grp->grpchild)
+    {
+        child = emit_group (fp, grp->grpchild, count);
+    }
+
+    pad = emit_padding (fp, grp->padding, count);
+    me = (*count)++;
+
+    if (ncells)
+    {
+        fprintf (fp, "static const StylePrintStaticCell %s_cells_%d[] = {\n",
+                    Name, me);
+
+        for (idx = 0; idx < ncells; idx++)
+        {
+            CELLINF *cell = g_ptr_array_index (grp->celldefs, idx);
+
+            fputs ("    {", fp);
+            emit_font (fp, cell->pangofont);
+            fprintf (fp, ", %d, ", cell->txtsource);
+            emit_string (fp, cell->celltext);
+            fprintf (fp, ", %.17g, %.17g, %d, %d, %d, %d},\n",
+                        cell->percent, cell->cellwidth, cell->padleft,
+                        cell->padright, cell->borderstyle, cell->layoutalign);
+        }
+
+        fputs ("};\n\n", fp);
+    }
+
+    fprintf (fp, "static const StylePrintStaticGroup %s_grp_%d = {\n    %d, ",
+                Name, me, grp->grptype);
+    emit_font (fp, grp->pangofont);
+    fputs (", ", fp);
+    emit_string (fp, grp->grpcol);
+    fprintf (fp, ", %d, %d, %d,\n", grp->pointsabove, grp->pointsbelow,
+                grp->borderstyle);
+
+    if (pad < 0)
+    {
+        fputs ("    NULL, ", fp);
+    }
+    else
+    {
+        fprintf (fp, "    %s_pad_%d, ", Name, pad);
+    }
+
+    if (header < 0)
+    {
+        fputs ("NULL, ", fp);
+    }
+    else
+    {
+        fprintf (fp, "&%s_grp_%d, ", Name, header);
+    }
+
+    if (child < 0)
+    {
+        fputs ("NULL,\n", fp);
+    }
+    else
+    {
+        fprintf (fp, "&%s_grp_%d,\n", Name, child);
+    }
+
+    if (ncells)
+    {
+        fprintf (fp, "    %s_cells_%d, %u\n};\n\n", Name, me, ncells);
+    }
+    else
+    {
+        fputs ("    NULL, 0\n};\n\n", fp);
+    }
+
+    return me;
+}
+
+/* ******************************************************************** *
+ * emit_group_ref() - Write a pointer to a top-level group, or NULL.    *
+ * ******************************************************************** */
+
+static void
+emit_group_ref (FILE *fp, gint grp)
+{
+    if (grp < 0)
+    {
+        fputs ("    NULL", fp);
+    }
+    else
+    {
+        fprintf (fp, "    &%s_grp_%d", Name, grp);
+    }
+}
+
+/* ******************************************************************** *
+ * emit_template() - Write the C source for the whole template.         *
+ * ******************************************************************** */
+
+static void
+emit_template (FILE *fp, StylePrintTemplate *tmpl, const gchar *source)
+{
+    gint count = 0,
+         dflpad,
+         dochd = -1,
+         pagehd = -1,
+         body = -1;
+
+    fputs ("/* Generated by styleprint-compile from ", fp);
+    fputs (source, fp);
+    fputs (" - do not edit */\n\n#include <styleprinttable.h>\n\n", fp);
+
+    dflpad = emit_padding (fp, tmpl->DefaultPadding, &count);
+
+    if (tmpl->DocHeader)
+    {
+        dochd = emit_group (fp, tmpl->DocHeader, &count);
+    }
+
+    if (tmpl->PageHeader)
+    {
+        pagehd = emit_group (fp, tmpl->PageHeader, &count);
+    }
+
+    if (tmpl->grpHd)
+    {
+        body = emit_group (fp, tmpl->grpHd, &count);
+    }
+
+    fprintf (fp, "const StylePrintStaticTemplate %s = {\n    ", Name);
+    emit_font (fp, tmpl->defaultcell->pangofont);
+    fprintf (fp, ",\n    %s_pad_%d,\n", Name, dflpad);
+    emit_group_ref (fp, dochd);
+    fputs (",\n", fp);
+    emit_group_ref (fp, pagehd);
+    fputs (",\n", fp);
+    emit_group_ref (fp, body);
+    fputs ("\n};\n", fp);
+}
+
+/* ******************************************************************** *
+ * default_name() - Make a C identifier from the template's file name:  *
+ *      "daily-report.xml" becomes "daily_report_template".             *
+ * ******************************************************************** */
+
+static gchar *
+default_name (const gchar *filename)
+{
+    gchar *base = g_path_get_basename (filename),
+          *dot,
+          *name,
+          *p;
+
+    if ((dot = strrchr (base, '.')))
+    {
+        *dot = '\0';
+    }
+
+    name = g_strconcat (g_ascii_isdigit (base[0]) ? "_" : "", base,
+                        "_template", NULL);
+
+    for (p = name; *p; p++)
+    {
+        if (!g_ascii_isalnum (*p))
+        {
+            *p = '_';
+        }
+    }
+
+    g_free (base);
+    return name;
+}
+
+int
+main (int argc, char **argv)
+{
+    GOptionContext *opts;
+    StylePrintTemplate *tmpl;
+    GError *error = NULL;
+    FILE *fp = stdout;
+
+    opts = g_option_context_new ("TEMPLATE.xml");
+    g_option_context_set_summary (opts,
+            "Compile a StylePrintTable xml definition into C tables");
+    g_option_context_add_main_entries (opts, Options, NULL);
+
+    if (!g_option_context_parse (opts, &argc, &argv, &error))
+    {
+        fprintf (stderr, "%s\n", error->message);
+        return 1;
+    }
+
+    g_option_context_free (opts);
+
+    if (argc != 2)
+    {
+        fprintf (stderr, "usage: %s [--name=NAME] [--output=FILE] "
+                        "TEMPLATE.xml\n", argv[0]);
+        return 1;
+    }
+
+    if (!(tmpl = style_print_template_new_from_file (argv[1], &error)))
+    {
+        fprintf (stderr, "%s: %s\n", argv[1], error->message);
+        return 1;
+    }
+
+    if (!Name)
+    {
+        Name = default_name (argv[1]);
+    }
+
+    if (Output && !(fp = g_fopen (Output, "w")))
+    {
+        fprintf (stderr, "Failed to open file: '%s'\n", Output);
+        return 1;
+    }
+
+    emit_template (fp, tmpl, argv[1]);
+
+    if (ferror (fp) | (fp != stdout ? fclose (fp) : fflush (fp)))
+    {
+        fprintf (stderr, "Error writing '%s'\n", Output ? Output : "stdout");
+
+        if (Output)
+        {
+            g_remove (Output);
+        }
+
+        return 1;
+    }
+
+    g_object_unref (tmpl);
+    return 0;
+}
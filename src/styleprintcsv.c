@@ -0,0 +1,591 @@
+/*
+Copyright (c) 2017 David Breeding
+
+This file is part of tableprint.
+
+tableprint is free software: you can redistribute it and/or modify
+it under the terms of the Lesser GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+tableprint is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with tableprint (see the files "COPYING" and "COPYING.LESSER").
+If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* ************************************************************************ *
+ * styleprintcsv.c - A StylePrintDataset reading a memory-mapped CSV or     $
+ * TSV file                                                                 $
+ *                                                                          $
+ * The file is scanned once, when it is opened, to find where each field    $
+ * begins and ends.  Only the delimiter, the double quote, CR and LF are    $
+ * of interest to the scanner, so the file is examined 16 bytes at a time   $
+ * (where SSE2 is available), producing a bit mask of the positions of      $
+ * those characters, and only those positions are visited.                  $
+ *                                                                          $
+ * The result is an index holding a pointer and a length for each field.   $
+ * Fields are returned to the renderer as slices of the mapped file.  Only  $
+ * quoted fields containing doubled quotes are copied, to remove the        $
+ * escapes.                                                                 $
+ * $Id::                                                                    $
+ * ************************************************************************ */
+
+#include <string.h>
+#include "styleprintcsv.h"
+
+#if defined(__SSE2__) && defined(__GNUC__)
+#   include <emmintrin.h>
+#   define CSV_USE_SSE2 1
+#endif
+
+/**
+ * SECTION: styleprintcsv
+ * @Title: CSV Files
+ * @Short_description: Print data from CSV or TSV files
+ * @See_also: #StylePrintDataset
+ *
+ * style_print_csv_open() provides the contents of a CSV (or TSV) file as
+ * a #StylePrintDataset, which can be printed with
+ * style_print_table_from_xmlfile_dataset() and friends.
+ *
+ * The file is mapped into memory rather than read, and the values are
+ * printed directly from the mapping, so there is no need to build the
+ * data in memory.
+ *
+ * Fields may be enclosed in double quotes, in which case they may contain
+ * the delimiter, line breaks, and double quotes (written as two double
+ * quotes).  Lines may end with either LF or CR-LF.  Blank lines are
+ * ignored.  A row with fewer fields than there are columns has NULL
+ * values for the columns missing, and any extra fields are ignored.
+ */
+
+// One field of the file
+typedef struct {
+    const gchar *ptr;       // The value, NULL for a missing field
+    guint32      len;
+    guint32      term;      // TRUE if ptr is null-terminated
+} CSVFIELD;
+
+G_DEFINE_QUARK(style-print-csv-error-quark, style_print_csv_error)
+
+/* ==================================================================== *
+ * StylePrintCsvDataset                                                 *
+ * ==================================================================== */
+
+#define STYLE_PRINT_TYPE_CSV_DATASET (style_print_csv_dataset_get_type())
+
+G_DECLARE_FINAL_TYPE(StylePrintCsvDataset, style_print_csv_dataset, STYLE_PRINT, CSV_DATASET, StylePrintDataset)
+
+struct _StylePrintCsvDataset
+{
+    StylePrintDataset parent_instance;
+
+    /*< private >*/
+    GMappedFile  *map;
+    guint         ncols;
+    guint         nrows;
+    GArray       *fields;       // CSVFIELD's, ncols for each row
+    GStringChunk *copies;       // Unescaped and null-terminated values
+    GPtrArray    *names;        // Column names (in copies)
+    GHashTable   *colindex;     // Column name => index + 1
+};
+
+G_DEFINE_TYPE(StylePrintCsvDataset, style_print_csv_dataset,
+                                            STYLE_PRINT_TYPE_DATASET)
+
+static void
+style_print_csv_dataset_init (StylePrintCsvDataset *self)
+{
+    self->map = NULL;
+    self->ncols = 0;
+    self->nrows = 0;
+    self->fields = g_array_new (FALSE, FALSE, sizeof (CSVFIELD));
+    self->copies = g_string_chunk_new (4096);
+    self->names = g_ptr_array_new ();
+    self->colindex = g_hash_table_new (g_str_hash, g_str_equal);
+}
+
+static void
+style_print_csv_dataset_finalize (GObject *object)
+{
+    StylePrintCsvDataset *self = STYLE_PRINT_CSV_DATASET(object);
+
+    g_hash_table_destroy (self->colindex);
+    g_ptr_array_free (self->names, TRUE);
+    g_string_chunk_free (self->copies);
+    g_array_free (self->fields, TRUE);
+
+    if (self->map)
+    {
+        g_mapped_file_unref (self->map);
+    }
+
+    G_OBJECT_CLASS(style_print_csv_dataset_parent_class)->finalize (object);
+}
+
+#define CSV_FIELD(s,row,col) \
+        (&g_array_index ((s)->fields, CSVFIELD, (row) * (s)->ncols + (col)))
+
+static guint
+csv_dataset_get_n_rows (StylePrintDataset *ds)
+{
+    return STYLE_PRINT_CSV_DATASET(ds)->nrows;
+}
+
+static const gchar *
+csv_dataset_get_slice (StylePrintDataset *ds, guint row, guint col,
+                                                        gsize *len)
+{
+    CSVFIELD *fld = CSV_FIELD(STYLE_PRINT_CSV_DATASET(ds), row, col);
+
+    *len = fld->len;
+    return fld->ptr;
+}
+
+/* The fields in the mapped file are not null-terminated, so a value
+ * asked for as a string is copied the first time it is requested.
+ */
+
+static const gchar *
+csv_dataset_get_value (StylePrintDataset *ds, guint row, guint col)
+{
+    StylePrintCsvDataset *self = STYLE_PRINT_CSV_DATASET(ds);
+    CSVFIELD *fld = CSV_FIELD(self, row, col);
+
+    if (fld->ptr && !fld->term)
+    {
+        fld->ptr = g_string_chunk_insert_len (self->copies, fld->ptr,
+                                                            fld->len);
+        fld->term = TRUE;
+    }
+
+    return fld->ptr;
+}
+
+static guint
+csv_dataset_get_n_columns (StylePrintDataset *ds)
+{
+    return STYLE_PRINT_CSV_DATASET(ds)->ncols;
+}
+
+static const gchar *
+csv_dataset_get_column_name (StylePrintDataset *ds, guint col)
+{
+    StylePrintCsvDataset *self = STYLE_PRINT_CSV_DATASET(ds);
+
+    return col < self->names->len ? g_ptr_array_index (self->names, col)
+                                  : NULL;
+}
+
+static gint
+csv_dataset_get_column_index (StylePrintDataset *ds, const gchar *name)
+{
+    return GPOINTER_TO_INT(g_hash_table_lookup (
+                    STYLE_PRINT_CSV_DATASET(ds)->colindex, name)) - 1;
+}
+
+static void
+style_print_csv_dataset_class_init (StylePrintCsvDatasetClass *class)
+{
+    GObjectClass *gobject_class = (GObjectClass *) class;
+    StylePrintDatasetClass *ds_class = (StylePrintDatasetClass *) class;
+
+    gobject_class->finalize = style_print_csv_dataset_finalize;
+
+    ds_class->get_n_rows = csv_dataset_get_n_rows;
+    ds_class->get_value = csv_dataset_get_value;
+    ds_class->get_slice = csv_dataset_get_slice;
+    ds_class->get_n_columns = csv_dataset_get_n_columns;
+    ds_class->get_column_name = csv_dataset_get_column_name;
+    ds_class->get_column_index = csv_dataset_get_column_index;
+}
+
+/* ==================================================================== *
+ * Scanning                                                             *
+ * ==================================================================== */
+
+typedef struct {
+    StylePrintCsvDataset *ds;
+    const gchar *base;          // The start of the file
+    gboolean     header;        // The first row holds the column names
+    gboolean     firstrow;      // No row has been completed yet
+    GArray      *row;           // CSVFIELD's of the row being scanned
+    gsize        fldstart;      // Offset where the current field begins
+    gsize        rowstart;      // Offset where the current row begins
+    gsize        closeq;        // Offset of the last closing quote
+    gsize        skiplf;        // Offset of a LF following a CR
+    gboolean     quoted;        // The current field began with a quote
+    gboolean     inquotes;      // Within a quoted section
+    gboolean     escaped;       // The field contains a doubled quote
+    GError      *error;
+} CSVSCAN;
+
+/* ******************************************************************** *
+ * csv_unescape() - Copy a quoted field, replacing each doubled quote   *
+ *      with a single one.                                              *
+ * ******************************************************************** */
+
+static void
+csv_unescape (CSVSCAN *scan, CSVFIELD *fld)
+{
+    gchar *copy = g_string_chunk_insert_len (scan->ds->copies, fld->ptr,
+                                                            fld->len);
+    gchar *src, *dst;
+
+    for (src = dst = copy; *src; ++src)
+    {
+        *dst++ = *src;
+
+        if ((src[0] == '"') && (src[1] == '"'))
+        {
+            ++src;
+        }
+    }
+
+    *dst = '\0';
+    fld->ptr = copy;
+    fld->len = dst - copy;
+    fld->term = TRUE;
+}
+
+/* ******************************************************************** *
+ * csv_end_field() - The field which began at scan->fldstart ends at    *
+ *      "pos" (the offset of the delimiter or line end).                *
+ * ******************************************************************** */
+
+static void
+csv_end_field (CSVSCAN *scan, gsize pos)
+{
+    CSVFIELD fld;
+    gsize start = scan->fldstart, end = pos;
+
+    if (scan->quoted)
+    {
+        // Anything between the closing quote and the delimiter is ignored
+        start += 1;
+        end = MAX (start, scan->closeq);
+    }
+
+    if (end - start > G_MAXUINT32)
+    {
+        if (!scan->error)
+        {
+            g_set_error_literal (&scan->error, STYLE_PRINT_CSV_ERROR,
+                    STYLE_PRINT_CSV_ERROR_TOO_LARGE, "CSV field too long");
+        }
+
+        end = start;
+    }
+
+    fld.ptr = scan->base + start;
+    fld.len = end - start;
+    fld.term = FALSE;
+
+    if (scan->escaped)
+    {
+        csv_unescape (scan, &fld);
+    }
+
+    g_array_append_val (scan->row, fld);
+
+    scan->fldstart = pos + 1;
+    scan->quoted = FALSE;
+    scan->inquotes = FALSE;
+    scan->escaped = FALSE;
+}
+
+/* ******************************************************************** *
+ * csv_end_row() - The row has ended.  The first row sets the number    *
+ *      of columns, and (if there is a header) their names.  Other rows *
+ *      are added to the index.                                         *
+ * ******************************************************************** */
+
+static void
+csv_end_row (CSVSCAN *scan, gsize pos)
+{
+    StylePrintCsvDataset *ds = scan->ds;
+    guint col;
+
+    // A blank line
+    if ((scan->row->len == 1) && (pos == scan->rowstart))
+    {
+        g_array_set_size (scan->row, 0);
+        scan->rowstart = pos + 1;
+        return;
+    }
+
+    if (scan->firstrow)
+    {
+        scan->firstrow = FALSE;
+        ds->ncols = scan->row->len;
+
+        for (col = 0; col < ds->ncols; col++)
+        {
+            CSVFIELD *fld = &g_array_index (scan->row, CSVFIELD, col);
+            gchar *name;
+
+            if (scan->header)
+            {
+                name = g_string_chunk_insert_len (ds->copies, fld->ptr,
+                                                            fld->len);
+            }
+            else
+            {
+                gchar num[16];
+
+                g_snprintf (num, sizeof (num), "%u", col + 1);
+                name = g_string_chunk_insert (ds->copies, num);
+            }
+
+            g_ptr_array_add (ds->names, name);
+
+            // If a name is repeated, the first column of that name is used
+            if (!g_hash_table_contains (ds->colindex, name))
+            {
+                g_hash_table_insert (ds->colindex, name,
+                                    GINT_TO_POINTER(col + 1));
+            }
+        }
+
+        if (scan->header)
+        {
+            g_array_set_size (scan->row, 0);
+            scan->rowstart = pos + 1;
+            return;
+        }
+    }
+
+    if (ds->nrows == G_MAXINT)
+    {
+        if (!scan->error)
+        {
+            g_set_error_literal (&scan->error, STYLE_PRINT_CSV_ERROR,
+                    STYLE_PRINT_CSV_ERROR_TOO_LARGE,
+                    "Too many rows in CSV file");
+        }
+    }
+    else
+    {
+        // Pad a short row with missing fields, and drop any extra fields
+        if (scan->row->len < ds->ncols)
+        {
+            CSVFIELD missing = {NULL, 0, TRUE};
+
+            while (scan->row->len < ds->ncols)
+            {
+                g_array_append_val (scan->row, missing);
+            }
+        }
+
+        g_array_append_vals (ds->fields, scan->row->data, ds->ncols);
+        ++(ds->nrows);
+    }
+
+    g_array_set_size (scan->row, 0);
+    scan->rowstart = pos + 1;
+}
+
+/* ******************************************************************** *
+ * csv_event() - Process one of the characters of interest, "c", found  *
+ *      at offset "pos".                                                *
+ * ******************************************************************** */
+
+static inline void
+csv_event (CSVSCAN *scan, gsize pos, gchar c, gchar delim)
+{
+    if (c == '"')
+    {
+        if (scan->inquotes)
+        {
+            scan->inquotes = FALSE;
+            scan->closeq = pos;
+        }
+        else if (scan->quoted && (pos == scan->closeq + 1))
+        {
+            // A doubled quote within a quoted field
+            scan->inquotes = TRUE;
+            scan->escaped = TRUE;
+        }
+        else if (pos == scan->fldstart)
+        {
+            scan->quoted = TRUE;
+            scan->inquotes = TRUE;
+        }
+
+        // Otherwise, a quote within an unquoted field is just text
+        return;
+    }
+
+    if (scan->inquotes)
+    {
+        return;
+    }
+
+    if (c == delim)
+    {
+        csv_end_field (scan, pos);
+    }
+    else if (c == '\r')
+    {
+        csv_end_field (scan, pos);
+        csv_end_row (scan, pos);
+        scan->skiplf = pos + 1;
+    }
+    else if (c == '\n')
+    {
+        if ((pos == scan->skiplf) && (pos == scan->fldstart))
+        {
+            // The LF of a CR-LF pair
+            scan->fldstart = scan->rowstart = pos + 1;
+            return;
+        }
+
+        csv_end_field (scan, pos);
+        csv_end_row (scan, pos);
+    }
+}
+
+/* ******************************************************************** *
+ * csv_scan() - Find every field in the "len" bytes at scan->base.      *
+ * ******************************************************************** */
+
+static void
+csv_scan (CSVSCAN *scan, gsize len, gchar delim)
+{
+    const gchar *base = scan->base;
+    gsize pos = 0;
+
+#ifdef CSV_USE_SSE2
+    const __m128i vdelim = _mm_set1_epi8 (delim);
+    const __m128i vquote = _mm_set1_epi8 ('"');
+    const __m128i vcr = _mm_set1_epi8 ('\r');
+    const __m128i vlf = _mm_set1_epi8 ('\n');
+
+    for ( ; pos + 16 <= len; pos += 16)
+    {
+        __m128i v = _mm_loadu_si128 ((const __m128i *)(base + pos));
+        guint mask = _mm_movemask_epi8 (_mm_or_si128 (
+                        _mm_or_si128 (_mm_cmpeq_epi8 (v, vdelim),
+                                      _mm_cmpeq_epi8 (v, vquote)),
+                        _mm_or_si128 (_mm_cmpeq_epi8 (v, vcr),
+                                      _mm_cmpeq_epi8 (v, vlf))));
+
+        while (mask)
+        {
+            gsize at = pos + __builtin_ctz (mask);
+
+            csv_event (scan, at, base[at], delim);
+            mask &= mask - 1;
+        }
+    }
+#endif
+
+    for ( ; pos < len; pos++)
+    {
+        gchar c = base[pos];
+
+        if ((c == delim) || (c == '"') || (c == '\r') || (c == '\n'))
+        {
+            csv_event (scan, pos, c, delim);
+        }
+    }
+
+    // A last line with no line end
+    if ((scan->fldstart < len) || scan->row->len)
+    {
+        if (scan->quoted && scan->inquotes)
+        {
+            // An unterminated quote runs to the end of the file
+            scan->closeq = len;
+        }
+
+        scan->inquotes = FALSE;
+        csv_end_field (scan, len);
+        csv_end_row (scan, len);
+    }
+}
+
+/**
+ * style_print_csv_open:
+ * @filename: The name of the file
+ * @delimiter: The field delimiter, or 0 to use a tab if the file name
+ * ends in ".tsv" or ".tab", else a comma
+ * @header: TRUE if the first line of the file holds the column names.
+ * Otherwise the columns are named "1", "2", etc.
+ * @error: Return location for a #GError, or NULL
+ *
+ * Maps a CSV or TSV file into memory, and provides its contents as a
+ * #StylePrintDataset.  The file is expected to be UTF-8, and a byte order
+ * mark at its beginning is skipped.
+ *
+ * The file remains mapped until the dataset is finalized, and must not be
+ * modified in the meantime.
+ *
+ * Returns: (transfer full) (nullable): A new #StylePrintDataset, or NULL on
+ * error.
+ */
+
+StylePrintDataset *
+style_print_csv_open (const gchar *filename,
+                            gchar  delimiter,
+                         gboolean  header,
+                           GError **error)
+{
+    StylePrintCsvDataset *self;
+    GMappedFile *map;
+    CSVSCAN scan;
+    gsize len;
+
+    g_return_val_if_fail (filename != NULL, NULL);
+
+    if (!(map = g_mapped_file_new (filename, FALSE, error)))
+    {
+        return NULL;
+    }
+
+    if (!delimiter)
+    {
+        delimiter = (g_str_has_suffix (filename, ".tsv") ||
+                     g_str_has_suffix (filename, ".tab")) ? '\t' : ',';
+    }
+
+    self = g_object_new (STYLE_PRINT_TYPE_CSV_DATASET, NULL);
+    self->map = map;
+
+    memset (&scan, 0, sizeof (scan));
+    scan.ds = self;
+    scan.base = g_mapped_file_get_contents (map);
+    scan.header = header;
+    scan.firstrow = TRUE;
+    scan.row = g_array_new (FALSE, FALSE, sizeof (CSVFIELD));
+    scan.skiplf = G_MAXSIZE;
+    scan.closeq = G_MAXSIZE - 1;
+    len = g_mapped_file_get_length (map);
+
+    if ((len >= 3) && (memcmp (scan.base, "\xEF\xBB\xBF", 3) == 0))
+    {
+        scan.base += 3;
+        len -= 3;
+    }
+
+    if (scan.base)
+    {
+        csv_scan (&scan, len, delimiter);
+    }
+
+    g_array_free (scan.row, TRUE);
+
+    if (scan.error)
+    {
+        g_propagate_error (error, scan.error);
+        g_object_unref (self);
+        return NULL;
+    }
+
+    return STYLE_PRINT_DATASET(self);
+}
@@ -0,0 +1,66 @@
+/*
+Copyright (c) 2017 David Breeding
+
+This file is part of tableprint.
+
+tableprint is free software: you can redistribute it and/or modify
+it under the terms of the Lesser GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+tableprint is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with tableprint (see the files "COPYING" and "COPYING.LESSER").
+If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* ************************************************************************ *
+ * styleprintcsv.h - Header file for reading CSV and TSV files as a         *
+ * StylePrintDataset                                                        *
+ * ************************************************************************ */
+
+#ifndef __STYLE_PRINT_CSV_H
+#define __STYLE_PRINT_CSV_H
+
+#ifdef _cplusplus
+extern "C"
+{       //}     // To make vim quit trying to indent...
+#endif
+
+#include <glib-object.h>
+#include <glib.h>
+#include <styleprintdataset.h>
+
+G_BEGIN_DECLS
+
+#define STYLE_PRINT_CSV_ERROR (style_print_csv_error_quark())
+
+/**
+ * StylePrintCsvError:
+ * @STYLE_PRINT_CSV_ERROR_TOO_LARGE: The file has too many rows, or a
+ * field is too long
+ *
+ */
+
+typedef enum {
+    STYLE_PRINT_CSV_ERROR_TOO_LARGE
+} StylePrintCsvError;
+
+GQuark style_print_csv_error_quark (void);
+
+StylePrintDataset *style_print_csv_open (const gchar *filename,
+                                               gchar  delimiter,
+                                            gboolean  header,
+                                              GError **error);
+
+G_END_DECLS
+
+#ifdef _cplusplus
+}
+#endif
+
+#endif      //ifndef __STYLE_PRINT_CSV_H
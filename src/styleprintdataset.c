@@ -0,0 +1,1682 @@
+/*
+Copyright (c) 2017 David Breeding
+
+This file is part of tableprint.
+
+tableprint is free software: you can redistribute it and/or modify
+it under the terms of the Lesser GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+tableprint is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with tableprint (see the files "COPYING" and "COPYING.LESSER").
+If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* ************************************************************************ *
+ * styleprintdataset.c - Columnar data container for StylePrintTable        $
+ *                                                                          $
+ * The data is held as one array of values per column, all columns sharing $
+ * a single schema (the list of column names).  A cell is addressed by its  $
+ * row number and the index of its column in the schema, so that looking   $
+ * up a value is a pair of array indexes rather than a hash lookup on the   $
+ * column name for every row.                                               $
+ *                                                                          $
+ * Each value occupies a fixed-size slot in its column's array.  Values     $
+ * short enough to fit are stored within the slot itself.  Longer values    $
+ * are copied into an arena owned by the dataset - a chain of large blocks  $
+ * which is only released, all at once, when the dataset is finalized.     $
+ * Loading a dataset therefore does not allocate memory for each value.     $
+ *                                                                          $
+ * A column may instead be given a type, in which case its values are      $
+ * parsed when they are appended and held in their native form, eight      $
+ * bytes per row, with a bitmap recording which of them are NULL.  They    $
+ * are only formatted as text when they are retrieved for printing.        $
+ *                                                                          $
+ * A text column with few distinct values, such as one grouped on, may be  $
+ * dictionary-encoded.  Each distinct value is then stored once, and the    $
+ * column holds a 32-bit code for each row, so rows can be compared by     $
+ * code.                                                                    $
+ * $Id::                                                                    $
+ * ************************************************************************ */
+
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include "styleprintdataset.h"
+
+/**
+ * SECTION: styleprintdataset
+ * @Title: StylePrintDataset
+ * @Short_description: Columnar data storage for #StylePrintTable
+ * @See_also: #StylePrintTable
+ *
+ * #StylePrintDataset holds the data to be printed by #StylePrintTable.
+ * The data is stored by column: the dataset has a single schema listing
+ * the names of its columns, and each column keeps the values for all rows
+ * in one contiguous array.
+ *
+ * A dataset is built by declaring the columns with
+ * style_print_dataset_add_column() and then adding the rows with
+ * style_print_dataset_append_row().  Alternatively, a #GPtrArray of
+ * #GHashTable's - the format accepted by style_print_table_from_xmlfile()
+ * and friends - can be converted with
+ * style_print_dataset_new_from_ptr_array().
+ *
+ * Values are retrieved with style_print_dataset_get_value(), using the
+ * index of the column as returned by style_print_dataset_get_column_index().
+ * style_print_dataset_get_slice() also provides the length of the value,
+ * and may return it without a terminating null, which allows a subclass
+ * to return values directly from storage in which they are not
+ * null-terminated.
+ *
+ * A column added with style_print_dataset_add_typed_column() holds its
+ * values in their native form - as integers, doubles, dates, etc.  Values
+ * are still appended as text, and are parsed once, as they are added.
+ * style_print_dataset_get_native() retrieves a value in its native form,
+ * and style_print_value_compare() compares two such values, so that
+ * grouping and totals need not work on the text.  The text is only
+ * produced when style_print_dataset_get_value() asks for it.
+ *
+ * style_print_dataset_encode_column() dictionary-encodes a text column,
+ * storing each distinct value once.  style_print_dataset_get_codes() then
+ * provides the code for each row, and two rows of the column have the
+ * same value exactly when they have the same code.
+ *
+ * #StylePrintDataset is derivable.  A subclass may supply the rows from
+ * some other storage by overriding the get_n_rows and get_value virtual
+ * functions (and, where it can provide the length of a value cheaply,
+ * get_slice).  It then either declares its columns with
+ * style_print_dataset_add_column(), or also overrides the get_n_columns,
+ * get_column_name and get_column_index virtual functions to describe the
+ * schema of that storage.  If the values have types, it overrides
+ * get_column_type, and the values it returns as text are then parsed as
+ * required by style_print_dataset_get_native().
+ */
+
+#define DS_BLOCK_SIZE (64 * 1024)   // Default size of an arena block
+#define DS_SLOT_SIZE 16             // Size of a value slot
+#define DS_SLOT_EXT 0xff            // Tag for a slot pointing to the arena
+#define DS_FMT_RING 8               // Number of buffers for formatted values
+#define DS_FMT_SIZE 48              // Size of a buffer for a formatted value
+#define DS_EPOCH_JULIAN 719163      // GDate Julian day of 1970-01-01
+#define DS_USEC_PER_DAY G_GINT64_CONSTANT(86400000000)
+
+// A block of the string arena.  Blocks are chained from the most recent.
+typedef struct ds_block {
+    struct ds_block *next;
+    gsize size,                 // Bytes available in data[]
+          used;                 // Bytes allocated from data[]
+    gchar data[];
+} DSBLOCK;
+
+// The storage for a single value.  A value of up to DS_SLOT_SIZE - 2
+// bytes is stored in inl[], null-terminated, and the last byte (the tag)
+// holds its length, since the value may itself contain nulls.  Otherwise
+// the tag is DS_SLOT_EXT and ext points to the value in the arena
+// (ext.ptr is NULL for a NULL value).
+typedef union ds_slot {
+    gchar inl[DS_SLOT_SIZE];
+    struct {
+        const gchar *ptr;
+        guint32      len;
+    } ext;
+} DSSLOT;
+
+G_STATIC_ASSERT(sizeof (DSSLOT) == DS_SLOT_SIZE);
+
+#define DS_SLOT_TAG(slot) (((guchar *)(slot)->inl)[DS_SLOT_SIZE - 1])
+#define DS_SLOT_IS_EXT(slot) (DS_SLOT_TAG(slot) == DS_SLOT_EXT)
+
+// The storage for a single value of a typed column
+typedef union ds_num {
+    gint64  i;
+    gdouble d;
+} DSNUM;
+
+// A distinct value of a dictionary-encoded column (in the arena)
+typedef struct ds_key {
+    const gchar *ptr;           // The value, null-terminated
+    gsize        len;
+} DSKEY;
+
+// A single column of the dataset.  TEXT and NUMERIC values are held in
+// DSSLOT's, and values of other types in DSNUM's.  A dictionary-encoded
+// TEXT column instead holds a guint32 code for each row: 0 for NULL, or
+// one more than the index of the value in dictkeys.
+typedef struct ds_column {
+    gchar     *name;            // The column name (in the arena)
+    StylePrintColumnType type;
+    GArray    *values;          // The DSSLOT, DSNUM or code for each row
+    GArray    *nulls;           // For a DSNUM column, a bit for each row,
+                                // set if the value is NULL
+    GHashTable *dict;           // For a dictionary column, DSKEY => code
+    GPtrArray *dictkeys;        // The DSKEY for each code
+} DSCOLUMN;
+
+#define COL_IS_TEXT(c) (((c)->type == STYLE_PRINT_COLUMN_TEXT) || \
+                        ((c)->type == STYLE_PRINT_COLUMN_NUMERIC))
+
+typedef struct _StylePrintDatasetPrivate StylePrintDatasetPrivate;
+
+struct _StylePrintDatasetPrivate
+{
+    GPtrArray  *columns;        // DSCOLUMN's, in schema order
+    GHashTable *colindex;       // Column name => index + 1
+    guint       nrows;          // Count of rows appended
+    DSBLOCK    *arena;          // String storage for long values
+    gchar       fmtbuf[DS_FMT_RING][DS_FMT_SIZE];  // Formatted values
+    guint       fmtnext;        // The next fmtbuf to use
+};
+
+G_DEFINE_TYPE_WITH_PRIVATE(StylePrintDataset, style_print_dataset,
+                            G_TYPE_OBJECT)
+
+static guint ds_get_n_rows (StylePrintDataset *);
+static const gchar * ds_get_value (StylePrintDataset *, guint, guint);
+static const gchar * ds_get_slice (StylePrintDataset *, guint, guint,
+                                                        gsize *);
+static guint ds_get_n_columns (StylePrintDataset *);
+static const gchar * ds_get_column_name (StylePrintDataset *, guint);
+static gint ds_get_column_index (StylePrintDataset *, const gchar *);
+static StylePrintColumnType ds_get_column_type (StylePrintDataset *, guint);
+static void ds_get_native (StylePrintDataset *, guint, guint,
+                                                StylePrintValue *);
+
+static void
+free_column (DSCOLUMN *column)
+{
+    g_array_free (column->values, TRUE);
+
+    if (column->nulls)
+    {
+        g_array_free (column->nulls, TRUE);
+    }
+
+    if (column->dict)
+    {
+        g_hash_table_destroy (column->dict);
+        g_ptr_array_free (column->dictkeys, TRUE);
+    }
+
+    g_free (column);
+}
+
+/* ******************************************************************** *
+ * arena_alloc() - Allocate len bytes from the arena of the dataset.    *
+ *      A request that does not fit in the current block starts a new   *
+ *      one.  A request for more than a quarter of a block gets a block *
+ *      to itself, which is chained behind the current block so that    *
+ *      the space remaining in the current block is not abandoned.      *
+ * ******************************************************************** */
+
+static gchar *
+arena_alloc (StylePrintDatasetPrivate *priv, gsize len)
+{
+    DSBLOCK *blk = priv->arena;
+    gchar *mem;
+
+    if (!blk || (blk->size - blk->used < len))
+    {
+        gsize size = MAX(len, DS_BLOCK_SIZE);
+        DSBLOCK *newblk = g_malloc (sizeof (DSBLOCK) + size);
+
+        newblk->size = size;
+        newblk->used = 0;
+
+        if (blk && (len > DS_BLOCK_SIZE / 4))
+        {
+            newblk->next = blk->next;
+            blk->next = newblk;
+        }
+        else
+        {
+            newblk->next = blk;
+            priv->arena = newblk;
+        }
+
+        blk = newblk;
+    }
+
+    mem = blk->data + blk->used;
+    blk->used += len;
+    return mem;
+}
+
+/* ******************************************************************** *
+ * arena_alloc_aligned() - As arena_alloc(), for memory which is to     *
+ *      hold a structure rather than text.                              *
+ * ******************************************************************** */
+
+static gpointer
+arena_alloc_aligned (StylePrintDatasetPrivate *priv, gsize len)
+{
+    DSBLOCK *blk = priv->arena;
+
+    if (blk)
+    {
+        blk->used = MIN (blk->size, (blk->used + 7) & ~(gsize)7);
+    }
+
+    return arena_alloc (priv, len);
+}
+
+/* ******************************************************************** *
+ * arena_strndup() - Copy a string of len bytes into the arena, adding  *
+ *      the terminating null.                                           *
+ * ******************************************************************** */
+
+static gchar *
+arena_strndup (StylePrintDatasetPrivate *priv, const gchar *str, gsize len)
+{
+    gchar *copy = arena_alloc (priv, len + 1);
+
+    memcpy (copy, str, len);
+    copy[len] = '\0';
+    return copy;
+}
+
+/* ******************************************************************** *
+ * set_slot() - Store a value of len bytes (NULL for a NULL value) in a *
+ *      slot, either inline or in the arena.                            *
+ * ******************************************************************** */
+
+static void
+set_slot (StylePrintDatasetPrivate *priv, DSSLOT *slot, const gchar *value,
+                                                                gsize len)
+{
+    if (value && (len < DS_SLOT_SIZE - 1))
+    {
+        memset (slot->inl, 0, DS_SLOT_SIZE);
+        memcpy (slot->inl, value, len);
+        DS_SLOT_TAG(slot) = len;
+    }
+    else
+    {
+        slot->ext.ptr = value ? arena_strndup (priv, value, len) : NULL;
+        slot->ext.len = value ? len : 0;
+        DS_SLOT_TAG(slot) = DS_SLOT_EXT;
+    }
+}
+
+/* ******************************************************************** *
+ * numeric_split() - Split the text of a NUMERIC value into its sign,   *
+ *      integer digits (without leading zeros) and fraction digits.     *
+ *      Returns FALSE if the text is not a valid decimal number.        *
+ * ******************************************************************** */
+
+static gboolean
+numeric_split (const gchar *str, gsize len, gboolean *neg,
+                const gchar **ip, gsize *ilen, const gchar **fp, gsize *flen)
+{
+    const gchar *end = str + len;
+
+    *neg = FALSE;
+
+    if ((str < end) && ((*str == '-') || (*str == '+')))
+    {
+        *neg = (*str++ == '-');
+    }
+
+    *ip = str;
+
+    while ((str < end) && g_ascii_isdigit (*str))
+    {
+        ++str;
+    }
+
+    *ilen = str - *ip;
+    *fp = str;
+    *flen = 0;
+
+    if ((str < end) && (*str == '.'))
+    {
+        *fp = ++str;
+
+        while ((str < end) && g_ascii_isdigit (*str))
+        {
+            ++str;
+        }
+
+        *flen = str - *fp;
+    }
+
+    if ((str != end) || (*ilen + *flen == 0))
+    {
+        return FALSE;
+    }
+
+    while (*ilen && (**ip == '0'))
+    {
+        ++(*ip);
+        --(*ilen);
+    }
+
+    return TRUE;
+}
+
+#define NUMERIC_IS_NAN(s,l) (((l) == 3) && (memcmp (s, "NaN", 3) == 0))
+
+static gboolean
+numeric_valid (const gchar *str, gsize len)
+{
+    const gchar *ip, *fp;
+    gsize ilen, flen;
+    gboolean neg;
+
+    return NUMERIC_IS_NAN(str, len) ||
+                numeric_split (str, len, &neg, &ip, &ilen, &fp, &flen);
+}
+
+/* ******************************************************************** *
+ * numeric_compare() - Compare the text of two valid NUMERIC values     *
+ *      by their value.  As in PostgreSQL, NaN sorts after any number.  *
+ * ******************************************************************** */
+
+static gint
+numeric_compare (const gchar *a, gsize alen, const gchar *b, gsize blen)
+{
+    const gchar *aip, *afp, *bip, *bfp;
+    gsize ailen, aflen, bilen, bflen, idx;
+    gboolean aneg, bneg, azero, bzero;
+    gint cmp = 0;
+
+    if (NUMERIC_IS_NAN(a, alen) || NUMERIC_IS_NAN(b, blen))
+    {
+        return NUMERIC_IS_NAN(a, alen) - NUMERIC_IS_NAN(b, blen);
+    }
+
+    numeric_split (a, alen, &aneg, &aip, &ailen, &afp, &aflen);
+    numeric_split (b, blen, &bneg, &bip, &bilen, &bfp, &bflen);
+
+    // Compare the magnitudes
+    if (ailen != bilen)
+    {
+        cmp = (ailen > bilen) ? 1 : -1;
+    }
+    else if ((cmp = memcmp (aip, bip, ailen)) == 0)
+    {
+        for (idx = 0; !cmp && (idx < MAX (aflen, bflen)); idx++)
+        {
+            cmp = (idx < aflen ? afp[idx] : '0') -
+                  (idx < bflen ? bfp[idx] : '0');
+        }
+    }
+
+    cmp = (cmp > 0) - (cmp < 0);
+
+    if (aneg != bneg)
+    {
+        // Unless both are zero, the negative one is the lesser
+        for (azero = !ailen; azero && aflen; aflen--)
+        {
+            azero = (afp[aflen - 1] == '0');
+        }
+
+        for (bzero = !bilen; bzero && bflen; bflen--)
+        {
+            bzero = (bfp[bflen - 1] == '0');
+        }
+
+        return (azero && bzero) ? 0 : (aneg ? -1 : 1);
+    }
+
+    return aneg ? -cmp : cmp;
+}
+
+/* ******************************************************************** *
+ * parse_date() - Parse a date written as YYYY-MM-DD, setting "days" to *
+ *      the number of days since 1970-01-01.  Returns a pointer to the  *
+ *      text following the date, or NULL if there is no valid date.     *
+ * ******************************************************************** */
+
+static const gchar *
+parse_date (const gchar *str, gint64 *days)
+{
+    guint year, month, day;
+    gint used = 0;
+    GDate date;
+
+    if ((sscanf (str, "%4u-%2u-%2u%n", &year, &month, &day, &used) != 3) ||
+            !used || !g_date_valid_dmy (day, month, year))
+    {
+        return NULL;
+    }
+
+    g_date_clear (&date, 1);
+    g_date_set_dmy (&date, day, month, year);
+    *days = (gint64)g_date_get_julian (&date) - DS_EPOCH_JULIAN;
+    return str + used;
+}
+
+/* ******************************************************************** *
+ * parse_timestamp() - Parse a date and time, written as                *
+ *      YYYY-MM-DD HH:MM:SS[.ffffff], setting "usecs" to the number of  *
+ *      microseconds since 1970-01-01 00:00:00.  A date alone is taken  *
+ *      to be at midnight.                                              *
+ * ******************************************************************** */
+
+static gboolean
+parse_timestamp (const gchar *str, gint64 *usecs)
+{
+    guint hour = 0, min = 0, sec = 0, frac = 0, scale = 100000;
+    gint64 days;
+    gint used = 0;
+
+    if (!(str = parse_date (str, &days)))
+    {
+        return FALSE;
+    }
+
+    if ((*str == ' ') || (*str == 'T'))
+    {
+        if ((sscanf (str + 1, "%2u:%2u:%2u%n", &hour, &min, &sec, &used)
+                    != 3) || !used || (hour > 23) || (min > 59) || (sec > 59))
+        {
+            return FALSE;
+        }
+
+        str += used + 1;
+
+        if (*str == '.')
+        {
+            // Digits beyond microseconds are dropped
+            while (g_ascii_isdigit (*++str))
+            {
+                frac += (*str - '0') * scale;
+                scale /= 10;
+            }
+        }
+    }
+
+    *usecs = days * DS_USEC_PER_DAY +
+             ((hour * 60 + min) * 60 + sec) * G_GINT64_CONSTANT(1000000) +
+             frac;
+    return *str == '\0';
+}
+
+static const gchar *bool_true[] = {"t", "true", "y", "yes", "on", "1", NULL};
+static const gchar *bool_false[] = {"f", "false", "n", "no", "off", "0", NULL};
+
+static gboolean
+in_list (const gchar *str, const gchar **list)
+{
+    while (*list && g_ascii_strcasecmp (str, *list))
+    {
+        ++list;
+    }
+
+    return *list != NULL;
+}
+
+/* ******************************************************************** *
+ * parse_native() - Parse the "len" bytes at "str" (NULL for a NULL     *
+ *      value) as a value of the given type.  A value which is not      *
+ *      valid for the type is taken to be NULL.                         *
+ * ******************************************************************** */
+
+static void
+parse_native (StylePrintColumnType type, const gchar *str, gsize len,
+                                                    StylePrintValue *val)
+{
+    gchar buf[DS_FMT_SIZE];
+    gchar *end;
+
+    memset (val, 0, sizeof (*val));
+    val->type = type;
+    val->isnull = (str == NULL);
+
+    if (!str)
+    {
+        return;
+    }
+
+    if ((type == STYLE_PRINT_COLUMN_TEXT) ||
+            (type == STYLE_PRINT_COLUMN_NUMERIC))
+    {
+        if ((type == STYLE_PRINT_COLUMN_NUMERIC) && !numeric_valid (str, len))
+        {
+            val->isnull = TRUE;
+            return;
+        }
+
+        val->str = str;
+        val->len = len;
+        return;
+    }
+
+    // The text of any other type is short
+    if (len >= sizeof (buf))
+    {
+        val->isnull = TRUE;
+        return;
+    }
+
+    memcpy (buf, str, len);
+    buf[len] = '\0';
+    g_strstrip (buf);
+
+    switch (type)
+    {
+        case STYLE_PRINT_COLUMN_INT64:
+            errno = 0;
+            val->i = g_ascii_strtoll (buf, &end, 10);
+            val->isnull = errno || (end == buf) || *end;
+            break;
+        case STYLE_PRINT_COLUMN_DOUBLE:
+            val->d = g_ascii_strtod (buf, &end);
+            val->isnull = (end == buf) || *end;
+            break;
+        case STYLE_PRINT_COLUMN_BOOL:
+            if (in_list (buf, bool_true))
+            {
+                val->i = TRUE;
+            }
+            else if (!in_list (buf, bool_false))
+            {
+                val->isnull = TRUE;
+            }
+
+            break;
+        case STYLE_PRINT_COLUMN_DATE:
+            end = (gchar *)parse_date (buf, &val->i);
+            val->isnull = !end || *end;
+            break;
+        case STYLE_PRINT_COLUMN_TIMESTAMP:
+            val->isnull = !parse_timestamp (buf, &val->i);
+            break;
+        default:
+            val->isnull = TRUE;
+            break;
+    }
+}
+
+/* ******************************************************************** *
+ * format_native() - Write the text of a value other than TEXT or       *
+ *      NUMERIC into "buf", which is DS_FMT_SIZE bytes long.  Returns   *
+ *      the length of the text.                                         *
+ * ******************************************************************** */
+
+static gsize
+format_native (const StylePrintValue *val, gchar *buf)
+{
+    GDate date;
+    gint64 days, usecs;
+    gsize len;
+
+    switch (val->type)
+    {
+        case STYLE_PRINT_COLUMN_INT64:
+            return g_snprintf (buf, DS_FMT_SIZE, "%" G_GINT64_FORMAT, val->i);
+        case STYLE_PRINT_COLUMN_DOUBLE:
+            if (isnan (val->d))
+            {
+                return g_strlcpy (buf, "NaN", DS_FMT_SIZE);
+            }
+
+            if (isinf (val->d))
+            {
+                return g_strlcpy (buf, val->d > 0 ? "Infinity" : "-Infinity",
+                                                            DS_FMT_SIZE);
+            }
+
+            // The shortest form which reads back as the same value
+            g_ascii_formatd (buf, DS_FMT_SIZE, "%.15g", val->d);
+
+            if (g_ascii_strtod (buf, NULL) != val->d)
+            {
+                g_ascii_formatd (buf, DS_FMT_SIZE, "%.17g", val->d);
+            }
+
+            return strlen (buf);
+        case STYLE_PRINT_COLUMN_BOOL:
+            return g_strlcpy (buf, val->i ? "t" : "f", DS_FMT_SIZE);
+        case STYLE_PRINT_COLUMN_DATE:
+        case STYLE_PRINT_COLUMN_TIMESTAMP:
+            days = val->i;
+            usecs = 0;
+
+            if (val->type == STYLE_PRINT_COLUMN_TIMESTAMP)
+            {
+                days = val->i / DS_USEC_PER_DAY;
+                usecs = val->i % DS_USEC_PER_DAY;
+
+                if (usecs < 0)
+                {
+                    usecs += DS_USEC_PER_DAY;
+                    --days;
+                }
+            }
+
+            g_date_clear (&date, 1);
+            g_date_set_julian (&date, days + DS_EPOCH_JULIAN);
+            len = g_snprintf (buf, DS_FMT_SIZE, "%04u-%02u-%02u",
+                            g_date_get_year (&date), g_date_get_month (&date),
+                            g_date_get_day (&date));
+
+            if (val->type == STYLE_PRINT_COLUMN_TIMESTAMP)
+            {
+                gint64 secs = usecs / 1000000;
+
+                len += g_snprintf (buf + len, DS_FMT_SIZE - len,
+                                " %02u:%02u:%02u", (guint)(secs / 3600),
+                                (guint)(secs / 60 % 60), (guint)(secs % 60));
+
+                if (usecs % 1000000)
+                {
+                    len += g_snprintf (buf + len, DS_FMT_SIZE - len, ".%06u",
+                                            (guint)(usecs % 1000000));
+
+                    while (buf[len - 1] == '0')
+                    {
+                        buf[--len] = '\0';
+                    }
+                }
+            }
+
+            return len;
+        default:
+            buf[0] = '\0';
+            return 0;
+    }
+}
+
+/* ******************************************************************** *
+ * column_native() - Retrieve a value of a column held as DSNUM's.      *
+ * ******************************************************************** */
+
+static void
+column_native (DSCOLUMN *column, guint row, StylePrintValue *val)
+{
+    DSNUM *num = &g_array_index (column->values, DSNUM, row);
+
+    memset (val, 0, sizeof (*val));
+    val->type = column->type;
+    val->isnull = (g_array_index (column->nulls, guint32, row / 32) >>
+                                                            (row % 32)) & 1;
+
+    if (column->type == STYLE_PRINT_COLUMN_DOUBLE)
+    {
+        val->d = num->d;
+    }
+    else
+    {
+        val->i = num->i;
+    }
+}
+
+/* ******************************************************************** *
+ * column_format() - Format a value of a column held as DSNUM's, in the *
+ *      next of the dataset's buffers for formatted values.             *
+ * ******************************************************************** */
+
+static const gchar *
+column_format (StylePrintDatasetPrivate *priv, DSCOLUMN *column, guint row,
+                                                                gsize *len)
+{
+    StylePrintValue val;
+    gchar *buf;
+
+    column_native (column, row, &val);
+
+    if (val.isnull)
+    {
+        *len = 0;
+        return NULL;
+    }
+
+    buf = priv->fmtbuf[priv->fmtnext++ % DS_FMT_RING];
+    *len = format_native (&val, buf);
+    return buf;
+}
+
+/* ******************************************************************** *
+ * grow_column() - Extend a column to hold "nrows" rows.  The new rows  *
+ *      must then be set with store_value().                            *
+ * ******************************************************************** */
+
+static void
+grow_column (DSCOLUMN *column, guint nrows)
+{
+    g_array_set_size (column->values, nrows);
+
+    if (column->nulls)
+    {
+        g_array_set_size (column->nulls, (nrows + 31) / 32);
+    }
+}
+
+/* ******************************************************************** *
+ * key_hash(), key_equal() - Hash and compare DSKEY's.  Values may hold *
+ *      nulls, so their lengths are used rather than g_str_hash().      *
+ * ******************************************************************** */
+
+static guint
+key_hash (gconstpointer k)
+{
+    const DSKEY *key = k;
+    guint hash = 5381;
+    gsize idx;
+
+    for (idx = 0; idx < key->len; idx++)
+    {
+        hash = (hash << 5) + hash + (guchar)key->ptr[idx];
+    }
+
+    return hash;
+}
+
+static gboolean
+key_equal (gconstpointer a, gconstpointer b)
+{
+    const DSKEY *ka = a,
+                *kb = b;
+
+    return (ka->len == kb->len) && (memcmp (ka->ptr, kb->ptr, ka->len) == 0);
+}
+
+/* ******************************************************************** *
+ * dict_code() - Return the code for a value of a dictionary column,    *
+ *      adding the value to the dictionary if it is new.  If "stored"   *
+ *      is given, it is a copy of the value already in the arena, which *
+ *      is used rather than making another.                             *
+ * ******************************************************************** */
+
+static guint32
+dict_code (StylePrintDatasetPrivate *priv, DSCOLUMN *column,
+                const gchar *value, gsize len, const gchar *stored)
+{
+    DSKEY probe,
+          *key;
+    gpointer code;
+
+    if (!value)
+    {
+        return 0;
+    }
+
+    probe.ptr = value;
+    probe.len = len;
+
+    if ((code = g_hash_table_lookup (column->dict, &probe)))
+    {
+        return GPOINTER_TO_UINT(code);
+    }
+
+    key = arena_alloc_aligned (priv, sizeof (DSKEY));
+    key->ptr = stored ? stored : arena_strndup (priv, value, len);
+    key->len = len;
+    g_ptr_array_add (column->dictkeys, key);
+    g_hash_table_insert (column->dict, key,
+                            GUINT_TO_POINTER(column->dictkeys->len));
+    return column->dictkeys->len;
+}
+
+/* ******************************************************************** *
+ * store_value() - Store a value of len bytes (NULL for a NULL value)   *
+ *      as row number "row" of a column, parsing it if the column has a *
+ *      type.                                                           *
+ * ******************************************************************** */
+
+static void
+store_value (StylePrintDatasetPrivate *priv, DSCOLUMN *column, guint row,
+                                            const gchar *value, gsize len)
+{
+    StylePrintValue val;
+    DSNUM *num;
+    guint32 *word;
+
+    if (column->dict)
+    {
+        g_array_index (column->values, guint32, row) =
+                                dict_code (priv, column, value, len, NULL);
+        return;
+    }
+
+    if (COL_IS_TEXT(column))
+    {
+        if (value && (column->type == STYLE_PRINT_COLUMN_NUMERIC) &&
+                !numeric_valid (value, len))
+        {
+            value = NULL;
+        }
+
+        set_slot (priv, &g_array_index (column->values, DSSLOT, row),
+                                                            value, len);
+        return;
+    }
+
+    parse_native (column->type, value, len, &val);
+    num = &g_array_index (column->values, DSNUM, row);
+    word = &g_array_index (column->nulls, guint32, row / 32);
+
+    if (column->type == STYLE_PRINT_COLUMN_DOUBLE)
+    {
+        num->d = val.d;
+    }
+    else
+    {
+        num->i = val.i;
+    }
+
+    if (val.isnull)
+    {
+        *word |= 1u << (row % 32);
+    }
+    else
+    {
+        *word &= ~(1u << (row % 32));
+    }
+}
+
+static void
+style_print_dataset_init (StylePrintDataset *self)
+{
+    StylePrintDatasetPrivate *priv =
+                style_print_dataset_get_instance_private (self);
+
+    priv->columns = g_ptr_array_new_with_free_func (
+                                (GDestroyNotify)free_column);
+    priv->colindex = g_hash_table_new (g_str_hash, g_str_equal);
+    priv->nrows = 0;
+    priv->arena = NULL;
+    priv->fmtnext = 0;
+}
+
+static void
+style_print_dataset_finalize (GObject *object)
+{
+    StylePrintDatasetPrivate *priv = style_print_dataset_get_instance_private (
+                                            STYLE_PRINT_DATASET(object));
+
+    // The keys of colindex are in the arena, so free it first
+    g_hash_table_destroy (priv->colindex);
+    g_ptr_array_free (priv->columns, TRUE);
+
+    while (priv->arena)
+    {
+        DSBLOCK *next = priv->arena->next;
+
+        g_free (priv->arena);
+        priv->arena = next;
+    }
+
+    G_OBJECT_CLASS(style_print_dataset_parent_class)->finalize (object);
+}
+
+static void
+style_print_dataset_class_init (StylePrintDatasetClass *class)
+{
+    GObjectClass *gobject_class = (GObjectClass *) class;
+
+    gobject_class->finalize = style_print_dataset_finalize;
+
+    class->get_n_rows = ds_get_n_rows;
+    class->get_value = ds_get_value;
+    class->get_slice = ds_get_slice;
+    class->get_n_columns = ds_get_n_columns;
+    class->get_column_name = ds_get_column_name;
+    class->get_column_index = ds_get_column_index;
+    class->get_column_type = ds_get_column_type;
+    class->get_native = ds_get_native;
+}
+
+/* ******************************************************************** *
+ * ds_get_n_rows(), ds_get_value(), etc - The default implementations   *
+ *      of the virtual functions, reading from the column arrays.       *
+ * ******************************************************************** */
+
+static guint
+ds_get_n_rows (StylePrintDataset *self)
+{
+    StylePrintDatasetPrivate *priv =
+                style_print_dataset_get_instance_private (self);
+
+    return priv->nrows;
+}
+
+static const gchar *
+ds_get_value (StylePrintDataset *self, guint row, guint col)
+{
+    StylePrintDatasetPrivate *priv =
+                style_print_dataset_get_instance_private (self);
+    DSCOLUMN *column = g_ptr_array_index (priv->columns, col);
+    DSSLOT *slot;
+    gsize len;
+
+    if (!COL_IS_TEXT(column))
+    {
+        return column_format (priv, column, row, &len);
+    }
+
+    if (column->dict)
+    {
+        return ds_get_slice (self, row, col, &len);
+    }
+
+    slot = &g_array_index (column->values, DSSLOT, row);
+    return DS_SLOT_IS_EXT(slot) ? slot->ext.ptr : slot->inl;
+}
+
+static const gchar *
+ds_get_slice (StylePrintDataset *self, guint row, guint col, gsize *len)
+{
+    StylePrintDatasetPrivate *priv =
+                style_print_dataset_get_instance_private (self);
+    DSCOLUMN *column;
+    DSSLOT *slot;
+
+    // A subclass which reads its values from elsewhere, but does not
+    // override get_slice.
+    if (STYLE_PRINT_DATASET_GET_CLASS(self)->get_value != ds_get_value)
+    {
+        const gchar *val = STYLE_PRINT_DATASET_GET_CLASS(self)->get_value (
+                                                            self, row, col);
+
+        *len = val ? strlen (val) : 0;
+        return val;
+    }
+
+    column = g_ptr_array_index (priv->columns, col);
+
+    if (!COL_IS_TEXT(column))
+    {
+        return column_format (priv, column, row, len);
+    }
+
+    if (column->dict)
+    {
+        guint32 code = g_array_index (column->values, guint32, row);
+        DSKEY *key;
+
+        if (!code)
+        {
+            *len = 0;
+            return NULL;
+        }
+
+        key = g_ptr_array_index (column->dictkeys, code - 1);
+        *len = key->len;
+        return key->ptr;
+    }
+
+    slot = &g_array_index (column->values, DSSLOT, row);
+
+    if (DS_SLOT_IS_EXT(slot))
+    {
+        *len = slot->ext.len;
+        return slot->ext.ptr;
+    }
+
+    *len = DS_SLOT_TAG(slot);
+    return slot->inl;
+}
+
+static guint
+ds_get_n_columns (StylePrintDataset *self)
+{
+    StylePrintDatasetPrivate *priv =
+                style_print_dataset_get_instance_private (self);
+
+    return priv->columns->len;
+}
+
+static const gchar *
+ds_get_column_name (StylePrintDataset *self, guint col)
+{
+    StylePrintDatasetPrivate *priv =
+                style_print_dataset_get_instance_private (self);
+
+    if (col >= priv->columns->len)
+    {
+        return NULL;
+    }
+
+    return ((DSCOLUMN *)g_ptr_array_index (priv->columns, col))->name;
+}
+
+static gint
+ds_get_column_index (StylePrintDataset *self, const gchar *name)
+{
+    StylePrintDatasetPrivate *priv =
+                style_print_dataset_get_instance_private (self);
+
+    return GPOINTER_TO_INT(g_hash_table_lookup (priv->colindex, name)) - 1;
+}
+
+static StylePrintColumnType
+ds_get_column_type (StylePrintDataset *self, guint col)
+{
+    StylePrintDatasetPrivate *priv =
+                style_print_dataset_get_instance_private (self);
+
+    // A subclass reading its values from elsewhere provides text, unless
+    // it says otherwise.
+    if ((STYLE_PRINT_DATASET_GET_CLASS(self)->get_value != ds_get_value) ||
+            (col >= priv->columns->len))
+    {
+        return STYLE_PRINT_COLUMN_TEXT;
+    }
+
+    return ((DSCOLUMN *)g_ptr_array_index (priv->columns, col))->type;
+}
+
+static void
+ds_get_native (StylePrintDataset *self, guint row, guint col,
+                                        StylePrintValue *val)
+{
+    StylePrintDatasetPrivate *priv =
+                style_print_dataset_get_instance_private (self);
+    StylePrintDatasetClass *class = STYLE_PRINT_DATASET_GET_CLASS(self);
+    DSCOLUMN *column;
+    const gchar *str;
+    gsize len;
+
+    // A subclass's values are parsed from their text.  Text which is not
+    // valid for the type (a date in a format other than ISO, say) is
+    // left as text, so that distinct values do not all become NULL.
+    if (class->get_value != ds_get_value)
+    {
+        str = class->get_slice (self, row, col, &len);
+        parse_native (class->get_column_type (self, col), str, len, val);
+
+        if (str && val->isnull)
+        {
+            parse_native (STYLE_PRINT_COLUMN_TEXT, str, len, val);
+        }
+
+        return;
+    }
+
+    column = g_ptr_array_index (priv->columns, col);
+
+    if (!COL_IS_TEXT(column))
+    {
+        column_native (column, row, val);
+        return;
+    }
+
+    str = ds_get_slice (self, row, col, &len);
+    memset (val, 0, sizeof (*val));
+    val->type = column->type;
+    val->isnull = (str == NULL);
+    val->str = str;
+    val->len = len;
+}
+
+/**
+ * style_print_dataset_new:
+ *
+ * Creates a new, empty #StylePrintDataset.  Columns are then declared with
+ * style_print_dataset_add_column() and rows added with
+ * style_print_dataset_append_row().
+ *
+ * Returns: (transfer full): A new #StylePrintDataset
+ */
+
+StylePrintDataset *
+style_print_dataset_new (void)
+{
+    return g_object_new (STYLE_PRINT_TYPE_DATASET, NULL);
+}
+
+/**
+ * style_print_dataset_add_column:
+ * @self: The #StylePrintDataset
+ * @name: The name of the column
+ *
+ * Appends a column of type %STYLE_PRINT_COLUMN_TEXT to the schema of the
+ * dataset.  If rows have already been added, the new column is empty
+ * (NULL) for each of these rows.
+ *
+ * Returns: The index of the column, or the index of the existing column
+ * if a column of that name is already present.
+ */
+
+gint
+style_print_dataset_add_column (StylePrintDataset *self, const gchar *name)
+{
+    return style_print_dataset_add_typed_column (self, name,
+                                        STYLE_PRINT_COLUMN_TEXT);
+}
+
+/**
+ * style_print_dataset_add_typed_column:
+ * @self: The #StylePrintDataset
+ * @name: The name of the column
+ * @type: The type of the values in the column
+ *
+ * Appends a column of the given type to the schema of the dataset.  Values
+ * are still appended as text, and are parsed as they are added.  A value
+ * which is not valid for the type is stored as NULL.  Otherwise this is
+ * the same as style_print_dataset_add_column().
+ *
+ * Returns: The index of the column, or the index of the existing column
+ * (whatever its type) if a column of that name is already present.
+ */
+
+gint
+style_print_dataset_add_typed_column (StylePrintDataset *self,
+                                            const gchar *name,
+                                   StylePrintColumnType  type)
+{
+    StylePrintDatasetPrivate *priv;
+    DSCOLUMN *column;
+    gint idx;
+
+    g_return_val_if_fail (STYLE_PRINT_IS_DATASET(self), -1);
+    g_return_val_if_fail (name != NULL, -1);
+
+    priv = style_print_dataset_get_instance_private (self);
+
+    if ((idx = ds_get_column_index (self, name)) >= 0)
+    {
+        return idx;
+    }
+
+    column = g_malloc0 (sizeof (DSCOLUMN));
+    column->name = arena_strndup (priv, name, strlen (name));
+    column->type = type;
+
+    if (COL_IS_TEXT(column))
+    {
+        column->values = g_array_sized_new (FALSE, FALSE, sizeof (DSSLOT),
+                                                            priv->nrows);
+    }
+    else
+    {
+        column->values = g_array_sized_new (FALSE, FALSE, sizeof (DSNUM),
+                                                            priv->nrows);
+        column->nulls = g_array_new (FALSE, TRUE, sizeof (guint32));
+    }
+
+    grow_column (column, priv->nrows);
+
+    for (idx = 0; idx < priv->nrows; idx++)
+    {
+        store_value (priv, column, idx, NULL, 0);
+    }
+
+    g_ptr_array_add (priv->columns, column);
+    idx = priv->columns->len - 1;
+    g_hash_table_insert (priv->colindex, column->name,
+                                            GINT_TO_POINTER(idx + 1));
+
+    return idx;
+}
+
+/**
+ * style_print_dataset_get_n_columns:
+ * @self: The #StylePrintDataset
+ *
+ * Returns: The number of columns in the schema
+ */
+
+guint
+style_print_dataset_get_n_columns (StylePrintDataset *self)
+{
+    g_return_val_if_fail (STYLE_PRINT_IS_DATASET(self), 0);
+
+    return STYLE_PRINT_DATASET_GET_CLASS(self)->get_n_columns (self);
+}
+
+/**
+ * style_print_dataset_get_column_name:
+ * @self: The #StylePrintDataset
+ * @col: The column index
+ *
+ * Returns: (nullable): The name of the column, or NULL if @col is out
+ * of range.
+ */
+
+const gchar *
+style_print_dataset_get_column_name (StylePrintDataset *self, guint col)
+{
+    g_return_val_if_fail (STYLE_PRINT_IS_DATASET(self), NULL);
+
+    return STYLE_PRINT_DATASET_GET_CLASS(self)->get_column_name (self, col);
+}
+
+/**
+ * style_print_dataset_get_column_type:
+ * @self: The #StylePrintDataset
+ * @col: The column index
+ *
+ * Returns: The type of the column.  A column of a subclass which does not
+ * describe its types is %STYLE_PRINT_COLUMN_TEXT.
+ */
+
+StylePrintColumnType
+style_print_dataset_get_column_type (StylePrintDataset *self, guint col)
+{
+    g_return_val_if_fail (STYLE_PRINT_IS_DATASET(self),
+                                        STYLE_PRINT_COLUMN_TEXT);
+
+    return STYLE_PRINT_DATASET_GET_CLASS(self)->get_column_type (self, col);
+}
+
+/**
+ * style_print_dataset_encode_column:
+ * @self: The #StylePrintDataset
+ * @col: The column index
+ *
+ * Dictionary-encodes a column of type %STYLE_PRINT_COLUMN_TEXT: each
+ * distinct value is stored once, and the column holds a code for each
+ * row.  This suits a column with few distinct values, such as one which
+ * the printout is grouped on.  Any rows already added are converted, and
+ * rows appended later are encoded as they are added, so it is best done
+ * before the rows are added.  The values retrieved are unchanged.
+ *
+ * Only columns stored by #StylePrintDataset itself can be encoded, not
+ * those of a subclass which reads its values from elsewhere.
+ *
+ * Returns: TRUE if the column is now dictionary-encoded
+ */
+
+gboolean
+style_print_dataset_encode_column (StylePrintDataset *self, guint col)
+{
+    StylePrintDatasetPrivate *priv;
+    DSCOLUMN *column;
+    GArray *codes;
+    guint row;
+
+    g_return_val_if_fail (STYLE_PRINT_IS_DATASET(self), FALSE);
+
+    priv = style_print_dataset_get_instance_private (self);
+
+    if ((STYLE_PRINT_DATASET_GET_CLASS(self)->get_value != ds_get_value) ||
+            (col >= priv->columns->len))
+    {
+        return FALSE;
+    }
+
+    column = g_ptr_array_index (priv->columns, col);
+
+    if (column->dict)
+    {
+        return TRUE;
+    }
+
+    if (column->type != STYLE_PRINT_COLUMN_TEXT)
+    {
+        return FALSE;
+    }
+
+    column->dict = g_hash_table_new (key_hash, key_equal);
+    column->dictkeys = g_ptr_array_new ();
+    codes = g_array_sized_new (FALSE, FALSE, sizeof (guint32), priv->nrows);
+    g_array_set_size (codes, priv->nrows);
+
+    // A long value is already in the arena, so the dictionary uses that
+    // copy.  Only short values stored within their slots are copied.
+    for (row = 0; row < priv->nrows; row++)
+    {
+        DSSLOT *slot = &g_array_index (column->values, DSSLOT, row);
+        guint32 code;
+
+        if (DS_SLOT_IS_EXT(slot))
+        {
+            code = dict_code (priv, column, slot->ext.ptr, slot->ext.len,
+                                                        slot->ext.ptr);
+        }
+        else
+        {
+            code = dict_code (priv, column, slot->inl, DS_SLOT_TAG(slot),
+                                                                NULL);
+        }
+
+        g_array_index (codes, guint32, row) = code;
+    }
+
+    g_array_free (column->values, TRUE);
+    column->values = codes;
+    return TRUE;
+}
+
+/**
+ * style_print_dataset_get_codes:
+ * @self: The #StylePrintDataset
+ * @col: The column index
+ *
+ * Provides the codes of a dictionary-encoded column, one for each row.
+ * Two rows have the same value exactly when they have the same code, and
+ * a NULL value has the code 0.  The codes are only meaningful within
+ * this dataset.
+ *
+ * Returns: (nullable) (transfer none): The array of codes, which is valid
+ * until the next row is appended, or NULL if the column is not
+ * dictionary-encoded.
+ */
+
+const guint32 *
+style_print_dataset_get_codes (StylePrintDataset *self, guint col)
+{
+    StylePrintDatasetPrivate *priv;
+    DSCOLUMN *column;
+
+    g_return_val_if_fail (STYLE_PRINT_IS_DATASET(self), NULL);
+
+    priv = style_print_dataset_get_instance_private (self);
+
+    if ((STYLE_PRINT_DATASET_GET_CLASS(self)->get_value != ds_get_value) ||
+            (col >= priv->columns->len))
+    {
+        return NULL;
+    }
+
+    column = g_ptr_array_index (priv->columns, col);
+    return column->dict ? (const guint32 *)column->values->data : NULL;
+}
+
+/**
+ * style_print_dataset_get_column_index:
+ * @self: The #StylePrintDataset
+ * @name: The name of the column
+ *
+ * Looks up a column in the schema.  This is intended to be done once,
+ * before the data is accessed, rather than for each value retrieved.
+ *
+ * Returns: The index of the column, or -1 if there is no such column.
+ */
+
+gint
+style_print_dataset_get_column_index (StylePrintDataset *self,
+                                            const gchar *name)
+{
+    g_return_val_if_fail (STYLE_PRINT_IS_DATASET(self), -1);
+
+    if (!name)
+    {
+        return -1;
+    }
+
+    return STYLE_PRINT_DATASET_GET_CLASS(self)->get_column_index (self, name);
+}
+
+/**
+ * style_print_dataset_append_row_with_lengths:
+ * @self: The #StylePrintDataset
+ * @values: (array) (element-type utf8) (nullable): The values for each
+ * column, in schema order.  There must be one entry for each column, any
+ * of which may be NULL.
+ * @lengths: (array) (nullable): The length in bytes of each value, or NULL
+ * to have the lengths determined with strlen().
+ *
+ * Appends a row to the dataset.  The values are copied into storage owned
+ * by the dataset.  The values need not be null-terminated when @lengths
+ * is given.
+ */
+
+void
+style_print_dataset_append_row_with_lengths (StylePrintDataset *self,
+                                                   const gchar **values,
+                                                   const gsize  *lengths)
+{
+    StylePrintDatasetPrivate *priv;
+    guint col;
+
+    g_return_if_fail (STYLE_PRINT_IS_DATASET(self));
+
+    priv = style_print_dataset_get_instance_private (self);
+
+    for (col = 0; col < priv->columns->len; col++)
+    {
+        DSCOLUMN *column = g_ptr_array_index (priv->columns, col);
+        const gchar *val = values ? values[col] : NULL;
+
+        grow_column (column, priv->nrows + 1);
+        store_value (priv, column, priv->nrows, val,
+                    val ? (lengths ? lengths[col] : strlen (val)) : 0);
+    }
+
+    ++(priv->nrows);
+}
+
+/**
+ * style_print_dataset_append_row:
+ * @self: The #StylePrintDataset
+ * @values: (array) (element-type utf8) (nullable): The values for each
+ * column, in schema order.  There must be one entry for each column, any
+ * of which may be NULL.
+ *
+ * Appends a row to the dataset.  The values are copied.
+ */
+
+void
+style_print_dataset_append_row (StylePrintDataset *self, const gchar **values)
+{
+    style_print_dataset_append_row_with_lengths (self, values, NULL);
+}
+
+/**
+ * style_print_dataset_get_n_rows:
+ * @self: The #StylePrintDataset
+ *
+ * Returns: The number of rows in the dataset
+ */
+
+guint
+style_print_dataset_get_n_rows (StylePrintDataset *self)
+{
+    g_return_val_if_fail (STYLE_PRINT_IS_DATASET(self), 0);
+
+    return STYLE_PRINT_DATASET_GET_CLASS(self)->get_n_rows (self);
+}
+
+/**
+ * style_print_dataset_get_value:
+ * @self: The #StylePrintDataset
+ * @row: The row number
+ * @col: The column index
+ *
+ * Retrieves a single value.  No range checking is done on @row or @col,
+ * as this is called for every cell that is printed.
+ *
+ * The value returned may be stored within the column itself, so it is
+ * only valid until the next row is appended to the dataset.  The value of
+ * a typed column is formatted when it is requested, into one of a small
+ * number of buffers which the dataset reuses in turn, so it should be
+ * used (or copied) at once.
+ *
+ * Returns: (nullable): The value, which belongs to the dataset.
+ */
+
+const gchar *
+style_print_dataset_get_value (StylePrintDataset *self, guint row, guint col)
+{
+    return STYLE_PRINT_DATASET_GET_CLASS(self)->get_value (self, row, col);
+}
+
+/**
+ * style_print_dataset_get_slice:
+ * @self: The #StylePrintDataset
+ * @row: The row number
+ * @col: The column index
+ * @len: (out): Return location for the length of the value in bytes
+ *
+ * Retrieves a single value and its length.  Unlike
+ * style_print_dataset_get_value(), the value returned need not be
+ * null-terminated, so that a subclass can return it directly from the
+ * storage it reads.  No range checking is done on @row or @col.
+ *
+ * Returns: (nullable) (array length=len): The value, which belongs to the
+ * dataset.
+ */
+
+const gchar *
+style_print_dataset_get_slice (StylePrintDataset *self, guint row,
+                                            guint col, gsize *len)
+{
+    return STYLE_PRINT_DATASET_GET_CLASS(self)->get_slice (self, row, col,
+                                                                    len);
+}
+
+/**
+ * style_print_dataset_get_native:
+ * @self: The #StylePrintDataset
+ * @row: The row number
+ * @col: The column index
+ * @value: (out caller-allocates): Return location for the value
+ *
+ * Retrieves a single value in its native form, according to the type of
+ * its column.  As with style_print_dataset_get_value(), no range checking
+ * is done on @row or @col.
+ *
+ * Where a subclass provides the values as text, a value which cannot be
+ * parsed as the type of its column is returned as
+ * %STYLE_PRINT_COLUMN_TEXT.
+ */
+
+void
+style_print_dataset_get_native (StylePrintDataset *self, guint row,
+                                guint col, StylePrintValue *value)
+{
+    STYLE_PRINT_DATASET_GET_CLASS(self)->get_native (self, row, col, value);
+}
+
+/**
+ * style_print_value_compare:
+ * @a: A #StylePrintValue
+ * @b: Another #StylePrintValue
+ *
+ * Compares two values retrieved with style_print_dataset_get_native().
+ * NULL sorts before any other value.  Numbers, dates and timestamps are
+ * compared by value, and text byte by byte.  Values of different types
+ * are ordered by their type.
+ *
+ * Returns: A negative value if @a sorts before @b, zero if they are equal,
+ * or a positive value if @a sorts after @b.
+ */
+
+gint
+style_print_value_compare (const StylePrintValue *a, const StylePrintValue *b)
+{
+    gint cmp;
+
+    if (a->isnull || b->isnull)
+    {
+        return b->isnull - a->isnull;
+    }
+
+    if (a->type != b->type)
+    {
+        return (a->type < b->type) ? -1 : 1;
+    }
+
+    switch (a->type)
+    {
+        case STYLE_PRINT_COLUMN_TEXT:
+            if ((cmp = memcmp (a->str, b->str, MIN (a->len, b->len))))
+            {
+                return (cmp < 0) ? -1 : 1;
+            }
+
+            return (a->len > b->len) - (a->len < b->len);
+        case STYLE_PRINT_COLUMN_NUMERIC:
+            return numeric_compare (a->str, a->len, b->str, b->len);
+        case STYLE_PRINT_COLUMN_DOUBLE:
+            // As in PostgreSQL, NaN sorts after any number
+            if (isnan (a->d) || isnan (b->d))
+            {
+                return !!isnan (a->d) - !!isnan (b->d);
+            }
+
+            return (a->d > b->d) - (a->d < b->d);
+        default:
+            return (a->i > b->i) - (a->i < b->i);
+    }
+}
+
+/**
+ * style_print_dataset_lookup:
+ * @self: The #StylePrintDataset
+ * @row: The row number
+ * @colname: The name of the column
+ *
+ * Retrieves a single value, looking the column up by name.  Where many
+ * values are to be retrieved, it is more efficient to look up the column
+ * index once with style_print_dataset_get_column_index().
+ *
+ * Returns: (nullable): The value, or NULL if there is no such column.
+ */
+
+const gchar *
+style_print_dataset_lookup (StylePrintDataset *self, guint row,
+                                        const gchar *colname)
+{
+    gint col = style_print_dataset_get_column_index (self, colname);
+
+    if ((col < 0) || (row >= style_print_dataset_get_n_rows (self)))
+    {
+        return NULL;
+    }
+
+    return style_print_dataset_get_value (self, row, col);
+}
+
+/**
+ * style_print_dataset_new_from_ptr_array:
+ * @data: (element-type GHashTable): A #GPtrArray of #GHashTable's, each
+ * of which represents one row, keyed by column name.
+ *
+ * Converts data in the row-per-#GHashTable form accepted by
+ * style_print_table_from_xmlfile() into a #StylePrintDataset.  The schema
+ * is made up of every key found in any of the rows.  A row which does not
+ * contain a given key has a NULL value for that column.
+ *
+ * Returns: (transfer full): A new #StylePrintDataset
+ */
+
+StylePrintDataset *
+style_print_dataset_new_from_ptr_array (GPtrArray *data)
+{
+    StylePrintDataset *self = style_print_dataset_new ();
+    StylePrintDatasetPrivate *priv =
+                style_print_dataset_get_instance_private (self);
+    guint row;
+
+    if (!data)
+    {
+        return self;
+    }
+
+    for (row = 0; row < data->len; row++)
+    {
+        GHashTableIter iter;
+        gpointer key,
+                 val;
+        guint col;
+
+        // Extend each column by one empty slot, then fill in the slots
+        // for the keys present in this row.
+        for (col = 0; col < priv->columns->len; col++)
+        {
+            DSCOLUMN *column = g_ptr_array_index (priv->columns, col);
+
+            grow_column (column, row + 1);
+            store_value (priv, column, row, NULL, 0);
+        }
+
+        ++(priv->nrows);
+        g_hash_table_iter_init (&iter, g_ptr_array_index (data, row));
+
+        while (g_hash_table_iter_next (&iter, &key, &val))
+        {
+            DSCOLUMN *column;
+
+            // A NULL value is kept as a null slot
+            column = g_ptr_array_index (priv->columns,
+                            style_print_dataset_add_column (self, key));
+            store_value (priv, column, row, val, val ? strlen (val) : 0);
+        }
+    }
+
+    return self;
+}
@@ -0,0 +1,170 @@
+/*
+Copyright (c) 2017 David Breeding
+
+This file is part of tableprint.
+
+tableprint is free software: you can redistribute it and/or modify
+it under the terms of the Lesser GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+tableprint is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with tableprint (see the files "COPYING" and "COPYING.LESSER").
+If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* ************************************************************************ *
+ * styleprintdataset.h - Header file for StylePrintDataset, the columnar    *
+ * data container consumed by StylePrintTable                               *
+ * ************************************************************************ */
+
+#ifndef __STYLE_PRINT_DATASET_H
+#define __STYLE_PRINT_DATASET_H
+
+#ifdef _cplusplus
+extern "C"
+{       //}     // To make vim quit trying to indent...
+#endif
+
+#include <glib-object.h>
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+#define STYLE_PRINT_TYPE_DATASET (style_print_dataset_get_type())
+
+/**
+ * StylePrintColumnType:
+ * @STYLE_PRINT_COLUMN_TEXT: Text
+ * @STYLE_PRINT_COLUMN_INT64: A 64-bit integer
+ * @STYLE_PRINT_COLUMN_DOUBLE: A double-precision floating point number
+ * @STYLE_PRINT_COLUMN_NUMERIC: A decimal number of arbitrary precision,
+ * kept as its text
+ * @STYLE_PRINT_COLUMN_DATE: A date, written as YYYY-MM-DD
+ * @STYLE_PRINT_COLUMN_TIMESTAMP: A date and time without time zone,
+ * written as YYYY-MM-DD HH:MM:SS, with optional fractional seconds
+ * @STYLE_PRINT_COLUMN_BOOL: A boolean, written as "t" or "f"
+ *
+ */
+
+typedef enum {
+    STYLE_PRINT_COLUMN_TEXT,
+    STYLE_PRINT_COLUMN_INT64,
+    STYLE_PRINT_COLUMN_DOUBLE,
+    STYLE_PRINT_COLUMN_NUMERIC,
+    STYLE_PRINT_COLUMN_DATE,
+    STYLE_PRINT_COLUMN_TIMESTAMP,
+    STYLE_PRINT_COLUMN_BOOL
+} StylePrintColumnType;
+
+/**
+ * StylePrintValue:
+ * @type: The type of the column the value came from
+ * @isnull: TRUE for a NULL value, in which case no other member is set
+ * @i: The value of an INT64 or BOOL column, the number of days since
+ * 1970-01-01 for a DATE, or of microseconds since 1970-01-01 00:00:00
+ * for a TIMESTAMP
+ * @d: The value of a DOUBLE column
+ * @str: The value of a TEXT or NUMERIC column, which need not be
+ * null-terminated
+ * @len: The length of @str in bytes
+ *
+ * A single value in its native form, as retrieved with
+ * style_print_dataset_get_native().
+ */
+
+typedef struct {
+    StylePrintColumnType type;
+    gboolean     isnull;
+    gint64       i;
+    gdouble      d;
+    const gchar *str;
+    gsize        len;
+} StylePrintValue;
+
+G_DECLARE_DERIVABLE_TYPE(StylePrintDataset, style_print_dataset, STYLE_PRINT, DATASET, GObject)
+
+struct _StylePrintDatasetClass
+{
+    GObjectClass parent_class;
+
+    guint         (*get_n_rows) (StylePrintDataset *self);
+    const gchar * (*get_value)  (StylePrintDataset *self,
+                                             guint  row,
+                                             guint  col);
+
+    guint         (*get_n_columns)    (StylePrintDataset *self);
+    const gchar * (*get_column_name)  (StylePrintDataset *self,
+                                                   guint  col);
+    gint          (*get_column_index) (StylePrintDataset *self,
+                                             const gchar *name);
+
+    const gchar * (*get_slice)  (StylePrintDataset *self,
+                                             guint  row,
+                                             guint  col,
+                                             gsize *len);
+
+    StylePrintColumnType (*get_column_type) (StylePrintDataset *self,
+                                                         guint  col);
+    void          (*get_native) (StylePrintDataset *self,
+                                             guint  row,
+                                             guint  col,
+                                   StylePrintValue *value);
+};
+
+StylePrintDataset *style_print_dataset_new (void);
+StylePrintDataset *style_print_dataset_new_from_ptr_array (GPtrArray *data);
+
+gint style_print_dataset_add_column (StylePrintDataset *self,
+                                           const gchar *name);
+gint style_print_dataset_add_typed_column (StylePrintDataset *self,
+                                                 const gchar *name,
+                                        StylePrintColumnType  type);
+gboolean style_print_dataset_encode_column (StylePrintDataset *self,
+                                                       guint  col);
+const guint32 *style_print_dataset_get_codes (StylePrintDataset *self,
+                                                          guint  col);
+StylePrintColumnType style_print_dataset_get_column_type (
+                                            StylePrintDataset *self,
+                                                        guint  col);
+guint style_print_dataset_get_n_columns (StylePrintDataset *self);
+const gchar *style_print_dataset_get_column_name (StylePrintDataset *self,
+                                                              guint  col);
+gint style_print_dataset_get_column_index (StylePrintDataset *self,
+                                                 const gchar *name);
+
+void style_print_dataset_append_row (StylePrintDataset  *self,
+                                           const gchar **values);
+void style_print_dataset_append_row_with_lengths (StylePrintDataset *self,
+                                                      const gchar **values,
+                                                      const gsize  *lengths);
+guint style_print_dataset_get_n_rows (StylePrintDataset *self);
+const gchar *style_print_dataset_get_value (StylePrintDataset *self,
+                                                        guint  row,
+                                                        guint  col);
+const gchar *style_print_dataset_get_slice (StylePrintDataset *self,
+                                                        guint  row,
+                                                        guint  col,
+                                                        gsize *len);
+void style_print_dataset_get_native (StylePrintDataset *self,
+                                                 guint  row,
+                                                 guint  col,
+                                       StylePrintValue *value);
+gint style_print_value_compare (const StylePrintValue *a,
+                                const StylePrintValue *b);
+const gchar *style_print_dataset_lookup (StylePrintDataset *self,
+                                                     guint  row,
+                                               const gchar *colname);
+
+G_END_DECLS
+
+#ifdef _cplusplus
+}
+#endif
+
+#endif      //ifndef __STYLE_PRINT_DATASET_H
@@ -0,0 +1,404 @@
+/*
+Copyright (c) 2017 David Breeding
+
+This file is part of tableprint.
+
+tableprint is free software: you can redistribute it and/or modify
+it under the terms of the Lesser GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+tableprint is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with tableprint (see the files "COPYING" and "COPYING.LESSER").
+If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* ************************************************************************ *
+ * styleprintmeasure.c - A bounded cache of the heights and layouts of      $
+ * cell texts                                                               $
+ *                                                                          $
+ * Reports tend to repeat a few values (status codes, currencies,           $
+ * categories) in a column thousands of times.  The height of a cell is     $
+ * kept here under its font, layout width, alignment and text, so that a    $
+ * repeated value need not be laid out again to learn its height.  When     $
+ * the cache is full, the entry used least recently is dropped.             $
+ *                                                                          $
+ * When a cached text is drawn, the layout it is drawn with is kept in the  $
+ * cache too, so when it is drawn again, Pango need not itemize and shape   $
+ * it again: the glyphs of the layout's lines are simply shown.             $
+ *                                                                          $
+ * The font is identified by its pointer, which is safe as long as the      $
+ * cache does not outlive the template whose font pool the fonts are from.  $
+ *                                                                          $
+ * Short, single-line ASCII texts - codes, numbers, dates - are measured    $
+ * without Pango at all, from a table of the advance width of each          $
+ * printable ASCII character in the font.  If the text is certain to fit    $
+ * on one line, its height is the height of a line.                         $
+ * $Id::                                                                    $
+ * ************************************************************************ */
+
+#include <string.h>
+#include "styleprinttablepriv.h"
+
+// Longer texts are seldom repeated, so are not worth keeping
+#define MEASURE_MAX_TEXT 256
+
+struct measure_entry {
+    const PangoFontDescription *font;
+    gint   width;                   // Layout width in Pango units
+    PangoAlignment align;
+    guint  hash;                    // Hash of the text
+    gsize  len;                     // Length of the text
+    const gchar *text;              // The text (follows the entry)
+    gint   height;                  // Height of the text in Pango units
+    PangoLayout *layout;            // The text laid out, once it is drawn
+};
+
+// Printable ASCII, the characters in an advance table
+#define ADV_FIRST 0x20
+#define ADV_LAST 0x7e
+
+struct advance_table {
+    gint   adv[ADV_LAST - ADV_FIRST + 1];   // Advance widths, Pango units
+    gint   maxadv;                  // The widest advance
+    gint   lineheight;              // Height of one line, Pango units
+};
+
+struct measure_cache {
+    GHashTable *entries;            // MEASUREENTRY => its link in "lru"
+    GQueue lru;                     // Entries, most recently used first
+    guint  size;                    // Maximum number of entries
+};
+
+/* ******************************************************************** *
+ * entry_hash(), entry_equal() - Hash and compare MEASUREENTRYs.        *
+ * ******************************************************************** */
+
+static guint
+entry_hash (gconstpointer key)
+{
+    const MEASUREENTRY *ent = key;
+
+    return ent->hash ^ GPOINTER_TO_UINT(ent->font) ^ ((guint)ent->width << 3)
+                ^ ent->align;
+}
+
+static gboolean
+entry_equal (gconstpointer a, gconstpointer b)
+{
+    const MEASUREENTRY *x = a,
+                       *y = b;
+
+    return (x->hash == y->hash) && (x->font == y->font) &&
+                (x->width == y->width) && (x->align == y->align) &&
+                (x->len == y->len) && !memcmp (x->text, y->text, x->len);
+}
+
+/* ******************************************************************** *
+ * text_hash() - Hash "len" bytes of "text" (FNV-1a).                   *
+ * ******************************************************************** */
+
+static guint
+text_hash (const gchar *text, gsize len)
+{
+    guint hash = 2166136261U;
+    gsize idx;
+
+    for (idx = 0; idx < len; idx++)
+    {
+        hash = (hash ^ (guchar)text[idx]) * 16777619U;
+    }
+
+    return hash;
+}
+
+/* ******************************************************************** *
+ * free_entry() - Free a MEASUREENTRY and its layout.                   *
+ * ******************************************************************** */
+
+static void
+free_entry (MEASUREENTRY *ent)
+{
+    if (ent->layout)
+    {
+        g_object_unref (ent->layout);
+    }
+
+    g_free (ent);
+}
+
+/* ******************************************************************** *
+ * _style_print_measure_cache_new() - Create a cache holding at most    *
+ *      "size" texts.                                                   *
+ * ******************************************************************** */
+
+MEASURECACHE *
+_style_print_measure_cache_new (guint size)
+{
+    MEASURECACHE *cache = g_new0 (MEASURECACHE, 1);
+
+    cache->entries = g_hash_table_new (entry_hash, entry_equal);
+    g_queue_init (&cache->lru);
+    cache->size = size;
+
+    return cache;
+}
+
+/* ******************************************************************** *
+ * _style_print_measure_cache_free() - Free the cache and its entries.  *
+ * ******************************************************************** */
+
+void
+_style_print_measure_cache_free (MEASURECACHE *cache)
+{
+    if (!cache)
+    {
+        return;
+    }
+
+    g_hash_table_destroy (cache->entries);
+    g_queue_foreach (&cache->lru, (GFunc)free_entry, NULL);
+    g_queue_clear (&cache->lru);
+    g_free (cache);
+}
+
+/* ******************************************************************** *
+ * _style_print_measure_cache_lookup() - Find the entry for "len" bytes *
+ *      of "text" laid out "width" wide in "font", aligned by "align".  *
+ * Returns: The entry, or NULL if the text is not cached                *
+ * ******************************************************************** */
+
+MEASUREENTRY *
+_style_print_measure_cache_lookup (MEASURECACHE *cache,
+                                   const PangoFontDescription *font,
+                                   gint width, PangoAlignment align,
+                                   const gchar *text, gsize len)
+{
+    MEASUREENTRY key;
+    GList *link;
+
+    if (len > MEASURE_MAX_TEXT)
+    {
+        return NULL;
+    }
+
+    key.font = font;
+    key.width = width;
+    key.align = align;
+    key.hash = text_hash (text, len);
+    key.len = len;
+    key.text = text;
+
+    if (!(link = g_hash_table_lookup (cache->entries, &key)))
+    {
+        return NULL;
+    }
+
+    // Move the entry to the front, as the most recently used
+    g_queue_unlink (&cache->lru, link);
+    g_queue_push_head_link (&cache->lru, link);
+
+    return link->data;
+}
+
+/* ******************************************************************** *
+ * _style_print_measure_cache_insert() - Add the height of a text to    *
+ *      the cache, dropping the least recently used entry if it is      *
+ *      full.  The text must not already be in the cache.               *
+ * Returns: The new entry, or NULL if the text cannot be cached         *
+ * ******************************************************************** */
+
+MEASUREENTRY *
+_style_print_measure_cache_insert (MEASURECACHE *cache,
+                                   const PangoFontDescription *font,
+                                   gint width, PangoAlignment align,
+                                   const gchar *text, gsize len,
+                                   gint height)
+{
+    MEASUREENTRY *ent;
+
+    if ((len > MEASURE_MAX_TEXT) || !cache->size)
+    {
+        return NULL;
+    }
+
+    if (cache->lru.length >= cache->size)
+    {
+        MEASUREENTRY *old = g_queue_pop_tail (&cache->lru);
+
+        g_hash_table_remove (cache->entries, old);
+        free_entry (old);
+    }
+
+    ent = g_malloc (sizeof(MEASUREENTRY) + len);
+    memcpy (ent + 1, text, len);
+    ent->font = font;
+    ent->width = width;
+    ent->align = align;
+    ent->hash = text_hash (text, len);
+    ent->len = len;
+    ent->text = (const gchar *)(ent + 1);
+    ent->height = height;
+    ent->layout = NULL;
+
+    g_queue_push_head (&cache->lru, ent);
+    g_hash_table_insert (cache->entries, ent, cache->lru.head);
+
+    return ent;
+}
+
+/* ******************************************************************** *
+ * _style_print_measure_entry_get_height() - The height of the text of  *
+ *      an entry, in Pango units.                                       *
+ * ******************************************************************** */
+
+gint
+_style_print_measure_entry_get_height (MEASUREENTRY *ent)
+{
+    return ent->height;
+}
+
+/* ******************************************************************** *
+ * _style_print_measure_entry_get_layout() - Get the layout to draw the *
+ *      text of an entry with.  The first time, it is made from a copy  *
+ *      of "proto", which must have the entry's font, width and         *
+ *      alignment.  After that, the same layout, with its lines already *
+ *      shaped, is returned.                                            *
+ * ******************************************************************** */
+
+PangoLayout *
+_style_print_measure_entry_get_layout (MEASUREENTRY *ent, PangoLayout *proto)
+{
+    if (!ent->layout)
+    {
+        ent->layout = pango_layout_copy (proto);
+        pango_layout_set_text (ent->layout, ent->text, ent->len);
+    }
+
+    return ent->layout;
+}
+
+/* ******************************************************************** *
+ * _style_print_advances_new() - Measure the advance width of each      *
+ *      printable ASCII character, and the height of a line, in the     *
+ *      font of "layout".  The text and width of "layout" are changed.  *
+ * ******************************************************************** */
+
+ADVTABLE *
+_style_print_advances_new (PangoLayout *layout)
+{
+    ADVTABLE *tbl = g_new0 (ADVTABLE, 1);
+    PangoRectangle log_rect;
+    gchar all[ADV_LAST - ADV_FIRST + 1];
+    gint c;
+
+    pango_layout_set_width (layout, -1);
+
+    for (c = ADV_FIRST; c <= ADV_LAST; c++)
+    {
+        gchar ch = c;
+
+        pango_layout_set_text (layout, &ch, 1);
+        pango_layout_get_extents (layout, NULL, &log_rect);
+        tbl->adv[c - ADV_FIRST] = log_rect.width;
+        tbl->maxadv = MAX(tbl->maxadv, log_rect.width);
+        all[c - ADV_FIRST] = c;
+    }
+
+    // All printable ASCII comes from the one font, so every line of it
+    // is the same height
+    pango_layout_set_text (layout, all, sizeof(all));
+    pango_layout_get_extents (layout, NULL, &log_rect);
+    tbl->lineheight = log_rect.height;
+
+    return tbl;
+}
+
+/* ******************************************************************** *
+ * _style_print_advances_free() - Free an advance table.                *
+ * ******************************************************************** */
+
+void
+_style_print_advances_free (ADVTABLE *tbl)
+{
+    g_free (tbl);
+}
+
+/* ******************************************************************** *
+ * is_printable_ascii() - Check that every byte of "text" is printable  *
+ *      ASCII: no control characters (so no newlines or tabs), and no   *
+ *      multibyte UTF-8.  Eight bytes are checked at a time.            *
+ * ******************************************************************** */
+
+#define ONES    G_GUINT64_CONSTANT(0x0101010101010101)
+#define HIGHS   G_GUINT64_CONSTANT(0x8080808080808080)
+
+static gboolean
+is_printable_ascii (const gchar *text, gsize len)
+{
+    gsize idx = 0;
+
+    for (; idx + sizeof(guint64) <= len; idx += sizeof(guint64))
+    {
+        guint64 w;
+
+        memcpy (&w, text + idx, sizeof(w));
+
+        // The high bit of a byte is set in the first term if it is below
+        // ADV_FIRST, and in the second if it is above ADV_LAST
+        if ((((w - ONES * ADV_FIRST) & ~w) |
+                ((w + ONES * (0x7f - ADV_LAST)) | w)) & HIGHS)
+        {
+            return FALSE;
+        }
+    }
+
+    for (; idx < len; idx++)
+    {
+        if (((guchar)text[idx] < ADV_FIRST) || ((guchar)text[idx] > ADV_LAST))
+        {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+/* ******************************************************************** *
+ * _style_print_advances_measure() - Find the height of "len" bytes of  *
+ *      "text" laid out "width" wide, without laying it out, if it is   *
+ *      printable ASCII which is certain to fit on one line.  The width *
+ *      is allowed one character's slack for any difference that       *
+ *      kerning and hinting make to the sum of the advances.            *
+ * Returns: TRUE (setting "height") if the text could be measured       *
+ * ******************************************************************** */
+
+gboolean
+_style_print_advances_measure (ADVTABLE *tbl, const gchar *text, gsize len,
+                               gint width, gint *height)
+{
+    gint limit = width - tbl->maxadv,
+         total = 0;
+    gsize idx;
+
+    if ((limit <= 0) || !is_printable_ascii (text, len))
+    {
+        return FALSE;
+    }
+
+    for (idx = 0; idx < len; idx++)
+    {
+        if ((total += tbl->adv[(guchar)text[idx] - ADV_FIRST]) > limit)
+        {
+            return FALSE;
+        }
+    }
+
+    *height = tbl->lineheight;
+    return TRUE;
+}
@@ -40,6 +40,14 @@ If not, see <http://www.gnu.org/licenses/>.
  *
  * #StylePrintMy enables one to retrieve the data from a MySql database
  * and organize this data into a form recognizable by #StylePrintTable.
+ *
+ * When the query has no parameters, the result set is retrieved with
+ * mysql_store_result() and is not copied.  It is kept for the duration
+ * of the printout, and the values are read from it as they are printed.
+ *
+ * For very large results, style_print_my_set_fetch_size() causes such a
+ * query to be read with mysql_use_result() instead, a batch of rows at a
+ * time, so that the whole result need never be held in memory.
  */
 
 struct _StylePrintMy
@@ -49,22 +57,412 @@ struct _StylePrintMy
     /*< private >*/
     MYSQL     MYconn;
     GPtrArray *qryParams;
+    guint      fetchSize;   // Rows per batch from mysql_use_result(), or 0
 };
 
 G_DEFINE_TYPE(StylePrintMy, style_print_my, STYLE_PRINT_TYPE_TABLE)
 
-static GPtrArray * qry_get_data_direct (StylePrintMy *self,
-                                         const gchar *qry,
-                                           GPtrArray *params);
+/* ******************************************************************** *
+ * my_column_type() - Map the type of a result field to a column type.  *
+ *      Note that a "zero" date, which is not a valid date, is NULL.    *
+ * ******************************************************************** */
+
+static StylePrintColumnType
+my_column_type (MYSQL_FIELD *myfld)
+{
+    switch (myfld->type)
+    {
+        case MYSQL_TYPE_LONGLONG:
+            // An unsigned BIGINT may not fit in a gint64
+            return (myfld->flags & UNSIGNED_FLAG) ?
+                        STYLE_PRINT_COLUMN_NUMERIC : STYLE_PRINT_COLUMN_INT64;
+        case MYSQL_TYPE_TINY:
+        case MYSQL_TYPE_SHORT:
+        case MYSQL_TYPE_LONG:
+        case MYSQL_TYPE_INT24:
+        case MYSQL_TYPE_YEAR:
+            return STYLE_PRINT_COLUMN_INT64;
+        case MYSQL_TYPE_FLOAT:
+        case MYSQL_TYPE_DOUBLE:
+            return STYLE_PRINT_COLUMN_DOUBLE;
+        case MYSQL_TYPE_DECIMAL:
+        case MYSQL_TYPE_NEWDECIMAL:
+            return STYLE_PRINT_COLUMN_NUMERIC;
+        case MYSQL_TYPE_DATE:
+        case MYSQL_TYPE_NEWDATE:
+            return STYLE_PRINT_COLUMN_DATE;
+        case MYSQL_TYPE_DATETIME:
+        case MYSQL_TYPE_TIMESTAMP:
+            return STYLE_PRINT_COLUMN_TIMESTAMP;
+        default:
+            return STYLE_PRINT_COLUMN_TEXT;
+    }
+}
+
+/* ==================================================================== *
+ * StylePrintMyDataset - A #StylePrintDataset which reads its values    *
+ *      directly from a stored MYSQL_RES, which it owns.                *
+ * ==================================================================== */
+
+#define STYLE_PRINT_TYPE_MY_DATASET (style_print_my_dataset_get_type())
+
+G_DECLARE_FINAL_TYPE(StylePrintMyDataset, style_print_my_dataset, STYLE_PRINT, MY_DATASET, StylePrintDataset)
+
+struct _StylePrintMyDataset
+{
+    StylePrintDataset parent_instance;
+
+    /*< private >*/
+    MYSQL_RES  *rslt;
+    GPtrArray  *rows;           // The MYSQL_ROW for each row of rslt
+    GHashTable *colindex;       // Field name => index + 1
+};
+
+G_DEFINE_TYPE(StylePrintMyDataset, style_print_my_dataset,
+                                            STYLE_PRINT_TYPE_DATASET)
+
+static void
+style_print_my_dataset_init (StylePrintMyDataset *self)
+{
+    self->rslt = NULL;
+    self->rows = g_ptr_array_new ();
+    self->colindex = g_hash_table_new (g_str_hash, g_str_equal);
+}
+
+static void
+style_print_my_dataset_finalize (GObject *object)
+{
+    StylePrintMyDataset *self = STYLE_PRINT_MY_DATASET(object);
+
+    // The row pointers and field names both belong to rslt
+    g_ptr_array_free (self->rows, TRUE);
+    g_hash_table_destroy (self->colindex);
+
+    if (self->rslt)
+    {
+        mysql_free_result (self->rslt);
+    }
 
-static GPtrArray * qry_get_data_params (StylePrintMy *self,
-                                         const gchar *qry,
-                                           GPtrArray *params);
+    G_OBJECT_CLASS(style_print_my_dataset_parent_class)->finalize (object);
+}
+
+static guint
+my_dataset_get_n_rows (StylePrintDataset *ds)
+{
+    return STYLE_PRINT_MY_DATASET(ds)->rows->len;
+}
+
+static const gchar *
+my_dataset_get_value (StylePrintDataset *ds, guint row, guint col)
+{
+    MYSQL_ROW myRow = g_ptr_array_index (STYLE_PRINT_MY_DATASET(ds)->rows,
+                                                                    row);
+
+    return myRow[col];
+}
+
+static guint
+my_dataset_get_n_columns (StylePrintDataset *ds)
+{
+    return mysql_num_fields (STYLE_PRINT_MY_DATASET(ds)->rslt);
+}
+
+static const gchar *
+my_dataset_get_column_name (StylePrintDataset *ds, guint col)
+{
+    MYSQL_RES *rslt = STYLE_PRINT_MY_DATASET(ds)->rslt;
+
+    if (col >= mysql_num_fields (rslt))
+    {
+        return NULL;
+    }
+
+    return mysql_fetch_field_direct (rslt, col)->name;
+}
+
+static StylePrintColumnType
+my_dataset_get_column_type (StylePrintDataset *ds, guint col)
+{
+    return my_column_type (mysql_fetch_field_direct (
+                                STYLE_PRINT_MY_DATASET(ds)->rslt, col));
+}
+
+static gint
+my_dataset_get_column_index (StylePrintDataset *ds, const gchar *name)
+{
+    return GPOINTER_TO_INT(g_hash_table_lookup (
+                        STYLE_PRINT_MY_DATASET(ds)->colindex, name)) - 1;
+}
+
+static void
+style_print_my_dataset_class_init (StylePrintMyDatasetClass *class)
+{
+    GObjectClass *gobject_class = (GObjectClass *) class;
+    StylePrintDatasetClass *ds_class = (StylePrintDatasetClass *) class;
+
+    gobject_class->finalize = style_print_my_dataset_finalize;
+
+    ds_class->get_n_rows = my_dataset_get_n_rows;
+    ds_class->get_value = my_dataset_get_value;
+    ds_class->get_n_columns = my_dataset_get_n_columns;
+    ds_class->get_column_name = my_dataset_get_column_name;
+    ds_class->get_column_index = my_dataset_get_column_index;
+    ds_class->get_column_type = my_dataset_get_column_type;
+}
+
+/* ******************************************************************** *
+ * my_dataset_new() - Wrap a result retrieved by mysql_store_result()   *
+ *      in a #StylePrintDataset, which takes ownership of it.  The rows *
+ *      are walked once to record where each one is; the values are    *
+ *      not copied.  If a field name is repeated, the last field of     *
+ *      that name is the one found by name.                             *
+ * ******************************************************************** */
+
+static StylePrintDataset *
+my_dataset_new (MYSQL_RES *rslt)
+{
+    StylePrintMyDataset *self = g_object_new (STYLE_PRINT_TYPE_MY_DATASET,
+                                                NULL);
+    MYSQL_ROW myRow;
+    unsigned int col;
+
+    self->rslt = rslt;
+
+    for (col = 0; col < mysql_num_fields (rslt); col++)
+    {
+        g_hash_table_insert (self->colindex,
+                    mysql_fetch_field_direct (rslt, col)->name,
+                    GINT_TO_POINTER(col + 1));
+    }
+
+    mysql_data_seek (rslt, 0);
+
+    while ((myRow = mysql_fetch_row (rslt)))
+    {
+        g_ptr_array_add (self->rows, myRow);
+    }
+
+    return STYLE_PRINT_DATASET(self);
+}
+
+/* ==================================================================== *
+ * StylePrintMySource - A #StylePrintRowSource which reads the result   *
+ *      of a query row by row with mysql_use_result().  Each batch is   *
+ *      copied into a #StylePrintDataset, as the rows returned by       *
+ *      mysql_fetch_row() are only valid until the next fetch.  Since   *
+ *      the server cannot reposition the result, rewinding the source   *
+ *      executes the query again.                                       *
+ * ==================================================================== */
+
+#define STYLE_PRINT_TYPE_MY_SOURCE (style_print_my_source_get_type())
+
+G_DECLARE_FINAL_TYPE(StylePrintMySource, style_print_my_source, STYLE_PRINT, MY_SOURCE, GObject)
+
+struct _StylePrintMySource
+{
+    GObject parent_instance;
+
+    /*< private >*/
+    MYSQL     *conn;        // Borrowed from the StylePrintMy
+    gchar     *qry;
+    MYSQL_RES *rslt;
+    guint      fetchsize;
+    gchar    **keycols;     // Columns to dictionary-encode
+};
+
+static void my_source_iface_init (StylePrintRowSourceInterface *);
+
+G_DEFINE_TYPE_WITH_CODE(StylePrintMySource, style_print_my_source,
+                G_TYPE_OBJECT,
+                G_IMPLEMENT_INTERFACE(STYLE_PRINT_TYPE_ROW_SOURCE,
+                                        my_source_iface_init))
+
+static void
+style_print_my_source_init (StylePrintMySource *self)
+{
+    self->conn = NULL;
+    self->qry = NULL;
+    self->rslt = NULL;
+    self->fetchsize = 0;
+    self->keycols = NULL;
+}
+
+static void
+style_print_my_source_finalize (GObject *object)
+{
+    StylePrintMySource *self = STYLE_PRINT_MY_SOURCE(object);
+
+    if (self->rslt)
+    {
+        mysql_free_result (self->rslt);
+    }
+
+    g_free (self->qry);
+    g_strfreev (self->keycols);
+
+    G_OBJECT_CLASS(style_print_my_source_parent_class)->finalize (object);
+}
+
+static void
+style_print_my_source_class_init (StylePrintMySourceClass *class)
+{
+    GObjectClass *gobject_class = (GObjectClass *) class;
+
+    gobject_class->finalize = style_print_my_source_finalize;
+}
+
+/* ******************************************************************** *
+ * my_source_execute() - Send the query and begin retrieving its rows.  *
+ * ******************************************************************** */
+
+static gboolean
+my_source_execute (StylePrintMySource *self, GError **error)
+{
+    if (mysql_query (self->conn, self->qry) ||
+            !(self->rslt = mysql_use_result (self->conn)))
+    {
+        g_set_error (error, STYLE_PRINT_ROW_SOURCE_ERROR,
+                STYLE_PRINT_ROW_SOURCE_ERROR_FAILED, "%s",
+                mysql_field_count (self->conn) ? mysql_error (self->conn) :
+                                                "No data returned by query");
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+static StylePrintDataset *
+my_source_next_batch (StylePrintRowSource *src, guint max_rows,
+                                                GError **error)
+{
+    StylePrintMySource *self = STYLE_PRINT_MY_SOURCE(src);
+    StylePrintDataset *data;
+    unsigned int numCols, col;
+    gint *colmap;
+    const gchar **values;
+    gsize *lengths;
+    guint want, nrows = 0;
+    MYSQL_ROW myRow;
+
+    if (!self->rslt)
+    {
+        return NULL;
+    }
+
+    want = self->fetchsize ? self->fetchsize : max_rows;
+    numCols = mysql_num_fields (self->rslt);
+    data = style_print_dataset_new ();
+
+    // If a field name is repeated, the last field of that name is used,
+    // as for a stored result.
+    colmap = g_malloc (numCols * sizeof (gint));
+
+    for (col = 0; col < numCols; col++)
+    {
+        MYSQL_FIELD *myfld = mysql_fetch_field_direct (self->rslt, col);
+
+        colmap[col] = style_print_dataset_add_typed_column (data,
+                                myfld->name, my_column_type (myfld));
+    }
+
+    // Group columns are encoded before the rows are added, so that each
+    // distinct value is only copied once.
+    for (col = 0; self->keycols && self->keycols[col]; col++)
+    {
+        gint idx = style_print_dataset_get_column_index (data,
+                                                    self->keycols[col]);
+
+        if (idx >= 0)
+        {
+            style_print_dataset_encode_column (data, idx);
+        }
+    }
+
+    values = g_malloc0 (numCols * sizeof (gchar *));
+    lengths = g_malloc0 (numCols * sizeof (gsize));
+
+    while ((nrows < want) && (myRow = mysql_fetch_row (self->rslt)))
+    {
+        unsigned long *myLens = mysql_fetch_lengths (self->rslt);
+
+        for (col = 0; col < numCols; col++)
+        {
+            values[colmap[col]] = myRow[col];
+            lengths[colmap[col]] = myLens[col];
+        }
+
+        style_print_dataset_append_row_with_lengths (data, values, lengths);
+        ++nrows;
+    }
+
+    g_free (lengths);
+    g_free (values);
+    g_free (colmap);
+
+    if ((nrows < want) && mysql_errno (self->conn))
+    {
+        g_set_error (error, STYLE_PRINT_ROW_SOURCE_ERROR,
+                STYLE_PRINT_ROW_SOURCE_ERROR_FAILED, "%s",
+                mysql_error (self->conn));
+        g_object_unref (data);
+        return NULL;
+    }
+
+    if (nrows == 0)
+    {
+        g_object_unref (data);
+        return NULL;
+    }
+
+    return data;
+}
+
+static gboolean
+my_source_rewind (StylePrintRowSource *src, GError **error)
+{
+    StylePrintMySource *self = STYLE_PRINT_MY_SOURCE(src);
+
+    if (self->rslt)
+    {
+        // This reads (and discards) any rows not yet fetched
+        mysql_free_result (self->rslt);
+        self->rslt = NULL;
+    }
+
+    return my_source_execute (self, error);
+}
+
+static void
+my_source_set_key_columns (StylePrintRowSource *src,
+                        const gchar * const *names)
+{
+    StylePrintMySource *self = STYLE_PRINT_MY_SOURCE(src);
+
+    g_strfreev (self->keycols);
+    self->keycols = g_strdupv ((gchar **)names);
+}
+
+static void
+my_source_iface_init (StylePrintRowSourceInterface *iface)
+{
+    iface->next_batch = my_source_next_batch;
+    iface->rewind = my_source_rewind;
+    iface->set_key_columns = my_source_set_key_columns;
+}
+
+static StylePrintDataset * qry_get_data_direct (StylePrintMy *self,
+                                                 const gchar *qry,
+                                                   GPtrArray *params);
+
+static StylePrintDataset * qry_get_data_params (StylePrintMy *self,
+                                                 const gchar *qry,
+                                                   GPtrArray *params);
 void
 style_print_my_init (StylePrintMy *my)
 {
     //my->MYconn = NULL;
     my->qryParams = NULL;
+    my->fetchSize = 0;
     //my->myresult = NULL;
 }
 
@@ -186,6 +584,31 @@ style_print_my_appendParam (StylePrintMy *self, const gchar *param)
     g_ptr_array_add (self->qryParams, (gpointer)param);
 }
 
+/**
+ * style_print_my_set_fetch_size:
+ * @self: The #StylePrintMy
+ * @rows: The number of rows to retrieve at a time, or 0 to retrieve the
+ * entire result at once
+ *
+ * By default, the entire result of the query is retrieved before the
+ * printout begins.  If @rows is nonzero, a query without parameters is
+ * instead read with mysql_use_result(), @rows rows at a time, as the
+ * printout proceeds, and rows are released once the pages containing them
+ * have been laid out.  Note that if drawing a page needs rows which have
+ * already been released, the query is executed again to reach them, so it
+ * should return the same rows each time.
+ *
+ * Queries with parameters are always retrieved in full.
+ */
+
+void
+style_print_my_set_fetch_size (StylePrintMy *self, guint rows)
+{
+    g_return_if_fail (STYLE_PRINT_IS_MY(self));
+
+    self->fetchSize = rows;
+}
+
 /**
  * style_print_my_select_db:
  * @self: A #StylePrintMy pointer
@@ -238,28 +661,22 @@ style_print_my_do (StylePrintMy *self, const gchar * qry)
     //PQclear (rslt);     // Simply discard this result
 }
 
-/* GDestroyNotify function to free the data Array */
-void
-free_data_array (gpointer ht)
-{
-    g_hash_table_destroy ((GHashTable *)ht);
-}
-
 /* ==================================================================== *
  * Retrieve data from the database and convert it to format expected    *
  * by StylePrintTable where query is a prepared statement with separate *
  * parameters.                                                          *
  * ==================================================================== */
 
-static GPtrArray *
+static StylePrintDataset *
 qry_get_data_params (StylePrintMy *self, const gchar *qry, GPtrArray *params)
 {
     MYSQL_STMT   *stmt;
     MYSQL_BIND   *inBinds, *outBinds;
     MYSQL_RES    *prepare_meta_result;
     unsigned int  param_count, numCols;
-    GPtrArray    *colnames,
-                 *data;
+    StylePrintDataset *data;
+    const gchar **values;
+    gint         *colmap;
     GPtrArray    *inLens = g_ptr_array_new_with_free_func(g_free);
     GPtrArray    *is_null = g_ptr_array_new_with_free_func(g_free);
     GPtrArray    *length = g_ptr_array_new_with_free_func(g_free);
@@ -349,14 +766,17 @@ qry_get_data_params (StylePrintMy *self, const gchar *qry, GPtrArray *params)
     outBinds = g_malloc (numCols * sizeof (MYSQL_BIND));
     memset (outBinds, 0, numCols * sizeof (MYSQL_BIND));
 
-    colnames = g_ptr_array_new_with_free_func (g_free);
-    //colnames = g_ptr_array_new_with_free_func ((GDestroyNotify)free_gchararray);
+    // colmap maps the result fields to the dataset columns.  If a name
+    // is repeated in the result, the last field of that name is used.
+    data = style_print_dataset_new ();
+    colmap = g_malloc (numCols * sizeof (gint));
 
     for (curCol = 0; curCol < numCols; curCol++)
     {
         MYSQL_FIELD *myfld = mysql_fetch_field (prepare_meta_result);
 
-        g_ptr_array_add (colnames, g_strdup (myfld->name));
+        colmap[curCol] = style_print_dataset_add_typed_column (data,
+                                myfld->name, my_column_type (myfld));
         outBinds[curCol].buffer_type = MYSQL_TYPE_STRING;
 
         if (((myfld->length) < 200) && (myfld->length > 20))
@@ -383,37 +803,33 @@ qry_get_data_params (StylePrintMy *self, const gchar *qry, GPtrArray *params)
     if (mysql_stmt_bind_result (stmt, outBinds))
     {
         report_err (self, mysql_stmt_error (stmt));
+        g_object_unref (data);
+        g_free (colmap);
         return NULL;
     }
 
-    data = g_ptr_array_new_with_free_func ((GDestroyNotify)free_data_array);
+    values = g_malloc0 (numCols * sizeof (gchar *));
 
     while (!mysql_stmt_fetch (stmt))
     {
-        GHashTable *colhash;
-
-        colhash = g_hash_table_new_full (g_str_hash,
-                                         g_str_equal, g_free, g_free);
-                                         //(GDestroyNotify)free_gchararray,
-                                         //(GDestroyNotify)free_gchararray);
-
         for (curCol = 0; curCol < numCols; curCol++)
         {
-            g_hash_table_insert (colhash,
-                        g_strdup (g_ptr_array_index (colnames, curCol)),
-                        *(outBinds[curCol].is_null) ? g_strdup ("") :
-                        g_strdup ((const gchar *)outBinds[curCol].buffer));
+            // An SQL NULL is stored as a null value, as in the other paths
+            values[colmap[curCol]] = *(outBinds[curCol].is_null) ? NULL :
+                                    (const gchar *)outBinds[curCol].buffer;
         }
 
-        g_ptr_array_add (data, colhash);
+        style_print_dataset_append_row (data, values);
     }
 
+    g_free (values);
+    g_free (colmap);
+
     mysql_free_result (prepare_meta_result);
     g_ptr_array_free (inLens, TRUE);
     g_ptr_array_free (is_null, TRUE);
     g_ptr_array_free (length, TRUE);
     g_ptr_array_free (error, TRUE);
-    g_ptr_array_free (colnames, TRUE);
     g_free (inBinds);
 
     // Free the Buffer areas for outBinds
@@ -429,26 +845,21 @@ qry_get_data_params (StylePrintMy *self, const gchar *qry, GPtrArray *params)
         report_err (self, mysql_error (&(self->MYconn)));
     }
 
-    mysql_close (&(self->MYconn));
-    //self->MYconn = NULL;
     return data;
 }
 
 /* ==================================================================== *
- * Retrieve data from the database and convert it to format expected    *
+ * Retrieve data from the database and provide it in the form expected  *
  * by StylePrintTable where query is direct inline string with no       *
- * parameters.                                                          *
+ * parameters.  The whole result is stored on the client, and the       *
+ * dataset returned reads the values from it without copying them.      *
  * ==================================================================== */
 
-static GPtrArray *
+static StylePrintDataset *
 qry_get_data_direct (StylePrintMy *self, const gchar *qry, GPtrArray *params)
 {
     MYSQL_RES   *rslt;
-    MYSQL_ROW    myRow;
-    MYSQL_FIELD *myField;
-    GPtrArray   *colnames,
-                *data;
-    unsigned int numCols;
+    StylePrintDataset *data;
 
 //    if ( ! self->MYconn)
 //    {
@@ -469,47 +880,67 @@ qry_get_data_direct (StylePrintMy *self, const gchar *qry, GPtrArray *params)
         return NULL;
     }
 
-    // If we get here, then we have data.  Now convert to GPtrArray->hash
-    rslt = mysql_use_result (&(self->MYconn));
-    numCols = mysql_num_fields (rslt);
-
-    // Populate the column names array
-
-    colnames = g_ptr_array_new_with_free_func (g_free);
-
-    while ((myField = mysql_fetch_field (rslt)))
+    // If we get here, then we have data.
+    if (!(rslt = mysql_store_result (&(self->MYconn))))
     {
-        g_ptr_array_add (colnames, g_strdup (myField->name));
+        report_err (self, mysql_error (&(self->MYconn)));
+        return NULL;
     }
 
-    data = g_ptr_array_new_with_free_func ((GDestroyNotify)free_data_array);
+    data = my_dataset_new (rslt);
+    return data;
+}
 
-    while ((myRow = mysql_fetch_row (rslt)))
+/* ******************************************************************** *
+ * qry_get_source() - Provide the rows for the query as a row source:   *
+ *      Read with mysql_use_result() if a fetch size has been set and   *
+ *      there are no parameters, else retrieve the complete result.     *
+ * ******************************************************************** */
+
+static StylePrintRowSource *
+qry_get_source (StylePrintMy *self, const gchar *qry, GPtrArray *params)
+{
+    StylePrintDataset *data;
+    StylePrintRowSource *src;
+
+    if (self->fetchSize && !params)
     {
-        GHashTable *colhash;
-        gint col;
+        StylePrintMySource *mysrc;
+        GError *err = NULL;
 
-        colhash = g_hash_table_new_full (g_str_hash,
-                                         g_str_equal,
-                                         g_free,
-                                         g_free);
+        mysrc = g_object_new (STYLE_PRINT_TYPE_MY_SOURCE, NULL);
+        mysrc->conn = &(self->MYconn);
+        mysrc->qry = g_strdup (qry);
+        mysrc->fetchsize = self->fetchSize;
 
-        for (col = 0; col < numCols; col++)
+        if (!my_source_execute (mysrc, &err))
         {
-            gchar *colname;
-            colname = g_strdup (g_ptr_array_index (colnames, col));
-
-            g_hash_table_insert (colhash, colname,
-                            g_strdup ((const gchar *)myRow[col]));
+            report_err (self, err->message);
+            g_error_free (err);
+            g_object_unref (mysrc);
+            return NULL;
         }
 
-        g_ptr_array_add (data, colhash);
+        return STYLE_PRINT_ROW_SOURCE(mysrc);
     }
 
-    mysql_free_result (rslt);
-    mysql_close (&(self->MYconn));
-    //self->MYconn = NULL;
-    return data;
+    if (params)
+    {
+        data = qry_get_data_params (self, qry, params);
+    }
+    else
+    {
+        data = qry_get_data_direct (self, qry, NULL);
+    }
+
+    if (!data)
+    {
+        return NULL;
+    }
+
+    src = style_print_row_source_new_from_dataset (data);
+    g_object_unref (data);
+    return src;
 }
 
 /**
@@ -531,24 +962,16 @@ style_print_my_fromxmlfile ( StylePrintMy *myprnt,
                                  GPtrArray *params,
                                       char *filename)
 {
-    GPtrArray *data;
+    StylePrintRowSource *src;
 
     style_print_table_set_wmain (STYLE_PRINT_TABLE(myprnt), win);
+    src = qry_get_source (myprnt, qry, params);
 
-    if (params)
-    {
-        data = qry_get_data_params (myprnt, qry, params);
-    }
-    else
-    {
-        data = qry_get_data_direct (myprnt, qry, NULL);
-    }
-
-    if (data)
+    if (src)
     {
-        style_print_table_from_xmlfile (STYLE_PRINT_TABLE(myprnt), win,
-                                                            data, filename);
-        g_ptr_array_free (data, TRUE);
+        style_print_table_from_xmlfile_source (STYLE_PRINT_TABLE(myprnt),
+                                                    win, src, filename);
+        g_object_unref (src);
     }
 
     mysql_close (&(myprnt->MYconn));
@@ -574,24 +997,16 @@ style_print_my_fromxmlstring ( StylePrintMy *myprnt,
                                    GPtrArray *params,
                                         char *xmlstr)
 {
-    GPtrArray *data;
+    StylePrintRowSource *src;
 
     style_print_table_set_wmain (STYLE_PRINT_TABLE(myprnt), win);
+    src = qry_get_source (myprnt, qry, params);
 
-    if (params)
-    {
-        data = qry_get_data_params (myprnt, qry, params);
-    }
-    else
-    {
-        data = qry_get_data_direct (myprnt, qry, NULL);
-    }
-
-    if (data)
+    if (src)
     {
-        style_print_table_from_xmlstring (STYLE_PRINT_TABLE(myprnt), win,
-                                                            data, xmlstr);
-        g_ptr_array_free (data, TRUE);
+        style_print_table_from_xmlstring_source (STYLE_PRINT_TABLE(myprnt),
+                                                    win, src, xmlstr);
+        g_object_unref (src);
     }
 
     mysql_close (&(myprnt->MYconn));
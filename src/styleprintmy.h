@@ -72,6 +72,7 @@ void style_print_my_fromxmlstring ( StylePrintMy *myprnt,
 void style_print_my_do ( StylePrintMy *self, const gchar *qry);
 void style_print_my_appendParam ( StylePrintMy *self, const gchar *param);
 gint style_print_my_select_db (StylePrintMy *self, const gchar *db);
+void style_print_my_set_fetch_size (StylePrintMy *self, guint rows);
 
 G_END_DECLS
 
@@ -44,6 +44,13 @@ If not, see <http://www.gnu.org/licenses/>.
  * #style_print_table.  A query string, and optionally parameters for the
  * query.  These paramters are presented to #style_print_pg_fromxmlfile
  * or #style_print_pg_fromxmlstring and the data is retrieved and printed.
+ *
+ * The result of the query is not copied.  It is kept for the duration of
+ * the printout, and the values are read from it as they are printed.
+ *
+ * For very large results, style_print_pg_set_fetch_size() causes the
+ * query to be read through a cursor instead, a batch of rows at a time,
+ * so that the whole result need never be held in memory.
  */
 
 struct _StylePrintPg
@@ -54,19 +61,347 @@ struct _StylePrintPg
     PGconn    *conn;
     gboolean   externConn;
     GPtrArray *qryParams;
+    guint      fetchSize;   // Rows per FETCH from a cursor, 0 = no cursor
 };
 
 G_DEFINE_TYPE(StylePrintPg, style_print_pg, STYLE_PRINT_TYPE_TABLE)
 
-static GPtrArray * qry_get_data (StylePrintPg *self,
-                                  const gchar *qry,
-                                    GPtrArray *params);
+/* ==================================================================== *
+ * StylePrintPgDataset - A #StylePrintDataset which reads its values    *
+ *      directly from a PGresult, which it owns.                        *
+ * ==================================================================== */
+
+#define STYLE_PRINT_TYPE_PG_DATASET (style_print_pg_dataset_get_type())
+
+G_DECLARE_FINAL_TYPE(StylePrintPgDataset, style_print_pg_dataset, STYLE_PRINT, PG_DATASET, StylePrintDataset)
+
+struct _StylePrintPgDataset
+{
+    StylePrintDataset parent_instance;
+
+    /*< private >*/
+    PGresult *rslt;
+};
+
+G_DEFINE_TYPE(StylePrintPgDataset, style_print_pg_dataset,
+                                            STYLE_PRINT_TYPE_DATASET)
+
+static void
+style_print_pg_dataset_init (StylePrintPgDataset *self)
+{
+    self->rslt = NULL;
+}
+
+static void
+style_print_pg_dataset_finalize (GObject *object)
+{
+    StylePrintPgDataset *self = STYLE_PRINT_PG_DATASET(object);
+
+    if (self->rslt)
+    {
+        PQclear (self->rslt);
+    }
+
+    G_OBJECT_CLASS(style_print_pg_dataset_parent_class)->finalize (object);
+}
+
+static guint
+pg_dataset_get_n_rows (StylePrintDataset *ds)
+{
+    return PQntuples (STYLE_PRINT_PG_DATASET(ds)->rslt);
+}
+
+// An SQL NULL is returned as NULL, not as the "" libpq gives for it, so
+// that it is null in the native values too
+static const gchar *
+pg_dataset_get_value (StylePrintDataset *ds, guint row, guint col)
+{
+    PGresult *rslt = STYLE_PRINT_PG_DATASET(ds)->rslt;
+
+    if (PQgetisnull (rslt, row, col))
+    {
+        return NULL;
+    }
+
+    return PQgetvalue (rslt, row, col);
+}
+
+static const gchar *
+pg_dataset_get_slice (StylePrintDataset *ds, guint row, guint col,
+                                                        gsize *len)
+{
+    PGresult *rslt = STYLE_PRINT_PG_DATASET(ds)->rslt;
+
+    if (PQgetisnull (rslt, row, col))
+    {
+        *len = 0;
+        return NULL;
+    }
+
+    *len = PQgetlength (rslt, row, col);
+    return PQgetvalue (rslt, row, col);
+}
+
+/* ******************************************************************** *
+ * pg_dataset_get_column_type() - Map the type of a field to a column   *
+ *      type.  The values are still read as text, and are parsed by     *
+ *      style_print_dataset_get_native() as they are needed.            *
+ * ******************************************************************** */
+
+// Type OIDs, from the server's catalog/pg_type.h
+#define PG_BOOLOID      16
+#define PG_INT8OID      20
+#define PG_INT2OID      21
+#define PG_INT4OID      23
+#define PG_FLOAT4OID    700
+#define PG_FLOAT8OID    701
+#define PG_DATEOID      1082
+#define PG_TIMESTAMPOID 1114
+#define PG_NUMERICOID   1700
+
+static StylePrintColumnType
+pg_dataset_get_column_type (StylePrintDataset *ds, guint col)
+{
+    switch (PQftype (STYLE_PRINT_PG_DATASET(ds)->rslt, col))
+    {
+        case PG_INT2OID:
+        case PG_INT4OID:
+        case PG_INT8OID:
+            return STYLE_PRINT_COLUMN_INT64;
+        case PG_FLOAT4OID:
+        case PG_FLOAT8OID:
+            return STYLE_PRINT_COLUMN_DOUBLE;
+        case PG_NUMERICOID:
+            return STYLE_PRINT_COLUMN_NUMERIC;
+        case PG_DATEOID:
+            return STYLE_PRINT_COLUMN_DATE;
+        case PG_TIMESTAMPOID:
+            return STYLE_PRINT_COLUMN_TIMESTAMP;
+        case PG_BOOLOID:
+            return STYLE_PRINT_COLUMN_BOOL;
+        default:
+            return STYLE_PRINT_COLUMN_TEXT;
+    }
+}
+
+static guint
+pg_dataset_get_n_columns (StylePrintDataset *ds)
+{
+    return PQnfields (STYLE_PRINT_PG_DATASET(ds)->rslt);
+}
+
+static const gchar *
+pg_dataset_get_column_name (StylePrintDataset *ds, guint col)
+{
+    return PQfname (STYLE_PRINT_PG_DATASET(ds)->rslt, col);
+}
+
+static gint
+pg_dataset_get_column_index (StylePrintDataset *ds, const gchar *name)
+{
+    return PQfnumber (STYLE_PRINT_PG_DATASET(ds)->rslt, name);
+}
+
+static void
+style_print_pg_dataset_class_init (StylePrintPgDatasetClass *class)
+{
+    GObjectClass *gobject_class = (GObjectClass *) class;
+    StylePrintDatasetClass *ds_class = (StylePrintDatasetClass *) class;
+
+    gobject_class->finalize = style_print_pg_dataset_finalize;
+
+    ds_class->get_n_rows = pg_dataset_get_n_rows;
+    ds_class->get_value = pg_dataset_get_value;
+    ds_class->get_slice = pg_dataset_get_slice;
+    ds_class->get_n_columns = pg_dataset_get_n_columns;
+    ds_class->get_column_name = pg_dataset_get_column_name;
+    ds_class->get_column_index = pg_dataset_get_column_index;
+    ds_class->get_column_type = pg_dataset_get_column_type;
+}
+
+/* ******************************************************************** *
+ * pg_dataset_new() - Wrap a PGresult in a #StylePrintDataset.  The     *
+ *      dataset takes ownership of the result, and clears it when it is *
+ *      finalized.                                                      *
+ * ******************************************************************** */
+
+static StylePrintDataset *
+pg_dataset_new (PGresult *rslt)
+{
+    StylePrintPgDataset *self = g_object_new (STYLE_PRINT_TYPE_PG_DATASET,
+                                                NULL);
+
+    self->rslt = rslt;
+    return STYLE_PRINT_DATASET(self);
+}
+
+/* ==================================================================== *
+ * StylePrintPgSource - A #StylePrintRowSource which reads the result   *
+ *      of a query through a cursor, FETCHing a batch of rows at a      *
+ *      time.  If no transaction is in progress when the cursor is      *
+ *      declared, one is begun, and is committed when the source is     *
+ *      finalized.                                                      *
+ * ==================================================================== */
+
+#define PG_CURSOR_NAME "styleprint_cursor"
+
+#define STYLE_PRINT_TYPE_PG_SOURCE (style_print_pg_source_get_type())
+
+G_DECLARE_FINAL_TYPE(StylePrintPgSource, style_print_pg_source, STYLE_PRINT, PG_SOURCE, GObject)
+
+struct _StylePrintPgSource
+{
+    GObject parent_instance;
+
+    /*< private >*/
+    PGconn   *conn;         // Borrowed from the StylePrintPg
+    guint     fetchsize;
+    gboolean  declared;     // The cursor is open
+    gboolean  ownxact;      // We began the transaction holding the cursor
+};
+
+static void pg_source_iface_init (StylePrintRowSourceInterface *);
+
+G_DEFINE_TYPE_WITH_CODE(StylePrintPgSource, style_print_pg_source,
+                G_TYPE_OBJECT,
+                G_IMPLEMENT_INTERFACE(STYLE_PRINT_TYPE_ROW_SOURCE,
+                                        pg_source_iface_init))
+
+static void
+style_print_pg_source_init (StylePrintPgSource *self)
+{
+    self->conn = NULL;
+    self->fetchsize = 0;
+    self->declared = FALSE;
+    self->ownxact = FALSE;
+}
+
+/* ******************************************************************** *
+ * pg_source_command() - Execute a command which returns no rows.       *
+ * Returns: TRUE on success, else FALSE, with error set                 *
+ * ******************************************************************** */
+
+static gboolean
+pg_source_command (PGconn *conn, const gchar *cmd, GError **error)
+{
+    PGresult *rslt = PQexec (conn, cmd);
+    gboolean ok = (PQresultStatus (rslt) == PGRES_COMMAND_OK);
+
+    if (!ok)
+    {
+        g_set_error (error, STYLE_PRINT_ROW_SOURCE_ERROR,
+                STYLE_PRINT_ROW_SOURCE_ERROR_FAILED, "%s",
+                PQresultErrorMessage (rslt));
+    }
+
+    PQclear (rslt);
+    return ok;
+}
+
+static void
+style_print_pg_source_finalize (GObject *object)
+{
+    StylePrintPgSource *self = STYLE_PRINT_PG_SOURCE(object);
+
+    if (self->declared)
+    {
+        pg_source_command (self->conn, "CLOSE " PG_CURSOR_NAME, NULL);
+    }
+
+    if (self->ownxact)
+    {
+        pg_source_command (self->conn, "COMMIT", NULL);
+    }
+
+    G_OBJECT_CLASS(style_print_pg_source_parent_class)->finalize (object);
+}
+
+static void
+style_print_pg_source_class_init (StylePrintPgSourceClass *class)
+{
+    GObjectClass *gobject_class = (GObjectClass *) class;
+
+    gobject_class->finalize = style_print_pg_source_finalize;
+}
+
+static StylePrintDataset *
+pg_source_next_batch (StylePrintRowSource *src, guint max_rows,
+                                                GError **error)
+{
+    StylePrintPgSource *self = STYLE_PRINT_PG_SOURCE(src);
+    PGresult *rslt;
+    gchar *cmd;
+
+    cmd = g_strdup_printf ("FETCH FORWARD %u FROM " PG_CURSOR_NAME,
+                            self->fetchsize ? self->fetchsize : max_rows);
+    rslt = PQexec (self->conn, cmd);
+    g_free (cmd);
+
+    if (PQresultStatus (rslt) != PGRES_TUPLES_OK)
+    {
+        g_set_error (error, STYLE_PRINT_ROW_SOURCE_ERROR,
+                STYLE_PRINT_ROW_SOURCE_ERROR_FAILED, "%s",
+                PQresultErrorMessage (rslt));
+        PQclear (rslt);
+        return NULL;
+    }
+
+    if (PQntuples (rslt) == 0)
+    {
+        PQclear (rslt);
+        return NULL;
+    }
+
+    return pg_dataset_new (rslt);
+}
+
+static gboolean
+pg_source_rewind (StylePrintRowSource *src, GError **error)
+{
+    return pg_source_command (STYLE_PRINT_PG_SOURCE(src)->conn,
+                                "MOVE ABSOLUTE 0 IN " PG_CURSOR_NAME, error);
+}
+
+// Positioning the cursor on the row before "row" (row 0 being "before
+// the first row") makes the next FETCH begin with "row"
+static gboolean
+pg_source_seek (StylePrintRowSource *src, guint row, guint *first,
+                                                GError **error)
+{
+    gchar *cmd;
+    gboolean ok;
+
+    cmd = g_strdup_printf ("MOVE ABSOLUTE %u IN " PG_CURSOR_NAME, row);
+    ok = pg_source_command (STYLE_PRINT_PG_SOURCE(src)->conn, cmd, error);
+    g_free (cmd);
+
+    if (ok)
+    {
+        *first = row;
+    }
+
+    return ok;
+}
+
+static void
+pg_source_iface_init (StylePrintRowSourceInterface *iface)
+{
+    iface->next_batch = pg_source_next_batch;
+    iface->rewind = pg_source_rewind;
+    iface->seek = pg_source_seek;
+}
+
+static StylePrintDataset * qry_get_data (StylePrintPg *self,
+                                          const gchar *qry,
+                                            GPtrArray *params);
+
 void
 style_print_pg_init (StylePrintPg *pg)
 {
     pg->conn = NULL;
     pg->qryParams = NULL;
     pg->externConn = FALSE;
+    pg->fetchSize = 0;
     //pg->pgresult = NULL;
 }
 
@@ -151,6 +486,29 @@ style_print_pg_use_conn(StylePrintPg *self, PGconn *conn)
     self->externConn = TRUE;
 }
 
+/**
+ * style_print_pg_set_fetch_size:
+ * @self: The #StylePrintPg
+ * @rows: The number of rows to retrieve at a time, or 0 to retrieve the
+ * entire result at once
+ *
+ * By default, the entire result of the query is retrieved before the
+ * printout begins.  If @rows is nonzero, the query is instead read
+ * through a cursor, @rows rows at a time, as the printout proceeds, and
+ * rows are released once the pages containing them have been laid out.
+ *
+ * If no transaction is in progress on the connection, one is begun to
+ * hold the cursor, and committed when the printout is finished.
+ */
+
+void
+style_print_pg_set_fetch_size (StylePrintPg *self, guint rows)
+{
+    g_return_if_fail (STYLE_PRINT_IS_PG(self));
+
+    self->fetchSize = rows;
+}
+
 /**
  * style_print_pg_appendParam:
  * @self: The #StylePrintTable *
@@ -227,23 +585,16 @@ style_print_pg_do (StylePrintPg *self, const gchar * qry)
     //PQclear (rslt);     // Simply discard this result
 }
 
-void
-free_data_ary (GHashTable *tbl)
-{
-    g_hash_table_destroy (tbl);
-}
-
 /* ==================================================================== *
- * Retrieve data from the database and convert it to format expected    *
- * by StylePrintTable.                                                  *
+ * Retrieve data from the database and provide it in the form expected  *
+ * by StylePrintTable.  The values are not copied: the dataset returned *
+ * reads them from the PGresult, which it keeps until it is released.   *
  * ==================================================================== */
 
-static GPtrArray *
+static StylePrintDataset *
 qry_get_data (StylePrintPg *self, const gchar *qry, GPtrArray *params)
 {
     PGresult * rslt;
-    GPtrArray *data;
-    gint row;
 
     if ( ! self->conn)
     {
@@ -270,40 +621,102 @@ qry_get_data (StylePrintPg *self, const gchar *qry, GPtrArray *params)
     if (PQresultStatus (rslt) != PGRES_TUPLES_OK)  
     {
         report_err (self, PQresultErrorMessage(rslt));
+        PQclear (rslt);
         return NULL;
     }
 
     if (PQntuples (rslt) == 0)
     {
         report_err (self, "No data returned by query\n");
+        PQclear (rslt);
         return NULL;
     }
 
-    // If we get here, then we have data.  Now convert to GPtrArray->hash
-    data = g_ptr_array_new_with_free_func ((GDestroyNotify)free_data_ary);
+    // If we get here, then we have data.
+    return pg_dataset_new (rslt);
+}
 
-    for (row = 0; row < PQntuples (rslt); row++)
-    {
-        GHashTable *colhash;
-        gint col;
+/* ******************************************************************** *
+ * qry_open_cursor() - Declare a cursor for the query, and return a     *
+ *      row source reading from it.                                     *
+ * ******************************************************************** */
 
-        colhash = g_hash_table_new_full (g_str_hash, g_str_equal,
-                                         g_free, g_free);
+static StylePrintRowSource *
+qry_open_cursor (StylePrintPg *self, const gchar *qry, GPtrArray *params)
+{
+    StylePrintPgSource *src;
+    PGresult *rslt;
+    gchar *declare;
 
-        for (col = 0; col < PQnfields (rslt); col++)
-        {
-            gchar *coldata;
+    src = g_object_new (STYLE_PRINT_TYPE_PG_SOURCE, NULL);
+    src->conn = self->conn;
+    src->fetchsize = self->fetchSize;
+
+    if (PQtransactionStatus (self->conn) == PQTRANS_IDLE)
+    {
+        GError *err = NULL;
 
-            coldata = g_strdup (PQgetvalue (rslt, row, col));
-            g_hash_table_insert (colhash,
-                    g_strdup (PQfname (rslt, col)), coldata);
+        if (!pg_source_command (self->conn, "BEGIN", &err))
+        {
+            report_err (self, err->message);
+            g_error_free (err);
+            g_object_unref (src);
+            return NULL;
         }
-        
-        g_ptr_array_add (data, colhash);
+
+        src->ownxact = TRUE;
+    }
+
+    declare = g_strdup_printf ("DECLARE " PG_CURSOR_NAME
+                                " SCROLL CURSOR FOR %s", qry);
+    rslt = PQexecParams (self->conn,
+                declare,
+                params ? params->len : 0,
+                NULL,       // paramTypes not used
+                params ? (const gchar **)params->pdata : NULL,
+                NULL,       // list of parameter lengths -ignore
+                NULL,
+                0);         // returned formats - make all text
+    g_free (declare);
+
+    if (PQresultStatus (rslt) != PGRES_COMMAND_OK)
+    {
+        report_err (self, PQresultErrorMessage(rslt));
+        PQclear (rslt);
+        g_object_unref (src);      // Commits the transaction, if ours
+        return NULL;
     }
 
     PQclear (rslt);
-    return data;
+    src->declared = TRUE;
+    return STYLE_PRINT_ROW_SOURCE(src);
+}
+
+/* ******************************************************************** *
+ * qry_get_source() - Provide the rows for the query as a row source:   *
+ *      Read through a cursor if a fetch size has been set, else from   *
+ *      the complete result.                                            *
+ * ******************************************************************** */
+
+static StylePrintRowSource *
+qry_get_source (StylePrintPg *self, const gchar *qry, GPtrArray *params)
+{
+    StylePrintDataset *data;
+    StylePrintRowSource *src;
+
+    if (self->fetchSize && self->conn)
+    {
+        return qry_open_cursor (self, qry, params);
+    }
+
+    if (!(data = qry_get_data (self, qry, params)))
+    {
+        return NULL;
+    }
+
+    src = style_print_row_source_new_from_dataset (data);
+    g_object_unref (data);
+    return src;
 }
 
 /**
@@ -325,16 +738,16 @@ style_print_pg_fromxmlfile ( StylePrintPg *pgprnt,
                                  GPtrArray *params,
                                       char *filename)
 {
-    GPtrArray *data;
+    StylePrintRowSource *src;
 
     style_print_table_set_wmain (STYLE_PRINT_TABLE(pgprnt), win);
-    data = qry_get_data (pgprnt, qry, params);
+    src = qry_get_source (pgprnt, qry, params);
 
-    if (data)
+    if (src)
     {
-        style_print_table_from_xmlfile (STYLE_PRINT_TABLE(pgprnt), win,
-                                                            data, filename);
-        g_ptr_array_free (data, TRUE);
+        style_print_table_from_xmlfile_source (STYLE_PRINT_TABLE(pgprnt),
+                                                    win, src, filename);
+        g_object_unref (src);
     }
 
     if (!pgprnt->externConn)
@@ -363,16 +776,16 @@ style_print_pg_fromxmlstring ( StylePrintPg  *pgprnt,
                                    GPtrArray  *params,
                                         char  *xmlstr)
 {
-    GPtrArray *data;
+    StylePrintRowSource *src;
 
     style_print_table_set_wmain (STYLE_PRINT_TABLE(pgprnt), win);
-    data = qry_get_data (pgprnt, qry, params);
+    src = qry_get_source (pgprnt, qry, params);
 
-    if (data)
+    if (src)
     {
-        style_print_table_from_xmlstring (STYLE_PRINT_TABLE(pgprnt), win,
-                                                            data, xmlstr);
-        g_ptr_array_free (data, TRUE);
+        style_print_table_from_xmlstring_source (STYLE_PRINT_TABLE(pgprnt),
+                                                    win, src, xmlstr);
+        g_object_unref (src);
     }
 
     if (!pgprnt->externConn)
@@ -407,16 +820,16 @@ style_print_pg_fromarray (StylePrintPg  *pgprnt,
                              GPtrArray  *params,
                                  gchar **xml)
 {
-    GPtrArray *data;
+    StylePrintRowSource *src;
 
     style_print_table_set_wmain (STYLE_PRINT_TABLE(pgprnt), win);
-    data = qry_get_data (pgprnt, qry, params);
+    src = qry_get_source (pgprnt, qry, params);
 
-    if (data)
+    if (src)
     {
-        style_print_table_from_array (STYLE_PRINT_TABLE(pgprnt), win,
-                                    data, xml);
-        g_ptr_array_free (data, TRUE);
+        style_print_table_from_array_source (STYLE_PRINT_TABLE(pgprnt), win,
+                                    src, xml);
+        g_object_unref (src);
     }
 
     if (!pgprnt->externConn)
@@ -72,6 +72,7 @@ void style_print_pg_fromarray (StylePrintPg  *pgprnt,
 
 void style_print_pg_do ( StylePrintPg *self, const gchar *qry);
 void style_print_pg_appendParam ( StylePrintPg *self, const gchar *param);
+void style_print_pg_set_fetch_size (StylePrintPg *self, guint rows);
 
 G_END_DECLS
 
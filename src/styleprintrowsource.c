@@ -0,0 +1,307 @@
+/*
+Copyright (c) 2017 David Breeding
+
+This file is part of tableprint.
+
+tableprint is free software: you can redistribute it and/or modify
+it under the terms of the Lesser GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+tableprint is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with tableprint (see the files "COPYING" and "COPYING.LESSER").
+If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* ************************************************************************ *
+ * styleprintrowsource.c - The StylePrintRowSource interface, and its       $
+ * implementation for an in-memory StylePrintDataset                        $
+ * $Id::                                                                    $
+ * ************************************************************************ */
+
+#include "styleprintrowsource.h"
+
+/**
+ * SECTION: styleprintrowsource
+ * @Title: StylePrintRowSource
+ * @Short_description: Incremental supply of rows to #StylePrintTable
+ * @See_also: #StylePrintTable, #StylePrintDataset
+ *
+ * #StylePrintRowSource is the interface through which #StylePrintTable
+ * retrieves the rows it prints.  Rather than requiring the whole result
+ * to be held in memory, the printout pulls the rows in batches as it
+ * reaches them, and releases each batch once every row in it lies before
+ * the page being laid out.
+ *
+ * Each call to style_print_row_source_next_batch() returns a new
+ * #StylePrintDataset containing the next rows.  All the batches from one
+ * source must have the same columns, in the same order.
+ *
+ * The pages are drawn from a record made as the document is paginated,
+ * using the rows still held where it can.  Only when a page is drawn
+ * whose first row has already been released - as those of the early
+ * pages of a long document are by the end of pagination - does the
+ * printout call style_print_row_source_seek() to return to that row.  A
+ * source which cannot seek is rewound with style_print_row_source_rewind()
+ * and read forward instead.
+ *
+ * style_print_row_source_new_from_dataset() provides a source for data
+ * which is already held in a #StylePrintDataset.  #StylePrintPg and
+ * #StylePrintMy provide sources reading from a database as the printout
+ * proceeds, see style_print_pg_set_fetch_size() and
+ * style_print_my_set_fetch_size().
+ */
+
+G_DEFINE_INTERFACE(StylePrintRowSource, style_print_row_source, G_TYPE_OBJECT)
+
+G_DEFINE_QUARK(style-print-row-source-error-quark, style_print_row_source_error)
+
+static void
+style_print_row_source_default_init (StylePrintRowSourceInterface *iface)
+{
+}
+
+/**
+ * style_print_row_source_next_batch:
+ * @self: The #StylePrintRowSource
+ * @max_rows: The number of rows wanted.  This is only a hint, the source
+ * may return more or fewer.
+ * @error: Return location for a #GError, or NULL
+ *
+ * Retrieves the next rows from the source.
+ *
+ * Returns: (transfer full) (nullable): A #StylePrintDataset containing at
+ * least one row, or NULL if there are no more rows or an error occurred.
+ */
+
+StylePrintDataset *
+style_print_row_source_next_batch (StylePrintRowSource *self,
+                                                 guint  max_rows,
+                                                GError **error)
+{
+    StylePrintRowSourceInterface *iface;
+
+    g_return_val_if_fail (STYLE_PRINT_IS_ROW_SOURCE(self), NULL);
+
+    iface = STYLE_PRINT_ROW_SOURCE_GET_IFACE(self);
+    return iface->next_batch (self, max_rows, error);
+}
+
+/**
+ * style_print_row_source_rewind:
+ * @self: The #StylePrintRowSource
+ * @error: Return location for a #GError, or NULL
+ *
+ * Repositions the source so that the next batch begins with the first
+ * row again.
+ *
+ * Returns: TRUE on success, FALSE if the source could not be rewound.
+ */
+
+gboolean
+style_print_row_source_rewind (StylePrintRowSource *self, GError **error)
+{
+    StylePrintRowSourceInterface *iface;
+
+    g_return_val_if_fail (STYLE_PRINT_IS_ROW_SOURCE(self), FALSE);
+
+    iface = STYLE_PRINT_ROW_SOURCE_GET_IFACE(self);
+
+    if (!iface->rewind)
+    {
+        g_set_error_literal (error, STYLE_PRINT_ROW_SOURCE_ERROR,
+                STYLE_PRINT_ROW_SOURCE_ERROR_REWIND,
+                "This row source cannot be rewound");
+        return FALSE;
+    }
+
+    return iface->rewind (self, error);
+}
+
+/**
+ * style_print_row_source_seek:
+ * @self: The #StylePrintRowSource
+ * @row: The number of the row wanted, counting from 0
+ * @first: (out): Return location for the number of the first row of the
+ * next batch
+ * @error: Return location for a #GError, or NULL
+ *
+ * Repositions the source so that the next batch holds row @row, and sets
+ * @first to the number of its first row, which may precede @row.  A
+ * source which can reach a row directly (the rows of a dataset, or a
+ * database cursor) implements the @seek method, so that a printout can
+ * draw a page late in the report without reading every row before it.
+ * Any other source is rewound, and @first set to 0.
+ *
+ * Returns: TRUE on success, FALSE if the source could not be positioned.
+ */
+
+gboolean
+style_print_row_source_seek (StylePrintRowSource *self, guint row,
+                             guint *first, GError **error)
+{
+    StylePrintRowSourceInterface *iface;
+
+    g_return_val_if_fail (STYLE_PRINT_IS_ROW_SOURCE(self), FALSE);
+    g_return_val_if_fail (first != NULL, FALSE);
+
+    iface = STYLE_PRINT_ROW_SOURCE_GET_IFACE(self);
+
+    if (!iface->seek)
+    {
+        *first = 0;
+        return style_print_row_source_rewind (self, error);
+    }
+
+    return iface->seek (self, row, first, error);
+}
+
+/**
+ * style_print_row_source_set_key_columns:
+ * @self: The #StylePrintRowSource
+ * @names: (array zero-terminated=1): The names of the columns
+ *
+ * Tells the source which columns the printout is grouped on.  These
+ * usually hold few distinct values, so a source which builds its batches
+ * in memory can dictionary-encode them (see
+ * style_print_dataset_encode_column()).  #StylePrintTable calls this once
+ * the columns are bound, which is after the first batch has been fetched.
+ * A source need not act on it.
+ */
+
+void
+style_print_row_source_set_key_columns (StylePrintRowSource *self,
+                                       const gchar * const *names)
+{
+    StylePrintRowSourceInterface *iface;
+
+    g_return_if_fail (STYLE_PRINT_IS_ROW_SOURCE(self));
+
+    iface = STYLE_PRINT_ROW_SOURCE_GET_IFACE(self);
+
+    if (iface->set_key_columns)
+    {
+        iface->set_key_columns (self, names);
+    }
+}
+
+/* ==================================================================== *
+ * StylePrintDatasetSource - A row source providing the rows of a       *
+ *      #StylePrintDataset, as a single batch.                          *
+ * ==================================================================== */
+
+#define STYLE_PRINT_TYPE_DATASET_SOURCE (style_print_dataset_source_get_type())
+
+G_DECLARE_FINAL_TYPE(StylePrintDatasetSource, style_print_dataset_source, STYLE_PRINT, DATASET_SOURCE, GObject)
+
+struct _StylePrintDatasetSource
+{
+    GObject parent_instance;
+
+    /*< private >*/
+    StylePrintDataset *data;
+    gboolean           taken;   // TRUE once the batch has been returned
+};
+
+static void dataset_source_iface_init (StylePrintRowSourceInterface *);
+
+G_DEFINE_TYPE_WITH_CODE(StylePrintDatasetSource, style_print_dataset_source,
+                G_TYPE_OBJECT,
+                G_IMPLEMENT_INTERFACE(STYLE_PRINT_TYPE_ROW_SOURCE,
+                                        dataset_source_iface_init))
+
+static void
+style_print_dataset_source_init (StylePrintDatasetSource *self)
+{
+    self->data = NULL;
+    self->taken = FALSE;
+}
+
+static void
+style_print_dataset_source_finalize (GObject *object)
+{
+    StylePrintDatasetSource *self = STYLE_PRINT_DATASET_SOURCE(object);
+
+    g_clear_object (&self->data);
+
+    G_OBJECT_CLASS(style_print_dataset_source_parent_class)->finalize (object);
+}
+
+static void
+style_print_dataset_source_class_init (StylePrintDatasetSourceClass *class)
+{
+    GObjectClass *gobject_class = (GObjectClass *) class;
+
+    gobject_class->finalize = style_print_dataset_source_finalize;
+}
+
+static StylePrintDataset *
+dataset_source_next_batch (StylePrintRowSource *src, guint max_rows,
+                                                    GError **error)
+{
+    StylePrintDatasetSource *self = STYLE_PRINT_DATASET_SOURCE(src);
+
+    if (self->taken || !self->data ||
+                (style_print_dataset_get_n_rows (self->data) == 0))
+    {
+        return NULL;
+    }
+
+    self->taken = TRUE;
+    return g_object_ref (self->data);
+}
+
+static gboolean
+dataset_source_rewind (StylePrintRowSource *src, GError **error)
+{
+    STYLE_PRINT_DATASET_SOURCE(src)->taken = FALSE;
+    return TRUE;
+}
+
+// The whole dataset is the one batch, so every row is reached by
+// returning it again, without copying anything
+static gboolean
+dataset_source_seek (StylePrintRowSource *src, guint row, guint *first,
+                                                GError **error)
+{
+    STYLE_PRINT_DATASET_SOURCE(src)->taken = FALSE;
+    *first = 0;
+    return TRUE;
+}
+
+static void
+dataset_source_iface_init (StylePrintRowSourceInterface *iface)
+{
+    iface->next_batch = dataset_source_next_batch;
+    iface->rewind = dataset_source_rewind;
+    iface->seek = dataset_source_seek;
+}
+
+/**
+ * style_print_row_source_new_from_dataset:
+ * @data: (nullable): The #StylePrintDataset to provide
+ *
+ * Creates a #StylePrintRowSource which provides the rows of @data.  The
+ * dataset is returned whole, as a single batch, and is not copied.
+ *
+ * Returns: (transfer full): A new #StylePrintRowSource
+ */
+
+StylePrintRowSource *
+style_print_row_source_new_from_dataset (StylePrintDataset *data)
+{
+    StylePrintDatasetSource *self = g_object_new (
+                                    STYLE_PRINT_TYPE_DATASET_SOURCE, NULL);
+
+    if (data)
+    {
+        self->data = g_object_ref (data);
+    }
+
+    return STYLE_PRINT_ROW_SOURCE(self);
+}
@@ -0,0 +1,113 @@
+/*
+Copyright (c) 2017 David Breeding
+
+This file is part of tableprint.
+
+tableprint is free software: you can redistribute it and/or modify
+it under the terms of the Lesser GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+tableprint is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with tableprint (see the files "COPYING" and "COPYING.LESSER").
+If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* ************************************************************************ *
+ * styleprintrowsource.h - Header file for StylePrintRowSource, the         *
+ * interface through which StylePrintTable pulls its rows                   *
+ * ************************************************************************ */
+
+#ifndef __STYLE_PRINT_ROW_SOURCE_H
+#define __STYLE_PRINT_ROW_SOURCE_H
+
+#ifdef _cplusplus
+extern "C"
+{       //}     // To make vim quit trying to indent...
+#endif
+
+#include <glib-object.h>
+#include <glib.h>
+#include <styleprintdataset.h>
+
+G_BEGIN_DECLS
+
+#define STYLE_PRINT_TYPE_ROW_SOURCE (style_print_row_source_get_type())
+
+G_DECLARE_INTERFACE(StylePrintRowSource, style_print_row_source, STYLE_PRINT, ROW_SOURCE, GObject)
+
+#define STYLE_PRINT_ROW_SOURCE_ERROR (style_print_row_source_error_quark())
+
+/**
+ * StylePrintRowSourceError:
+ * @STYLE_PRINT_ROW_SOURCE_ERROR_FAILED: The rows could not be retrieved
+ * @STYLE_PRINT_ROW_SOURCE_ERROR_REWIND: The source cannot be rewound
+ *
+ */
+
+typedef enum {
+    STYLE_PRINT_ROW_SOURCE_ERROR_FAILED,
+    STYLE_PRINT_ROW_SOURCE_ERROR_REWIND
+} StylePrintRowSourceError;
+
+/**
+ * StylePrintRowSourceInterface:
+ * @g_iface: The parent interface
+ * @next_batch: Returns a new #StylePrintDataset holding the next rows,
+ * or NULL when there are no more rows (or on error)
+ * @rewind: Repositions the source at its first row
+ * @set_key_columns: Optional.  Names the columns the printout is grouped
+ * on, so that the source can dictionary-encode them as it loads them
+ * @seek: Optional.  Repositions the source so that the next batch holds a
+ * given row, setting the number of the batch's first row.  A source
+ * without it is rewound instead.
+ *
+ */
+
+struct _StylePrintRowSourceInterface
+{
+    GTypeInterface g_iface;
+
+    StylePrintDataset * (*next_batch) (StylePrintRowSource *self,
+                                                     guint  max_rows,
+                                                    GError **error);
+    gboolean            (*rewind)     (StylePrintRowSource *self,
+                                                    GError **error);
+    void        (*set_key_columns)    (StylePrintRowSource *self,
+                                        const gchar * const *names);
+    gboolean            (*seek)       (StylePrintRowSource *self,
+                                                      guint  row,
+                                                      guint *first,
+                                                    GError **error);
+};
+
+GQuark style_print_row_source_error_quark (void);
+
+StylePrintDataset *style_print_row_source_next_batch (
+                                            StylePrintRowSource *self,
+                                                          guint  max_rows,
+                                                         GError **error);
+gboolean style_print_row_source_rewind (StylePrintRowSource *self,
+                                                     GError **error);
+gboolean style_print_row_source_seek (StylePrintRowSource *self,
+                                                    guint  row,
+                                                    guint *first,
+                                                  GError **error);
+void style_print_row_source_set_key_columns (StylePrintRowSource *self,
+                                            const gchar * const *names);
+
+StylePrintRowSource *style_print_row_source_new_from_dataset (
+                                            StylePrintDataset *data);
+
+G_END_DECLS
+
+#ifdef _cplusplus
+}
+#endif
+
+#endif      //ifndef __STYLE_PRINT_ROW_SOURCE_H
@@ -0,0 +1,693 @@
+/*
+Copyright (c) 2017 David Breeding
+
+This file is part of tableprint.
+
+tableprint is free software: you can redistribute it and/or modify
+it under the terms of the Lesser GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+tableprint is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with tableprint (see the files "COPYING" and "COPYING.LESSER").
+If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* ************************************************************************ *
+ * styleprintspill.c - Write the rows of a StylePrintRowSource to a         $
+ * columnar file, and read them back through a memory mapping               $
+ *                                                                          $
+ * File layout (all integers in the byte order of the writing machine):     $
+ *                                                                          $
+ *   SPILLHDR           Magic, byte order mark, counts, and the offsets of  $
+ *                      the block directory and the column names.           $
+ *   Blocks             Up to SPILL_BLOCK_ROWS rows each.  Within a block,  $
+ *                      each column in turn: (nrows + 1) guint32 offsets    $
+ *                      into the column's heap, then the heap, which holds  $
+ *                      the values, each followed by a NUL.  A NULL value   $
+ *                      occupies no bytes at all, so it is recognized by    $
+ *                      its offset being equal to the next one.  Each       $
+ *                      column is padded to a multiple of 8 bytes.          $
+ *   Block directory    For each block, (2 + ncols) guint64's: the number   $
+ *                      of its first row, its row count, and the file       $
+ *                      offset of each column's offset array.               $
+ *   Column names       NUL-terminated, in column order.                    $
+ * $Id::                                                                    $
+ * ************************************************************************ */
+
+#include <string.h>
+#include <errno.h>
+#include <glib/gstdio.h>
+#include "styleprintspill.h"
+
+/**
+ * SECTION: styleprintspill
+ * @Title: Spill Files
+ * @Short_description: On-disk columnar storage for very large printouts
+ * @See_also: #StylePrintDataset, #StylePrintRowSource
+ *
+ * Where the data for a printout is too large to be held in memory, it can
+ * be written to a spill file with style_print_spill_write() and read back
+ * with style_print_spill_open().  The file is mapped into memory read-only,
+ * so its values are read from the page cache as they are printed, and
+ * pages which are no longer needed can be discarded by the system rather
+ * than occupying the heap.
+ *
+ * The file stores the values by column, in blocks of rows, and so a cell
+ * value is located with a few array indexes, without parsing.
+ *
+ * style_print_table_set_spill_file() causes #StylePrintTable to do this
+ * automatically for every printout.
+ *
+ * A spill file is intended as temporary storage on the machine which wrote
+ * it: it is not portable between machines of differing byte order.
+ */
+
+#define SPILL_MAGIC "STPSPILL"
+#define SPILL_VERSION 1
+#define SPILL_BOM 0x01020304
+#define SPILL_BLOCK_ROWS 4096
+
+typedef struct {
+    gchar   magic[8];
+    guint32 bom;            // Byte order mark
+    guint32 version;
+    guint32 ncols;
+    guint32 nblocks;
+    guint64 nrows;
+    guint64 diroffset;      // Block directory
+    guint64 namesoffset;    // Column names
+} SPILLHDR;
+
+// Number of guint64's in each block directory entry
+#define SPILL_DIRENT(ncols) (2 + (ncols))
+
+G_DEFINE_QUARK(style-print-spill-error-quark, style_print_spill_error)
+
+/* ==================================================================== *
+ * Writing                                                              *
+ * ==================================================================== */
+
+typedef struct {
+    FILE    *fp;
+    guint64  pos;           // Current file offset
+    guint    ncols;
+    guint64  nrows;
+    GArray  *dir;           // The block directory (guint64)
+    GArray  *offs;          // Offsets for the column being written
+    GString *heap;          // Heap for the column being written
+} SPILLWRITER;
+
+/* ******************************************************************** *
+ * spill_put() - Write "len" bytes to the spill file                    *
+ * ******************************************************************** */
+
+static gboolean
+spill_put (SPILLWRITER *w, gconstpointer data, gsize len, GError **error)
+{
+    if (len && (fwrite (data, 1, len, w->fp) != len))
+    {
+        g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (errno),
+                "Failed to write spill file: %s", g_strerror (errno));
+        return FALSE;
+    }
+
+    w->pos += len;
+    return TRUE;
+}
+
+/* ******************************************************************** *
+ * spill_pad() - Pad the file to a multiple of 8 bytes                  *
+ * ******************************************************************** */
+
+static gboolean
+spill_pad (SPILLWRITER *w, GError **error)
+{
+    static const gchar zeros[8];
+
+    return spill_put (w, zeros, (8 - (w->pos % 8)) % 8, error);
+}
+
+/* ******************************************************************** *
+ * spill_write_block() - Write rows "first" through "first + nrows - 1" *
+ *      of "batch" as one block.  colmap gives the index in the batch   *
+ *      of each column of the file.                                     *
+ * ******************************************************************** */
+
+static gboolean
+spill_write_block (SPILLWRITER *w, StylePrintDataset *batch,
+                    const gint *colmap, guint first, guint nrows,
+                    GError **error)
+{
+    guint64 entry[2];
+    guint col, row;
+
+    entry[0] = w->nrows;
+    entry[1] = nrows;
+    g_array_append_vals (w->dir, entry, 2);
+
+    for (col = 0; col < w->ncols; col++)
+    {
+        guint32 off;
+
+        g_array_append_val (w->dir, w->pos);
+        g_array_set_size (w->offs, 0);
+        g_string_truncate (w->heap, 0);
+
+        for (row = first; row < first + nrows; row++)
+        {
+            gsize len;
+            const gchar *val = style_print_dataset_get_slice (batch, row,
+                                                    colmap[col], &len);
+
+            off = w->heap->len;
+            g_array_append_val (w->offs, off);
+
+            if (val)
+            {
+                g_string_append_len (w->heap, val, len);
+                g_string_append_c (w->heap, '\0');
+            }
+        }
+
+        if (w->heap->len > G_MAXUINT32)
+        {
+            g_set_error_literal (error, STYLE_PRINT_SPILL_ERROR,
+                    STYLE_PRINT_SPILL_ERROR_TOO_LARGE,
+                    "Column data too large for a spill file block");
+            return FALSE;
+        }
+
+        off = w->heap->len;
+        g_array_append_val (w->offs, off);
+
+        if (!spill_put (w, w->offs->data, w->offs->len * sizeof (guint32),
+                                                                error) ||
+            !spill_put (w, w->heap->str, w->heap->len, error) ||
+            !spill_pad (w, error))
+        {
+            return FALSE;
+        }
+    }
+
+    w->nrows += nrows;
+    return TRUE;
+}
+
+/**
+ * style_print_spill_write:
+ * @source: The #StylePrintRowSource providing the rows
+ * @filename: The name of the file to create
+ * @error: Return location for a #GError, or NULL
+ *
+ * Reads all the remaining rows from @source and writes them to the spill
+ * file @filename, replacing it if it exists.  The file can then be read
+ * with style_print_spill_open().
+ *
+ * The columns of the file are those of the first batch.  Later batches
+ * are matched to them by name.
+ *
+ * Returns: TRUE on success
+ */
+
+gboolean
+style_print_spill_write (StylePrintRowSource *source,
+                                 const gchar *filename,
+                                      GError **error)
+{
+    SPILLWRITER w;
+    SPILLHDR hdr;
+    StylePrintDataset *batch;
+    GPtrArray *names;
+    GError *err = NULL;
+    gint *colmap = NULL;
+    gboolean ok = TRUE;
+    guint col;
+
+    g_return_val_if_fail (STYLE_PRINT_IS_ROW_SOURCE(source), FALSE);
+    g_return_val_if_fail (filename != NULL, FALSE);
+
+    if (!(w.fp = g_fopen (filename, "wb")))
+    {
+        g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (errno),
+                "Failed to create spill file '%s': %s", filename,
+                g_strerror (errno));
+        return FALSE;
+    }
+
+    w.pos = 0;
+    w.ncols = 0;
+    w.nrows = 0;
+    w.dir = g_array_new (FALSE, FALSE, sizeof (guint64));
+    w.offs = g_array_new (FALSE, FALSE, sizeof (guint32));
+    w.heap = g_string_new (NULL);
+    names = g_ptr_array_new_with_free_func (g_free);
+
+    // The header is written again, complete, once the rest is written
+    memset (&hdr, 0, sizeof (hdr));
+    ok = spill_put (&w, &hdr, sizeof (hdr), error);
+
+    while (ok && (batch = style_print_row_source_next_batch (source,
+                                        SPILL_BLOCK_ROWS, &err)))
+    {
+        guint nrows = style_print_dataset_get_n_rows (batch);
+        guint first;
+
+        if (!colmap)
+        {
+            // The first batch sets the columns of the file
+            w.ncols = style_print_dataset_get_n_columns (batch);
+            colmap = g_new (gint, w.ncols ? w.ncols : 1);
+
+            for (col = 0; col < w.ncols; col++)
+            {
+                g_ptr_array_add (names, g_strdup (
+                        style_print_dataset_get_column_name (batch, col)));
+            }
+        }
+
+        for (col = 0; col < w.ncols; col++)
+        {
+            colmap[col] = style_print_dataset_get_column_index (batch,
+                                        g_ptr_array_index (names, col));
+
+            if (colmap[col] < 0)
+            {
+                g_set_error (error, STYLE_PRINT_SPILL_ERROR,
+                        STYLE_PRINT_SPILL_ERROR_SCHEMA,
+                        "Column '%s' is missing from a batch",
+                        (gchar *)g_ptr_array_index (names, col));
+                ok = FALSE;
+                break;
+            }
+        }
+
+        for (first = 0; ok && (first < nrows); first += SPILL_BLOCK_ROWS)
+        {
+            ok = spill_write_block (&w, batch, colmap, first,
+                            MIN (SPILL_BLOCK_ROWS, nrows - first), error);
+        }
+
+        g_object_unref (batch);
+
+        if (w.nrows > G_MAXINT)
+        {
+            g_set_error_literal (error, STYLE_PRINT_SPILL_ERROR,
+                    STYLE_PRINT_SPILL_ERROR_TOO_LARGE,
+                    "Too many rows for a spill file");
+            ok = FALSE;
+        }
+    }
+
+    if (err)
+    {
+        g_propagate_error (error, err);
+        ok = FALSE;
+    }
+
+    if (ok)
+    {
+        memcpy (hdr.magic, SPILL_MAGIC, sizeof (hdr.magic));
+        hdr.bom = SPILL_BOM;
+        hdr.version = SPILL_VERSION;
+        hdr.ncols = w.ncols;
+        hdr.nblocks = w.dir->len / SPILL_DIRENT(w.ncols);
+        hdr.nrows = w.nrows;
+        hdr.diroffset = w.pos;
+        ok = spill_put (&w, w.dir->data, w.dir->len * sizeof (guint64),
+                                                                error);
+        hdr.namesoffset = w.pos;
+
+        for (col = 0; ok && (col < w.ncols); col++)
+        {
+            const gchar *name = g_ptr_array_index (names, col);
+
+            ok = spill_put (&w, name ? name : "",
+                            (name ? strlen (name) : 0) + 1, error);
+        }
+    }
+
+    if (ok && (fseek (w.fp, 0, SEEK_SET) ||
+                    !spill_put (&w, &hdr, sizeof (hdr), error)))
+    {
+        if (error && !*error)
+        {
+            g_set_error (error, G_FILE_ERROR,
+                    g_file_error_from_errno (errno),
+                    "Failed to write spill file: %s", g_strerror (errno));
+        }
+
+        ok = FALSE;
+    }
+
+    if (fclose (w.fp) && ok)
+    {
+        g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (errno),
+                "Failed to write spill file: %s", g_strerror (errno));
+        ok = FALSE;
+    }
+
+    if (!ok)
+    {
+        g_remove (filename);
+    }
+
+    g_free (colmap);
+    g_ptr_array_free (names, TRUE);
+    g_string_free (w.heap, TRUE);
+    g_array_free (w.offs, TRUE);
+    g_array_free (w.dir, TRUE);
+    return ok;
+}
+
+/* ==================================================================== *
+ * StylePrintSpillDataset - A #StylePrintDataset reading the values     *
+ *      from a memory mapping of a spill file.                          *
+ * ==================================================================== */
+
+#define STYLE_PRINT_TYPE_SPILL_DATASET (style_print_spill_dataset_get_type())
+
+G_DECLARE_FINAL_TYPE(StylePrintSpillDataset, style_print_spill_dataset, STYLE_PRINT, SPILL_DATASET, StylePrintDataset)
+
+struct _StylePrintSpillDataset
+{
+    StylePrintDataset parent_instance;
+
+    /*< private >*/
+    GMappedFile   *map;
+    const gchar   *base;
+    guint          ncols;
+    guint          nrows;
+    guint          nblocks;
+    const guint64 *dir;         // The block directory
+    GPtrArray     *names;       // Column names, pointing into the map
+    GHashTable    *colindex;    // Column name => index + 1
+    guint          curblock;    // The block last accessed
+};
+
+G_DEFINE_TYPE(StylePrintSpillDataset, style_print_spill_dataset,
+                                            STYLE_PRINT_TYPE_DATASET)
+
+static void
+style_print_spill_dataset_init (StylePrintSpillDataset *self)
+{
+    self->map = NULL;
+    self->names = g_ptr_array_new ();
+    self->colindex = g_hash_table_new (g_str_hash, g_str_equal);
+    self->curblock = 0;
+}
+
+static void
+style_print_spill_dataset_finalize (GObject *object)
+{
+    StylePrintSpillDataset *self = STYLE_PRINT_SPILL_DATASET(object);
+
+    g_hash_table_destroy (self->colindex);
+    g_ptr_array_free (self->names, TRUE);
+
+    if (self->map)
+    {
+        g_mapped_file_unref (self->map);
+    }
+
+    G_OBJECT_CLASS(style_print_spill_dataset_parent_class)->finalize (object);
+}
+
+static guint
+spill_dataset_get_n_rows (StylePrintDataset *ds)
+{
+    return STYLE_PRINT_SPILL_DATASET(ds)->nrows;
+}
+
+/* ******************************************************************** *
+ * spill_find_block() - Return the directory entry for the block which  *
+ *      contains "row".  Rows are usually read in sequence, so the      *
+ *      block used last, and the one following it, are tried before     *
+ *      searching.                                                      *
+ * ******************************************************************** */
+
+static const guint64 *
+spill_find_block (StylePrintSpillDataset *self, guint row)
+{
+    guint entsize = SPILL_DIRENT(self->ncols);
+    guint blk = self->curblock;
+    guint lo, hi;
+    const guint64 *ent = self->dir + blk * entsize;
+
+    if ((row >= ent[0]) && (row < ent[0] + ent[1]))
+    {
+        return ent;
+    }
+
+    if ((blk + 1 < self->nblocks) && (row >= ent[0] + ent[1]))
+    {
+        ent += entsize;
+
+        if (row < ent[0] + ent[1])
+        {
+            self->curblock = blk + 1;
+            return ent;
+        }
+    }
+
+    lo = 0;
+    hi = self->nblocks;
+
+    while (hi - lo > 1)
+    {
+        guint mid = (lo + hi) / 2;
+
+        if (self->dir[mid * entsize] <= row)
+        {
+            lo = mid;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+
+    self->curblock = lo;
+    return self->dir + lo * entsize;
+}
+
+static const gchar *
+spill_dataset_get_value (StylePrintDataset *ds, guint row, guint col)
+{
+    StylePrintSpillDataset *self = STYLE_PRINT_SPILL_DATASET(ds);
+    const guint64 *ent = spill_find_block (self, row);
+    const guint32 *offs = (const guint32 *)(self->base + ent[2 + col]);
+    guint r = row - ent[0];
+
+    if (offs[r] == offs[r + 1])
+    {
+        return NULL;
+    }
+
+    return (const gchar *)(offs + ent[1] + 1) + offs[r];
+}
+
+static const gchar *
+spill_dataset_get_slice (StylePrintDataset *ds, guint row, guint col,
+                                                        gsize *len)
+{
+    StylePrintSpillDataset *self = STYLE_PRINT_SPILL_DATASET(ds);
+    const guint64 *ent = spill_find_block (self, row);
+    const guint32 *offs = (const guint32 *)(self->base + ent[2 + col]);
+    guint r = row - ent[0];
+
+    if (offs[r] == offs[r + 1])
+    {
+        *len = 0;
+        return NULL;
+    }
+
+    *len = offs[r + 1] - offs[r] - 1;   // Less the terminating NUL
+    return (const gchar *)(offs + ent[1] + 1) + offs[r];
+}
+
+static guint
+spill_dataset_get_n_columns (StylePrintDataset *ds)
+{
+    return STYLE_PRINT_SPILL_DATASET(ds)->ncols;
+}
+
+static const gchar *
+spill_dataset_get_column_name (StylePrintDataset *ds, guint col)
+{
+    StylePrintSpillDataset *self = STYLE_PRINT_SPILL_DATASET(ds);
+
+    return col < self->names->len ? g_ptr_array_index (self->names, col)
+                                  : NULL;
+}
+
+static gint
+spill_dataset_get_column_index (StylePrintDataset *ds, const gchar *name)
+{
+    return GPOINTER_TO_INT(g_hash_table_lookup (
+                    STYLE_PRINT_SPILL_DATASET(ds)->colindex, name)) - 1;
+}
+
+static void
+style_print_spill_dataset_class_init (StylePrintSpillDatasetClass *class)
+{
+    GObjectClass *gobject_class = (GObjectClass *) class;
+    StylePrintDatasetClass *ds_class = (StylePrintDatasetClass *) class;
+
+    gobject_class->finalize = style_print_spill_dataset_finalize;
+
+    ds_class->get_n_rows = spill_dataset_get_n_rows;
+    ds_class->get_value = spill_dataset_get_value;
+    ds_class->get_slice = spill_dataset_get_slice;
+    ds_class->get_n_columns = spill_dataset_get_n_columns;
+    ds_class->get_column_name = spill_dataset_get_column_name;
+    ds_class->get_column_index = spill_dataset_get_column_index;
+}
+
+/* ******************************************************************** *
+ * spill_check() - Validate the header, block directory and column      *
+ *      names of a mapped spill file, and set up "self" to read it.     *
+ *      Only the structure is checked: the values themselves are not    *
+ *      touched until they are printed.                                 *
+ * ******************************************************************** */
+
+static gboolean
+spill_check (StylePrintSpillDataset *self, gsize len)
+{
+    const SPILLHDR *hdr = (const SPILLHDR *)self->base;
+    guint64 dirsize, nextrow = 0;
+    const gchar *name;
+    guint blk, col;
+
+    if (!self->base || (len < sizeof (SPILLHDR)) ||
+            memcmp (hdr->magic, SPILL_MAGIC, sizeof (hdr->magic)) ||
+            (hdr->bom != SPILL_BOM) || (hdr->version != SPILL_VERSION) ||
+            (hdr->nrows > G_MAXINT))
+    {
+        return FALSE;
+    }
+
+    dirsize = (guint64)hdr->nblocks * SPILL_DIRENT((guint64)hdr->ncols) *
+                                                    sizeof (guint64);
+
+    if ((hdr->diroffset % 8) || (hdr->diroffset > len) ||
+            (dirsize > len - hdr->diroffset) || (hdr->namesoffset > len))
+    {
+        return FALSE;
+    }
+
+    self->ncols = hdr->ncols;
+    self->nrows = hdr->nrows;
+    self->nblocks = hdr->nblocks;
+    self->dir = (const guint64 *)(self->base + hdr->diroffset);
+
+    for (blk = 0; blk < self->nblocks; blk++)
+    {
+        const guint64 *ent = self->dir + blk * SPILL_DIRENT(self->ncols);
+
+        if ((ent[0] != nextrow) || (ent[1] == 0) ||
+                (ent[1] > SPILL_BLOCK_ROWS))
+        {
+            return FALSE;
+        }
+
+        nextrow += ent[1];
+
+        for (col = 0; col < self->ncols; col++)
+        {
+            guint64 off = ent[2 + col];
+            guint64 offsize = (ent[1] + 1) * sizeof (guint32);
+            const guint32 *offs;
+
+            if ((off % 4) || (off > len) || (offsize > len - off))
+            {
+                return FALSE;
+            }
+
+            offs = (const guint32 *)(self->base + off);
+
+            if (offs[ent[1]] > len - off - offsize)
+            {
+                return FALSE;
+            }
+        }
+    }
+
+    if (nextrow != self->nrows)
+    {
+        return FALSE;
+    }
+
+    name = self->base + hdr->namesoffset;
+
+    for (col = 0; col < self->ncols; col++)
+    {
+        const gchar *end = memchr (name, '\0',
+                                    self->base + len - name);
+
+        if (!end)
+        {
+            return FALSE;
+        }
+
+        g_ptr_array_add (self->names, (gpointer)name);
+
+        // If a name is repeated, the first column of that name is found
+        if (!g_hash_table_contains (self->colindex, name))
+        {
+            g_hash_table_insert (self->colindex, (gpointer)name,
+                                        GINT_TO_POINTER(col + 1));
+        }
+
+        name = end + 1;
+    }
+
+    return TRUE;
+}
+
+/**
+ * style_print_spill_open:
+ * @filename: The name of the spill file
+ * @error: Return location for a #GError, or NULL
+ *
+ * Maps a spill file written by style_print_spill_write() into memory and
+ * provides its contents as a #StylePrintDataset.  The file remains mapped
+ * until the dataset is finalized.  It may be removed while mapped.
+ *
+ * Returns: (transfer full) (nullable): A new #StylePrintDataset, or NULL on
+ * error.
+ */
+
+StylePrintDataset *
+style_print_spill_open (const gchar *filename, GError **error)
+{
+    StylePrintSpillDataset *self;
+    GMappedFile *map;
+
+    g_return_val_if_fail (filename != NULL, NULL);
+
+    if (!(map = g_mapped_file_new (filename, FALSE, error)))
+    {
+        return NULL;
+    }
+
+    self = g_object_new (STYLE_PRINT_TYPE_SPILL_DATASET, NULL);
+    self->map = map;
+    self->base = g_mapped_file_get_contents (map);
+
+    if (!spill_check (self, g_mapped_file_get_length (map)))
+    {
+        g_set_error (error, STYLE_PRINT_SPILL_ERROR,
+                STYLE_PRINT_SPILL_ERROR_FORMAT,
+                "'%s' is not a valid spill file", filename);
+        g_object_unref (self);
+        return NULL;
+    }
+
+    return STYLE_PRINT_DATASET(self);
+}
@@ -0,0 +1,72 @@
+/*
+Copyright (c) 2017 David Breeding
+
+This file is part of tableprint.
+
+tableprint is free software: you can redistribute it and/or modify
+it under the terms of the Lesser GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+tableprint is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with tableprint (see the files "COPYING" and "COPYING.LESSER").
+If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* ************************************************************************ *
+ * styleprintspill.h - Header file for the on-disk columnar spill file      *
+ * ************************************************************************ */
+
+#ifndef __STYLE_PRINT_SPILL_H
+#define __STYLE_PRINT_SPILL_H
+
+#ifdef _cplusplus
+extern "C"
+{       //}     // To make vim quit trying to indent...
+#endif
+
+#include <glib-object.h>
+#include <glib.h>
+#include <styleprintdataset.h>
+#include <styleprintrowsource.h>
+
+G_BEGIN_DECLS
+
+#define STYLE_PRINT_SPILL_ERROR (style_print_spill_error_quark())
+
+/**
+ * StylePrintSpillError:
+ * @STYLE_PRINT_SPILL_ERROR_FORMAT: The file is not a valid spill file
+ * @STYLE_PRINT_SPILL_ERROR_SCHEMA: A batch did not have the columns of
+ * the first batch
+ * @STYLE_PRINT_SPILL_ERROR_TOO_LARGE: The data exceeds the limits of the
+ * file format
+ *
+ */
+
+typedef enum {
+    STYLE_PRINT_SPILL_ERROR_FORMAT,
+    STYLE_PRINT_SPILL_ERROR_SCHEMA,
+    STYLE_PRINT_SPILL_ERROR_TOO_LARGE
+} StylePrintSpillError;
+
+GQuark style_print_spill_error_quark (void);
+
+gboolean style_print_spill_write (StylePrintRowSource *source,
+                                          const gchar *filename,
+                                               GError **error);
+StylePrintDataset *style_print_spill_open (const gchar *filename,
+                                                GError **error);
+
+G_END_DECLS
+
+#ifdef _cplusplus
+}
+#endif
+
+#endif      //ifndef __STYLE_PRINT_SPILL_H
@@ -45,6 +45,8 @@ If not, see <http://www.gnu.org/licenses/>.
 #include <pango/pango.h>
 #include <glib-object.h>
 #include <cairo.h>
+#include <cairo-pdf.h>
+#include <glib/gstdio.h>
 #include "styleprinttablepriv.h"
 
 /**
@@ -62,8 +64,17 @@ If not, see <http://www.gnu.org/licenses/>.
  * new group when the entry for the field determining that group changes.
  * If the data being printed comes from a database, this can be controlled
  * by an "ORDER BY" clause in the query.
+ * The data may also be provided as a #StylePrintDataset, which stores it by
+ * column and is what is used internally - a #GPtrArray passed to the
+ * functions below is converted to a #StylePrintDataset before printing.
  * The formatting of the printout is defined by an XML document, either
- * provided from a file, or an embedded string.
+ * provided from a file, or an embedded string.  The document is parsed into
+ * a #StylePrintTemplate.  A template parsed from a file is kept in a cache
+ * so that a file that is printed repeatedly is only parsed once; a string
+ * is parsed for each printout, since it may differ every time.  A template
+ * can also be created directly, or looked up in the cache with
+ * style_print_template_lookup_string(), and printed with
+ * style_print_table_print().
  *
  * To print a document, you first create a #StylePrintTable object with
  * style_print_table_new().  You then begin printing by calling the
@@ -94,6 +105,22 @@ If not, see <http://www.gnu.org/licenses/>.
  *
  * There is no need to set up the "begin_print" or "draw_page" callbacks,
  * because this object handles this setup itself.
+ *
+ * Threads: everything a printout needs is held by its #StylePrintTable, and
+ * the library keeps no global state other than the template cache, which
+ * is locked.  Several #StylePrintTable objects may therefore print at the
+ * same time on different threads, subject to these rules:
+ *
+ * - A #StylePrintTable, and the #StylePrintRowSource or #StylePrintDataset
+ *   it is printing, must only be used by one thread at a time.
+ *
+ * - A #StylePrintTemplate is never modified once created, so one template
+ *   may be printed by any number of threads at once.  The
+ *   style_print_template_lookup_*() functions may be called from any thread.
+ *
+ * - GTK's own rules still apply to the #GtkPrintOperation itself: a
+ *   printout which shows a dialog must be run from the thread running the
+ *   GTK main loop.
  */
 
 typedef struct _StylePrintTablePrivate StylePrintTablePrivate;
@@ -102,25 +129,54 @@ struct _StylePrintTablePrivate
 {
     GtkWindow *w_main;
 
-    // Connection Variables
-    GPtrArray *pgresult;     // Pointer to the PostGreSQL PGresult
-
-    // Headers
-    GRPINF *DocHeader;  // The Document Header (header for first page)
-    GRPINF *PageHeader; // The Pagheader (header for each page)
-    GRPINF *grpHd;
+    // The data to print.  Rows are pulled from the source in batches as
+    // the printout reaches them.  "batches" holds the batches which are
+    // currently in memory, "batchfirst" the row number of the first row
+    // in each, and "rowend" the number of the row following the last one
+    // held.
+    StylePrintRowSource *source;
+    StylePrintDataset *dataset;     // The first batch - defines the columns
+    GPtrArray *batches;
+    GArray *batchfirst;
+    gint rowend;
+    gboolean sourcedone;    // The source has no more rows
+    guint curbatch;         // The batch last accessed by row_slice()
+    gint indexed;           // Rows added to the group index, -1 until
+                            // the columns are bound
+    gchar *spillfile;       // If set, spill the rows to this file first
+    StylePrintRowSource *spillsource;   // Reads the spill file
+
+    // The definition of the printout, and for this printout, the render
+    // plans of its row definitions and the state of its groups, indexed by
+    // their "rowslot" and "slot"
+    StylePrintTemplate *tmpl;
+    ROWPLAN *rowplan;
+    GRPSTATE *grpstate;
+
+    // The heights of cell texts already laid out in this printout
+    MEASURECACHE *measure;
+    guint measuresize;      // Entries in "measure" - 0 for no cache
+    guint64 measurehits,
+            measuremisses;
+    GHashTable *advances;   // Font => its ADVTABLE, in "pango"
 
     double pageheight;
     gint TotPages;           // Total Pages
     GtkPageSetup *Page_Setup;
-    GArray *PageEndRow;  // Last Data Row for each page.
-    gboolean DoPrint;       // Flag that we want to actually print (pass 2)
+    GArray *pagechecks;     // The PAGECHECK for each page
+    GArray *rowheights;     // Height (gfloat) of each body row, in points
+    GArray *rowtops;        // Prefix sums of rowheights (gdouble), with
+                            // one more element than it
+    GHashTable *grpkeys;    // grpcol => (its value => first row with it)
+    GPtrArray *pages;       // The display list (GArray of DISPITEM) of
+                            // each page, made by the dry run
+    GArray *curpage;        // The display list being made
     cairo_t *cr;            // The Cairo Print Context
-    GtkPrintContext *context;
-    CELLINF *defaultcell;
+    GtkPrintContext *context;   // NULL if not printing through GTK
+    PangoContext *pango;    // Makes the layouts of the pages
+    double pagewidth;
+    GError **error;         // If set, where report_error() puts the error
     PangoLayout *layout;
-    ROWPAD *DefaultPadding;
-    GSList *elList;
 
     // Current vars
     gint pageno;             // Current Page #
@@ -142,17 +198,14 @@ struct _StylePrintTablePrivate
 #define DFLTSIZE 10
 
 //GtkPrintOperation *po;
-static void render_report (StylePrintTable*);
-static void start_element_main (GMarkupParseContext *, const gchar *,
-        const gchar **, const gchar **, gpointer, GError **);
-static void end_element_main (GMarkupParseContext *, const gchar *,
-                             gpointer, GError **);
-static void prs_err (GMarkupParseContext *, GError *, gpointer);
-static void reset_default_cell (StylePrintTable *);
-//static void free_default_cell (StylePrintTable *);
+static GtkPrintOperationResult render_report (StylePrintTable *,
+                                              GtkPrintOperationAction,
+                                              GError **);
 static void set_page_defaults (StylePrintTable *);
 
 static void report_error (StylePrintTable *, gchar *);
+static void clear_pagination (StylePrintTable *);
+static void index_rows (StylePrintTable *);
 static void render_page (StylePrintTable *);
 static void style_print_table_begin_print (GtkPrintOperation *,
                                            GtkPrintContext *);
@@ -165,758 +218,616 @@ static void style_print_table_draw_page (GtkPrintOperation *,
                                          GtkPrintContext *,
                                          int);
 
-#define CELLPAD_DFLT 10
-
 G_DEFINE_TYPE_WITH_PRIVATE(StylePrintTable, style_print_table,
                             GTK_TYPE_PRINT_OPERATION)
 
-char *GroupElements[] = {"pageheader", "group", "body", NULL};
-gboolean Formatted = FALSE;
-//PangoFontDescription *DefaultPangoFont;
-PGRPINF FmtList;    // The formatting tree;
+/* The default number of cell heights kept in the measurement cache */
+#define MEASURE_CACHE_DFLT 4096
 
-void
-free_celldef (CELLINF *cell)
-{
-    if (cell->pangofont)
-    {
-        pango_font_description_free (cell->pangofont);
-    }
+/* The number of rows requested from the row source at a time */
+#define SOURCE_BATCH_ROWS 1000
 
-    //g_free (cell->font);
-    g_free (cell->celltext);
+#define BATCH_FIRST(p,i) g_array_index ((p)->batchfirst, gint, (i))
 
-    g_free (cell);
-}
+/* The per-printout render plan (NULL if no cells) and state of a group */
+#define ROW_PLAN(p,g) ((g)->rowslot < 0 ? NULL : &(p)->rowplan[(g)->rowslot])
+#define GRP_STATE(p,g) (&(p)->grpstate[(g)->slot])
 
-GMarkupParser prsr = {start_element_main, end_element_main, NULL,
-                        NULL, prs_err};
+#define PAGE_CHECK(p,n) (&g_array_index ((p)->pagechecks, PAGECHECK, (n)))
 
-//GMarkupParser sub_prs = {start_element_main, end_element_main, NULL,
-//                        NULL, prs_err};
+typedef void (*RowFunc) (StylePrintTable *, GRPINF *);
 
-void
-htlist(gchar *key,gchar *val, gpointer usrdat)
-{
-    fprintf(stderr,"%s=>%s  ",key,val);
-}
+/* ******************************************************************** *
+ * fetch_batch() - Pull the next batch of rows from the row source      *
+ *      and append it to the batches held.                              *
+ * Returns: FALSE if there are no more rows (or the fetch failed)       *
+ * ******************************************************************** */
 
-void
-arylist (gchar *val, gpointer udat)
+static gboolean
+fetch_batch (StylePrintTable *self)
 {
-    if (val)
-    {
-        fprintf(stderr, "%s", val);
-    }
-    else
-    {
-        fprintf(stderr, "???");
-    }
-    fprintf(stderr,"\n");
-}
+    StylePrintTablePrivate *priv;
+    StylePrintDataset *batch = NULL;
+    GError *err = NULL;
 
-/**
- * style_print_table_greet:
- * @self: The StylePrintTable
- * @ary: (element-type gchararray): The array to parse
- *
- * This is only a temporary function to do tests, and will be deleted
- * later on.
- */
+    priv = style_print_table_get_instance_private (self);
 
-void
-style_print_table_greet (StylePrintTable *self,GPtrArray *ary)
-{
-    gchar **ptr = (gchar **)(ary->pdata);
-    gint idx;
-    fprintf (stderr, "\nThere are %d elements in the array\n", ary->len);
-    //g_ptr_array_foreach(ary,(GFunc)arylist, NULL);
-    for (idx=0; idx < ary->len; idx++)
+    if (priv->sourcedone)
     {
-        if (*ptr)
-        {
-            fprintf (stderr, "%s", *(ptr++));
-        }
-        else
-        {
-            fprintf (stderr, "+++");
-            ++ptr;
-        }
-        fprintf(stderr, "\n");
+        return FALSE;
     }
-}
 
-static void
-style_print_table_init (StylePrintTable *op)
-{
-    StylePrintTablePrivate *priv = style_print_table_get_instance_private (op);
-    // initialisation goes here
+    // A batch should hold at least one row, but an empty one from some
+    // other source is skipped rather than trusted
+    do
+    {
+        g_clear_object (&batch);
+        batch = style_print_row_source_next_batch (priv->source,
+                                                SOURCE_BATCH_ROWS, &err);
+    } while (batch && !style_print_dataset_get_n_rows (batch));
 
-    /* Should these be set up elsewhere???? */
-    priv->Page_Setup = gtk_page_setup_new();
-    gtk_print_operation_set_default_page_setup (GTK_PRINT_OPERATION(op),
-            priv->Page_Setup);
-    set_page_defaults (op);
-    priv->w_main = NULL;
-    priv->pgresult = NULL;
-    //priv->qryParams = NULL;
-}
+    if (!batch)
+    {
+        priv->sourcedone = TRUE;
 
-static void
-style_print_table_class_init (StylePrintTableClass *class)
-{
-    //GObjectClass *gobject_class = (GObjectClass *) class;
-    GtkPrintOperationClass *print_class = (GtkPrintOperationClass *) class;
+        if (err)
+        {
+            report_error (self, err->message);
+            g_error_free (err);
+        }
 
-    // virtual function overrides go here
-    print_class->begin_print = style_print_table_begin_print;
-    print_class->draw_page = style_print_table_draw_page;
-    //gobject_class->finalize = style_print_table_finalize;
-    //print_class->end_print = style_print_table_end_print;
+        return FALSE;
+    }
 
-    // property and signal definitions go here
+    g_ptr_array_add (priv->batches, batch);
+    g_array_append_val (priv->batchfirst, priv->rowend);
+    priv->rowend += style_print_dataset_get_n_rows (batch);
+    index_rows (self);
+    return TRUE;
 }
 
-/* **************************************************************** *
- * match_attrib() - Utility function to match a string constant.    *
- *      A NULL-terminated array of string values to match is        *
- *      passed.  The calling function provides this string, and     *
- *      also has an array with corresponding values for each        *
- *      element of this array, with some value provided as the      *
- *      final element, corresponding to the final NULL.  It can be  *
- *      either a default value, or value not to be expected to      *
- *      signal that a match was not found.                          *
- * Passed : (1) - txtlist : A NULL-terminated list of usable string *
- *                values.                                           *
- *          (2) - matchval: The string value to match.              *
- * **************************************************************** */
+/* ******************************************************************** *
+ * have_row() - Make sure that row number "row" has been fetched,       *
+ *      pulling more batches from the source as needed.                 *
+ * Returns: FALSE if the data ends before "row"                         *
+ * ******************************************************************** */
 
-static int
-match_attrib (const char **txtlist, const char *matchval)
+static gboolean
+have_row (StylePrintTable *self, gint row)
 {
-    int idx = 0;
+    StylePrintTablePrivate *priv;
 
-    while (txtlist[idx] && !STRMATCH(matchval, txtlist[idx]))
+    priv = style_print_table_get_instance_private (self);
+
+    while (row >= priv->rowend)
     {
-        ++idx;
+        if (!fetch_batch (self))
+        {
+            return FALSE;
+        }
     }
 
-    return idx;
+    return TRUE;
 }
 
-/* **************************************************************** *
- * name_to_pango_style() - Converts a name (text string) to a       *
- *          numeric Pango Style.                                    *
- * **************************************************************** */
+/* ******************************************************************** *
+ * row_batch() - Find the batch holding row number "row", setting      *
+ *      "batchrow" to the number of the row within that batch.  Rows    *
+ *      are nearly always accessed in sequence, so the search starts at *
+ *      the batch used last.                                            *
+ * ******************************************************************** */
 
-PangoStyle
-name_to_pango_style (const char *name)
+static StylePrintDataset *
+row_batch (StylePrintTable *self, gint row, guint *batchrow)
 {
-    const char *style_txt[] = {"normal", "oblique", "italic", NULL};
-    PangoStyle style[] = {PANGO_STYLE_NORMAL, PANGO_STYLE_OBLIQUE,
-                        PANGO_STYLE_ITALIC, PANGO_STYLE_NORMAL};
+    StylePrintTablePrivate *priv;
+    guint idx;
 
-    return style[match_attrib (style_txt, name)];
-}
+    priv = style_print_table_get_instance_private (self);
 
-/* **************************************************************** *
- * name_to_pango_weight() - Converts a name string to a PangoWeight *
- * **************************************************************** */
+    if (!have_row (self, row) || (priv->batches->len == 0) ||
+            (row < BATCH_FIRST(priv, 0)))
+    {
+        return NULL;
+    }
 
-PangoWeight
-name_to_pango_weight (const char *name)
-{
-    const char *weight_txt[] = {
-        "thin", "ultralight", "light", "book", "normal", "medium",
-        "semibold", "bold", "heavy", "ultraheavy", NULL};
-    PangoWeight weight[] = {
-        PANGO_WEIGHT_THIN, PANGO_WEIGHT_ULTRALIGHT, PANGO_WEIGHT_LIGHT,
-        PANGO_WEIGHT_BOOK, PANGO_WEIGHT_NORMAL, PANGO_WEIGHT_MEDIUM,
-        PANGO_WEIGHT_SEMIBOLD, PANGO_WEIGHT_BOLD, PANGO_WEIGHT_ULTRABOLD,
-        PANGO_WEIGHT_HEAVY, PANGO_WEIGHT_ULTRAHEAVY, PANGO_WEIGHT_NORMAL};
+    idx = priv->curbatch;
 
-    return weight[match_attrib (weight_txt, name)];
-}
+    if ((idx >= priv->batches->len) || (row < BATCH_FIRST(priv, idx)))
+    {
+        idx = 0;
+    }
 
-PangoVariant
-name_to_pango_variant (const char *name)
-{
-    const char *variant_name[] = {"normal", "small-caps", NULL};
-    PangoVariant variant[] = {PANGO_VARIANT_NORMAL,
-                            PANGO_VARIANT_SMALL_CAPS, PANGO_VARIANT_NORMAL};
+    while ((idx + 1 < priv->batches->len) &&
+            (row >= BATCH_FIRST(priv, idx + 1)))
+    {
+        ++idx;
+    }
 
-    return variant[match_attrib (variant_name, name)];
+    priv->curbatch = idx;
+    *batchrow = row - BATCH_FIRST(priv, idx);
+    return g_ptr_array_index (priv->batches, idx);
 }
 
-PangoStretch
-name_to_pango_stretch (const char *name)
+/* ******************************************************************** *
+ * row_slice() - Retrieve the value for column "col" in row number      *
+ *      "row", and its length.  The value need not be null-terminated.  *
+ * ******************************************************************** */
+
+static const gchar *
+row_slice (StylePrintTable *self, gint row, gint col, gsize *len)
 {
-    const char *stretch_name[] = {"ultra-condensed", "extra-condensed",
-                    "condensed", "semi-condensed", "normal", "semi-expanded",
-                    "expanded", "extra-expanded", "ultra-expanded", NULL};
-    PangoStretch stretch[] = {
-                PANGO_STRETCH_ULTRA_CONDENSED, PANGO_STRETCH_EXTRA_CONDENSED,
-                PANGO_STRETCH_CONDENSED, PANGO_STRETCH_SEMI_CONDENSED,
-                PANGO_STRETCH_NORMAL, PANGO_STRETCH_SEMI_EXPANDED,
-                PANGO_STRETCH_EXPANDED, PANGO_STRETCH_EXTRA_EXPANDED,
-                PANGO_STRETCH_ULTRA_EXPANDED, PANGO_STRETCH_NORMAL};
+    StylePrintDataset *batch;
+    guint batchrow;
 
-    return stretch[match_attrib (stretch_name, name)];
-}
+    *len = 0;
 
-PangoAlignment
-name_to_layout_align (const char *name)
-{
-    const char *align_name[] = {"l", "c", "r", NULL};
-    PangoAlignment align[] = {PANGO_ALIGN_LEFT, PANGO_ALIGN_CENTER,
-            PANGO_ALIGN_RIGHT, PANGO_ALIGN_LEFT};
+    if (!(batch = row_batch (self, row, &batchrow)))
+    {
+        return NULL;
+    }
 
-    return align[match_attrib (align_name, name)];
+    return style_print_dataset_get_slice (batch, batchrow, col, len);
 }
 
-/* Error reporting routine.
- * If self->w_main is defined, the message will be reported in a dialog box
- * else it is sent to stderr
- */
+/* ******************************************************************** *
+ * index_rows() - Add the rows of any batches not yet indexed to the    *
+ *      group index.  For each group level, the index records the row   *
+ *      following each run of rows with the same value in the group's  *
+ *      column, so that render_group() can find the end of a group      *
+ *      without comparing the rows again.  The index is built once, as  *
+ *      the rows are first fetched, and serves both the dry run and the *
+ *      printing of each page, even when the source is rewound.  A      *
+ *      batch its source dictionary-encoded is compared by code; any    *
+ *      other, which may be the caller's own dataset, is left as it is  *
+ *      and compared by value.                                          *
+ * ******************************************************************** */
 
 static void
-report_error (StylePrintTable *self, char *message)
+index_rows (StylePrintTable *self)
 {
     StylePrintTablePrivate *priv;
-   
-    priv = style_print_table_get_instance_private (self);
+    guint idx;
 
-    if (priv->w_main)
-    {
-        GtkWidget *dlg;
+    priv = style_print_table_get_instance_private (self);
 
-        dlg = gtk_message_dialog_new (priv->w_main,
-                GTK_DIALOG_MODAL | GTK_DIALOG_DESTROY_WITH_PARENT,
-                GTK_MESSAGE_WARNING, GTK_BUTTONS_OK,
-                "%s", message);
-        gtk_dialog_run (GTK_DIALOG(dlg));
-        gtk_widget_destroy (dlg);
-    }
-    else
+    if (priv->indexed < 0)
     {
-        fprintf (stderr, "%s", message);
+        return;
     }
-}
-
-static void 
-prs_err(GMarkupParseContext *context, GError *error, gpointer user_data)
-{
-    fprintf(stderr, "Error encountered: %s\n", error->message);
-}
-
-/* **************************************************************** *
- * add_cell_attribs() - Add attributes to a cell definition.  This  *
- *      portion is broken out of append_cell_defs() in order to     *
- *      handle attribute settings for cells that are not made up    *
- *      of arrays, such as "defaultcell".                           *
- * **************************************************************** */
-
-static void
-add_cell_attribs (CELLINF *cell, const gchar **attrib_names,
-                                    const gchar **attrib_vals)
-{
-    int idx = 0;
 
-    while (attrib_names[idx])
+    for (idx = 0; idx < priv->batches->len; idx++)
     {
-        if (STRMATCH(attrib_names[idx], "percent"))
-        {
-            cell->percent = strtof (attrib_vals[idx], NULL);
-        }
+        StylePrintDataset *batch = g_ptr_array_index (priv->batches, idx);
+        gint first = BATCH_FIRST(priv, idx),
+             nrows = style_print_dataset_get_n_rows (batch);
+        GRPINF *grp;
 
-        else if (STRMATCH(attrib_names[idx], "cellwidth"))
+        if (!nrows || (first + nrows <= priv->indexed))
         {
-            cell->cellwidth = strtof (attrib_vals[idx], NULL);
+            continue;
         }
 
-        else if (STRMATCH(attrib_names[idx], "textsource"))
+        for (grp = priv->tmpl->grpHd;
+                grp && (grp->grptype == GRPTY_GROUP); grp = grp->grpchild)
         {
-            const char *val = attrib_vals[idx];
+            GRPSTATE *gs = GRP_STATE(priv, grp);
+            StylePrintValue prev = gs->grplast,
+                            val;
+            const guint32 *codes;
+            gint row;
 
-            if (STRMATCH(val, "data"))
+            if (!gs->grpends)
             {
-                cell->txtsource = TSRC_DATA;
+                gs->grpends = g_array_new (FALSE, FALSE, sizeof (gint));
             }
-            else if (STRMATCH(val, "static"))
+
+            codes = style_print_dataset_get_codes (batch, gs->grpcolidx);
+
+            for (row = MAX (first, priv->indexed); row < first + nrows; row++)
             {
-                cell->txtsource = TSRC_STATIC;
+                // Within a dictionary-encoded batch, the codes are compared
+                if (codes && (row > first))
+                {
+                    if (codes[row - first] != codes[row - first - 1])
+                    {
+                        g_array_append_val (gs->grpends, row);
+                    }
+
+                    continue;
+                }
+
+                style_print_dataset_get_native (batch, row - first,
+                                                gs->grpcolidx, &val);
+
+                if (row && (style_print_value_compare (&prev, &val) != 0))
+                {
+                    g_array_append_val (gs->grpends, row);
+                }
+
+                prev = val;
             }
-            else if (STRMATCH(val, "now"))
+
+            if (codes)
             {
-                cell->txtsource = TSRC_NOW;
+                style_print_dataset_get_native (batch, nrows - 1,
+                                                gs->grpcolidx, &prev);
             }
-            else if (STRMATCH(val, "printf"))
+
+            // The batch holding the last row may be released before the
+            // next one is indexed, so keep a copy of its text.
+            g_free (gs->grplasttxt);
+            gs->grplasttxt = prev.str ? g_strndup (prev.str, prev.len) : NULL;
+            gs->grplast = prev;
+            gs->grplast.str = gs->grplasttxt;
+        }
+
+        priv->indexed = first + nrows;
+    }
+}
+
+/* ******************************************************************** *
+ * group_end() - Find the row following the run of rows, beginning at  *
+ *      row number "row", which have the same value for the column of   *
+ *      group "grp", or "maxrow" if that comes first.  If the run       *
+ *      reaches the last row indexed, more rows are fetched.            *
+ * ******************************************************************** */
+
+static gint
+group_end (StylePrintTable *self, GRPINF *grp, gint row, gint maxrow)
+{
+    StylePrintTablePrivate *priv;
+
+    priv = style_print_table_get_instance_private (self);
+
+    for (;;)
+    {
+        GArray *ends = GRP_STATE(priv, grp)->grpends;
+        guint lo = 0,
+              hi = ends ? ends->len : 0;
+
+        while (lo < hi)
+        {
+            guint mid = (lo + hi) / 2;
+
+            if (g_array_index (ends, gint, mid) > row)
             {
-                cell->txtsource = TSRC_PRINTF;
+                hi = mid;
             }
-            else if (STRMATCH(val, "pageof"))
+            else
             {
-                cell->txtsource = TSRC_PAGEOF;
+                lo = mid + 1;
             }
-            //TODO: add error reporting...
         }
 
-        else if (STRMATCH(attrib_names[idx], "celltext"))
+        if (ends && (lo < ends->len))
         {
-            cell->celltext = g_strdup (attrib_vals[idx]);
+            return MIN (g_array_index (ends, gint, lo), maxrow);
         }
 
-        else if (STRMATCH(attrib_names[idx], "align"))
+        // The run continues past the rows indexed so far
+        if ((priv->indexed >= maxrow) || !fetch_batch (self))
         {
-            cell->layoutalign = name_to_layout_align (attrib_vals[idx]);
+            return MIN (MAX (priv->indexed, row + 1), maxrow);
         }
-        // TODO: add error reporting
-
-        ++idx;
     }
 }
 
-/* **************************************************************** *
- * append_cell_defs() : Populate a cell definition in the row       *
- *          array, and append this new cell onto the array of cells *
- *  If the array has not already been created, it is now created.   *
- * **************************************************************** */
+/* ******************************************************************** *
+ * release_rows() - Free every batch whose rows all precede "row".      *
+ * ******************************************************************** */
 
-static CELLINF *
-append_cell_def (StylePrintTable *self, const gchar **attrib_names,
-                    const gchar **attrib_vals, GRPINF *parentgrp)
+static void
+release_rows (StylePrintTable *self, gint row)
 {
-    CELLINF *mycell;
-    GPtrArray *cellary;
     StylePrintTablePrivate *priv;
-   
+
     priv = style_print_table_get_instance_private (self);
 
-    if (parentgrp)
+    while (priv->batches->len)
     {
-        if (!(cellary = parentgrp->celldefs))
+        StylePrintDataset *batch = g_ptr_array_index (priv->batches, 0);
+
+        if (BATCH_FIRST(priv, 0) +
+                (gint)style_print_dataset_get_n_rows (batch) > row)
         {
-            parentgrp->celldefs = g_ptr_array_new_with_free_func (
-                    (GDestroyNotify)free_celldef);
+            break;
         }
+
+        g_ptr_array_remove_index (priv->batches, 0);
+        g_array_remove_index (priv->batchfirst, 0);
     }
 
-    mycell = g_malloc0 (sizeof(CELLINF));
-    mycell->grptype = GRPTY_CELL;
-    mycell->padleft = CELLPAD_DFLT;
-    mycell->padright = CELLPAD_DFLT;
+    priv->curbatch = 0;
+}
+
+/* ******************************************************************** *
+ * seek_row() - Position the batches held so that the first one holds   *
+ *      row number "row".  If that row has already been released, the   *
+ *      source is repositioned at it, or if it cannot be, rewound and   *
+ *      read forward from the beginning.                                *
+ * Returns: FALSE if there is no such row                               *
+ * ******************************************************************** */
+
+static gboolean
+seek_row (StylePrintTable *self, gint row)
+{
+    StylePrintTablePrivate *priv;
+
+    priv = style_print_table_get_instance_private (self);
 
-    if (parentgrp && parentgrp->pangofont)
+    if (priv->batches->len ? (row < BATCH_FIRST(priv, 0)) :
+                             (row < priv->rowend))
     {
-        mycell->pangofont = pango_font_description_copy (parentgrp->pangofont);
+        GError *err = NULL;
+        guint first;
+
+        if (!style_print_row_source_seek (priv->source, row, &first, &err))
+        {
+            report_error (self, err ? err->message :
+                                    "Failed to rewind the row source");
+            g_clear_error (&err);
+            priv->sourcedone = TRUE;
+            return FALSE;
+        }
+
+        g_ptr_array_set_size (priv->batches, 0);
+        g_array_set_size (priv->batchfirst, 0);
+        priv->rowend = first;
+        priv->sourcedone = FALSE;
     }
-    else
+
+    while (row >= priv->rowend)
     {
-        mycell->pangofont = pango_font_description_copy (
-            priv->defaultcell->pangofont);
+        if (!fetch_batch (self))
+        {
+            return FALSE;
+        }
+
+        release_rows (self, row);
     }
 
-    add_cell_attribs (mycell, attrib_names, attrib_vals);
+    release_rows (self, row);
+    return TRUE;
+}
 
-//    if (mycell->txtsource == TSRC_DATA)
-//    {
-//        if (mycell->celltext && strlen(mycell->celltext))
-//        {
-//            mycell->cell_col = PQfnumber (self->pgresult, mycell->celltext);
-//
-//        }
-//    }
+/* ******************************************************************** *
+ * spill_source() - Copy all the rows of "source" to the spill file,    *
+ *      and return a source reading them back from the mapped file.     *
+ *      The file is removed as soon as it is mapped, so the space is    *
+ *      released when the printout is finished, however it ends.        *
+ * ******************************************************************** */
+
+static StylePrintRowSource *
+spill_source (StylePrintTable *self, StylePrintRowSource *source)
+{
+    StylePrintTablePrivate *priv;
+    StylePrintDataset *data;
+    StylePrintRowSource *spilled;
+    GError *err = NULL;
+
+    priv = style_print_table_get_instance_private (self);
 
-    if (parentgrp)
+    if (!style_print_spill_write (source, priv->spillfile, &err) ||
+            !(data = style_print_spill_open (priv->spillfile, &err)))
     {
-        g_ptr_array_add (parentgrp->celldefs, mycell);
+        report_error (self, err->message);
+        g_error_free (err);
+        return NULL;
     }
 
-    return mycell;
+    g_remove (priv->spillfile);
+    spilled = style_print_row_source_new_from_dataset (data);
+    g_object_unref (data);
+    return spilled;
 }
 
-/* **************************************************************** *
- * allocate_new_group() - Allocates space for a new group, body,    *
- *          header group and initializes it.                        *
- * Passed : (1) - Pointer to the group under which this will exist  *
- *          (2) - The GRPTY_* of this grouping.                     *
- * Returns: Pointer to this new group's definition.                 *
- * **************************************************************** */
-
+/* ******************************************************************** *
+ * open_source() - Set up to read rows from "source".  The first batch  *
+ *      is fetched now, both to verify that there is something to       *
+ *      print and to provide the columns to bind the format to.         *
+ * Returns: FALSE (after reporting it) if there are no rows             *
+ * ******************************************************************** */
 
-static GRPINF *
-allocate_new_group (StylePrintTable *self, const char **attrib_names,
-                    const char **attrib_vals, GRPINF *parent, int grptype)
+static gboolean
+open_source (StylePrintTable *self, StylePrintRowSource *source)
 {
     StylePrintTablePrivate *priv;
-    int grpidx = 0;
-    GRPINF *newgrp = g_malloc0 (sizeof(GRPINF));
-   
+
     priv = style_print_table_get_instance_private (self);
 
-    if ((grptype == GRPTY_GROUP) || (grptype == GRPTY_BODY))
+    if (source && priv->spillfile)
     {
-        if (!parent && !priv->grpHd)
-        {
-            priv->grpHd = (GRPINF *)newgrp;
-            newgrp = priv->grpHd;
-        }
+        source = priv->spillsource = spill_source (self, source);
     }
 
-    newgrp->grptype = grptype;
+    priv->source = source;
+    priv->batches = g_ptr_array_new_with_free_func (g_object_unref);
+    priv->batchfirst = g_array_new (FALSE, FALSE, sizeof(gint));
+    priv->rowend = 0;
+    priv->curbatch = 0;
+    priv->indexed = -1;
+    priv->sourcedone = (source == NULL);
 
-    if (parent && parent->pangofont)
-    {
-        newgrp->pangofont = pango_font_description_copy (parent->pangofont);
-    }
-    else
+    if (!fetch_batch (self))
     {
-        newgrp->pangofont =
-                    pango_font_description_copy (priv->defaultcell->pangofont);
+        report_error (self,
+                "Error! Data to print was either not defined or empty");
+        return FALSE;
     }
 
-    if (parent)
-    {
-        newgrp->grpparent = parent;
-    }
+    priv->dataset = g_object_ref (g_ptr_array_index (priv->batches, 0));
+    return TRUE;
+}
 
-    while (attrib_names[grpidx])
-    {
-        if (STRMATCH(attrib_names[grpidx], "groupsource"))
-        {
-            newgrp->grpcol = g_strdup (attrib_vals[grpidx]);
-
-        }
-        else if (STRMATCH(attrib_names[grpidx], "pointsabove"))
-        {
-            newgrp->pointsabove = atoi (attrib_vals[grpidx]);
-        }
-        else if (STRMATCH(attrib_names[grpidx], "pointsbelow"))
-        {
-            newgrp->pointsbelow = atoi (attrib_vals[grpidx]);
-        }
-        else if (STRMATCH(attrib_names[grpidx], "outerborder"))
-        {
-            if (STRMATCH(attrib_vals[grpidx], "singlebar"))
-            {
-                newgrp->borderstyle = SINGLEBAR;
-            }
-            else if (STRMATCH(attrib_vals[grpidx], "doublebar"))
-            {
-                newgrp->borderstyle = DBLBAR;
-            }
-            else if (STRMATCH(attrib_vals[grpidx], "singlebarheavy"))
-            {
-                newgrp->borderstyle = SINGLEBAR_HVY;
-            }
-            else if (STRMATCH(attrib_vals[grpidx], "singlebox"))
-            {
-                newgrp->borderstyle = SINGLEBOX;
-            }
-            else if (STRMATCH(attrib_vals[grpidx], "doublebox"))
-            {
-                newgrp->borderstyle = DBLBOX;
-            }
-        }
-
-        // We may wish to move this into the body allocation segment
-        else if (STRMATCH(attrib_names[grpidx], "cellborder"))
-        {
-            if (STRMATCH(attrib_vals[grpidx], "hline"))
-            {
-                newgrp->borderstyle = BDY_HLINE;
-            }
-            else if (STRMATCH(attrib_vals[grpidx], "vbar"))
-            {
-                newgrp->borderstyle = BDY_VBAR;
-            }
-            else if (STRMATCH(attrib_vals[grpidx], "boxed"))
-            {
-                newgrp->borderstyle = BDY_HLINE | BDY_VBAR;
-            }
-        }
-
-        ++grpidx;
-    }
-
-    return newgrp;
-}
-
-static ROWPAD *
-set_padding_attribs (ROWPAD *pad,
-                     const char **attrib_names, const char **attrib_vals)
-{
-    int idx = 0;
-
-    while (attrib_names[idx])
-    {
-        if (STRMATCH(attrib_names[idx], "padleft"))
-        {
-            pad->left = atoi (attrib_vals[idx]);
-        }
-        else if (STRMATCH(attrib_names[idx], "padright"))
-        {
-            pad->right = atoi (attrib_vals[idx]);
-        }
-        else if (STRMATCH(attrib_names[idx], "padtop"))
-        {
-            pad->top = atoi (attrib_vals[idx]);
-        }
-        else if (STRMATCH(attrib_names[idx], "padbottom"))
-        {
-            pad->bottom = atoi (attrib_vals[idx]);
-        }
-        //TODO: else error???
-    }
-
-    return pad;
-}
+/* ******************************************************************** *
+ * close_source() - Release all the rows still held, and forget the     *
+ *      row source.                                                     *
+ * ******************************************************************** */
 
 static void
-start_element_main (GMarkupParseContext *context,
-                    const gchar  *element_name,
-                    const gchar **attrib_names,
-                    const gchar **attrib_vals,
-                       gpointer   myself,
-                         GError **error)
+close_source (StylePrintTable *self)
 {
     StylePrintTablePrivate *priv;
-    gpointer newgrp = NULL;
-    GRPINF *parent = NULL;
-    StylePrintTable *self = STYLE_PRINT_TABLE(myself);
-   
+
     priv = style_print_table_get_instance_private (self);
 
+    g_clear_object (&priv->dataset);
 
-    if (priv->elList)
+    if (priv->batches)
     {
-        parent = g_slist_nth(priv->elList, 0)->data;
+        g_ptr_array_free (priv->batches, TRUE);
+        priv->batches = NULL;
     }
 
-    if (STRMATCH(element_name, "cell"))
+    if (priv->batchfirst)
     {
-        if (parent)
-        {
-            newgrp =
-                append_cell_def (self,
-                        attrib_names, attrib_vals, (GRPINF *)parent);
-        }
-        else
-        {
-            // Error
-        }
+        g_array_free (priv->batchfirst, TRUE);
+        priv->batchfirst = NULL;
     }
-    else if (STRMATCH(element_name, "defaultcell"))
-    {
-        if (!(priv->defaultcell))
-        {
-            priv->defaultcell = g_malloc0 (sizeof (CELLINF));
-        }
 
-        add_cell_attribs (priv->defaultcell, attrib_names, attrib_vals);
-        newgrp = priv->defaultcell;
-    }
-    else if (STRMATCH(element_name, "group"))
+    priv->source = NULL;
+    g_clear_object (&priv->spillsource);
+}
+
+void
+htlist(gchar *key,gchar *val, gpointer usrdat)
+{
+    fprintf(stderr,"%s=>%s  ",key,val);
+}
+
+void
+arylist (gchar *val, gpointer udat)
+{
+    if (val)
     {
-        newgrp = allocate_new_group ( self,
-                attrib_names, attrib_vals, (GRPINF *)parent, GRPTY_GROUP);
-        if (parent)
-        {
-            ((GRPINF *)parent)->grpchild = newgrp;
-        }
-        else
-        {
-             priv->grpHd = (GRPINF *)newgrp;
-        }
+        fprintf(stderr, "%s", val);
     }
-    else if (STRMATCH(element_name, "header"))
+    else
     {
-        if (parent)
-        {
-            newgrp = allocate_new_group (self,
-                        attrib_names, attrib_vals, parent, GRPTY_HEADER);
-            ((GRPINF *)parent)->header = newgrp;
-        }
+        fprintf(stderr, "???");
     }
-    else if (STRMATCH(element_name, "body"))
+    fprintf(stderr,"\n");
+}
+
+/**
+ * style_print_table_greet:
+ * @self: The StylePrintTable
+ * @ary: (element-type gchararray): The array to parse
+ *
+ * This is only a temporary function to do tests, and will be deleted
+ * later on.
+ */
+
+void
+style_print_table_greet (StylePrintTable *self,GPtrArray *ary)
+{
+    gchar **ptr = (gchar **)(ary->pdata);
+    gint idx;
+    fprintf (stderr, "\nThere are %d elements in the array\n", ary->len);
+    //g_ptr_array_foreach(ary,(GFunc)arylist, NULL);
+    for (idx=0; idx < ary->len; idx++)
     {
-        newgrp = allocate_new_group (self,
-                attrib_names, attrib_vals, (GRPINF *)parent, GRPTY_BODY);
-        if (parent)
+        if (*ptr)
         {
-            ((GRPINF *)parent)->grpchild = newgrp;
+            fprintf (stderr, "%s", *(ptr++));
         }
         else
         {
-             priv->grpHd = (GRPINF *)newgrp;
+            fprintf (stderr, "+++");
+            ++ptr;
         }
+        fprintf(stderr, "\n");
     }
-    else if (STRMATCH(element_name, "font"))
-    {
-        int idx = 0;
-
-        while (attrib_names[idx])
-        {
-            const char *a = attrib_names[idx];
-
-            if (parent && (parent->pangofont))
-            {
-                newgrp = parent->pangofont;
-            }
-            else
-            {
-                newgrp = pango_font_description_new();
-            }
+}
 
-            if ( STRMATCH(a, "family"))
-            {
-                pango_font_description_set_family (newgrp,
-                                                   attrib_vals[idx]);
-            }
-            else if (STRMATCH(a, "size"))
-            {
-                pango_font_description_set_size (newgrp,
-                            atoi(attrib_vals[idx]) * PANGO_SCALE);
-            }
-            else if (STRMATCH(a, "style"))
-            {
-                pango_font_description_set_style (newgrp,
-                            name_to_pango_style (attrib_vals[idx]));
-            }
-            else if (STRMATCH(a, "weight"))
-            {
-                pango_font_description_set_weight (newgrp,
-                            name_to_pango_weight (attrib_vals[idx]));
-            }
-            else if (STRMATCH(a, "variant"))
-            {
-                pango_font_description_set_variant (newgrp,
-                            name_to_pango_variant (attrib_vals[idx]));
-            }
-            else if (STRMATCH(a, "stretch"))
-            {
-                pango_font_description_set_stretch (newgrp,
-                            name_to_pango_stretch (attrib_vals[idx]));
-            }
+static void
+style_print_table_init (StylePrintTable *op)
+{
+    StylePrintTablePrivate *priv = style_print_table_get_instance_private (op);
+    // initialisation goes here
 
-            ++idx;
-        }
+    /* Should these be set up elsewhere???? */
+    priv->Page_Setup = gtk_page_setup_new();
+    gtk_print_operation_set_default_page_setup (GTK_PRINT_OPERATION(op),
+            priv->Page_Setup);
+    set_page_defaults (op);
+    priv->w_main = NULL;
+    priv->source = NULL;
+    priv->dataset = NULL;
+    priv->batches = NULL;
+    priv->batchfirst = NULL;
+    priv->spillfile = NULL;
+    priv->spillsource = NULL;
+    priv->measuresize = MEASURE_CACHE_DFLT;
+    //priv->qryParams = NULL;
+}
 
-        //newgrp = NULL;
-    }
-    else if (STRMATCH(element_name, "docheader"))
-    {
-        if (! priv->DocHeader)
-        {
-             priv->DocHeader =
-                    allocate_new_group ( self, attrib_names, attrib_vals,
-                            NULL, GRPTY_DOCHD);
-        }
+static void
+style_print_table_finalize (GObject *object)
+{
+    StylePrintTablePrivate *priv = style_print_table_get_instance_private (
+                                            STYLE_PRINT_TABLE(object));
 
-        newgrp =  priv->DocHeader;
-    }
-    else if (STRMATCH(element_name, "pageheader"))
-    {
-        if (! priv->PageHeader)
-        {
-             priv->PageHeader =
-                    allocate_new_group ( self, attrib_names, attrib_vals,
-                            NULL, GRPTY_PAGEHEADER);
-        }
+    g_free (priv->spillfile);
+    clear_pagination (STYLE_PRINT_TABLE(object));
 
-        newgrp =  priv->PageHeader;
-    }
-    else if (STRMATCH(element_name, "padding"))
-    {
-        switch (parent->grptype)
-        {
-            int idx;
+    G_OBJECT_CLASS(style_print_table_parent_class)->finalize (object);
+}
 
-            case GRPTY_GROUP:
+static void
+style_print_table_class_init (StylePrintTableClass *class)
+{
+    GObjectClass *gobject_class = (GObjectClass *) class;
+    GtkPrintOperationClass *print_class = (GtkPrintOperationClass *) class;
 
-                if (!newgrp)
-                {
-                    ROWPAD *pads = parent->padding;
-                    pads = g_malloc0(sizeof(ROWPAD));
-                    // Init all to -1 to flag "not set"
-                    pads->left = -1;
-                    pads->right = -1;
-                    pads->top = -1;
-                    pads->bottom = -1;
-                    newgrp = set_padding_attribs (parent->padding,
-                                                  attrib_names,
-                                                  attrib_vals);
-                }
+    // virtual function overrides go here
+    print_class->begin_print = style_print_table_begin_print;
+    print_class->draw_page = style_print_table_draw_page;
+    gobject_class->finalize = style_print_table_finalize;
+    //print_class->end_print = style_print_table_end_print;
 
-                break;
-            case GRPTY_CELL:
-                newgrp = parent;
-                idx = 0;
+    // property and signal definitions go here
+}
 
-                while (attrib_names[idx])
-                {
-                    if (STRMATCH(attrib_names[idx], "left"))
-                    {
-                        ((CELLINF *)newgrp)->padleft =
-                                        atoi (attrib_vals[idx]);
-                    }
-                    else if (STRMATCH(attrib_names[idx], "right"))
-                    {
-                        ((CELLINF *)newgrp)->padright =
-                                        atoi (attrib_vals[idx]);
-                    }
+/* Error reporting routine.
+ * If self->w_main is defined, the message will be reported in a dialog box
+ * else it is sent to stderr
+ */
 
-                    ++idx;
-                }
+static void
+report_error (StylePrintTable *self, char *message)
+{
+    StylePrintTablePrivate *priv;
+   
+    priv = style_print_table_get_instance_private (self);
 
-                break;
-            default:
-                newgrp = parent;
-                break;
-        }
-       
-    }
-    else if (STRMATCH(element_name, "defaultpadding"))
+    // A caller taking a GError gets the first error there instead
+    if (priv->error)
     {
-        // TODO: if parent, error???
-
-        if (! priv->DefaultPadding)
+        if (!*priv->error)
         {
-            priv->DefaultPadding = g_malloc0 (sizeof(ROWPAD));
+            g_set_error_literal (priv->error, GTK_PRINT_ERROR,
+                                 GTK_PRINT_ERROR_GENERAL, message);
         }
 
-        priv->DefaultPadding = set_padding_attribs (
-                    priv->DefaultPadding, attrib_names, attrib_vals);
-        newgrp = priv->DefaultPadding;
-    }
-    else //if (STRMATCH(element_name, "docheader"))
-    {
-        //newgrp = self->DocHeader;
+        return;
     }
 
-    if (newgrp)
+    if (priv->w_main)
     {
-        priv->elList = g_slist_prepend(priv->elList, newgrp);
-    }
-    // Trying to elimintate this feature
-    //g_markup_parse_context_push (context, &sub_prs, newgrp);
-}
+        GtkWidget *dlg;
 
-static void
-end_element_main (GMarkupParseContext  *context,
-                          const gchar  *element_name,
-                             gpointer   tbl,
-                              GError  **error)
-{
-    StylePrintTable *self = STYLE_PRINT_TABLE(tbl);
-    StylePrintTablePrivate *priv;
-    priv = style_print_table_get_instance_private (self);
-    
-    // Pop this item off the List
-    if (priv->elList)
+        dlg = gtk_message_dialog_new (priv->w_main,
+                GTK_DIALOG_MODAL | GTK_DIALOG_DESTROY_WITH_PARENT,
+                GTK_MESSAGE_WARNING, GTK_BUTTONS_OK,
+                "%s", message);
+        gtk_dialog_run (GTK_DIALOG(dlg));
+        gtk_widget_destroy (dlg);
+    }
+    else
     {
-        priv->elList = g_slist_delete_link (priv->elList,
-                                            g_slist_nth(priv->elList, 0));
+        fprintf (stderr, "%s", message);
     }
 }
 
@@ -928,25 +839,6 @@ set_page_defaults (StylePrintTable *self)
     StylePrintTablePrivate *priv = 
                 style_print_table_get_instance_private (self);
 
-    if (! priv->defaultcell)
-    {
-        priv->defaultcell = g_malloc0 (sizeof(CELLINF));
-        priv->defaultcell->grptype = GRPTY_CELL;
-    }
-
-    if (!priv->defaultcell->pangofont)
-    {
-        priv->defaultcell->pangofont = pango_font_description_from_string (
-                "Serif 10");
-    }
-
-//    if (!DefaultPangoFont)
-//    {
-//        DefaultPangoFont =
-//            pango_font_description_copy (priv->defaultcell->pangofont);
-//    }
-
-
     if (!priv->Page_Setup)
     {
         // We may need to get this by running gtk_print_run_page_setup_dialog()
@@ -957,162 +849,364 @@ set_page_defaults (StylePrintTable *self)
     }
 }
 
-//static void
-//free_default_cell (StylePrintTable *self)
-//{
-//    StylePrintTablePrivate *priv = 
-//                style_print_table_get_instance_private (self);
-//
-//
-//    if (priv->defaultcell->pangofont)
-//    {
-//        pango_font_description_free (priv->defaultcell->pangofont);
-//    }
-//
-//    free (priv->defaultcell);
-//    priv->defaultcell = NULL;
-//}
+/* ******************************************************************** *
+ * for_each_row() - Call "func" for "grp" and each of its descendants   *
+ *      and headers which has cells.                                    *
+ * ******************************************************************** */
 
 static void
-reset_default_cell (StylePrintTable *self)
+for_each_row (StylePrintTable *self, GRPINF *grp, RowFunc func)
 {
-//    StylePrintTablePrivate *priv = 
-//                style_print_table_get_instance_private (self);
-    //PangoFontDescription *pfd = priv->defaultcell->pangofont;
+    for (; grp; grp = grp->grpchild)
+    {
+        if (grp->header)
+        {
+            for_each_row (self, grp->header, func);
+        }
+
+        if (grp->celldefs)
+        {
+            func (self, grp);
+        }
+    }
 }
 
 /* ******************************************************************** *
- * set_col_values() - Set the cellwidth and left position for the cell  *
- *      This is called on the first encounter with the cell.  It is not *
- *      called in the initialization routine since the Page setup might *
- *      be changed after this cell is initialized.                      *
- * NOTE: We tried to use gtk_page_setup_get_page_width, (after defining *
- *      the PageSetup structure, but it gave a value of only a little   *
- *      more than 10% of what was needed to get the full page width.    *
+ * for_all_rows() - Call "func" for every row definition with cells in  *
+ *      the template.                                                   *
  * ******************************************************************** */
 
 static void
-set_col_values (CELLINF *cell, StylePrintTable *self)
+for_all_rows (StylePrintTable *self, RowFunc func)
 {
     StylePrintTablePrivate *priv;
-   
+
     priv = style_print_table_get_instance_private (self);
 
-    // The following is for debugging purposes
-/*    double ps = gtk_page_setup_get_page_width(priv->Page_Setup, GTK_UNIT_POINTS);
-    double pc = gtk_print_context_get_width(priv->context);
-    printf ("\nPage width returned by 'gtk_page_setup_get_page_width' = %f\n",ps);
-    printf ("\nPage width returned by 'gtk_print_context_get_width' = %f\n\n",pc);*/
- //   cell->cellwidth =
- //       (cell->percent *  gtk_page_setup_get_page_width(priv->Page_Setup,
- //               GTK_UNIT_POINTS)/100);
-    cell->cellwidth =
-        (cell->percent *  gtk_print_context_get_width(priv->context))/100;
-    cell->x = priv->xpos;
-    priv->xpos += cell->cellwidth;
+    for_each_row (self, priv->tmpl->DocHeader, func);
+    for_each_row (self, priv->tmpl->PageHeader, func);
+    for_each_row (self, priv->tmpl->grpHd, func);
 }
 
 /* ******************************************************************** *
- * set_cell_font_desription() - Sets the font description for a cell    *
- *          Sets it to the default cell definition and then modifies    *
- *          any properties that are specified.                          *
+ * plan_row() - Compile the render plan for the cells of "grp", less    *
+ *      what depends on the print context, which set_col_values() adds, *
+ *      and the data columns, which bind_cells() adds.                  *
  * ******************************************************************** */
 
 static void
-set_cell_font_description (StylePrintTable * self, CELLINF *cell)
+plan_row (StylePrintTable *self, GRPINF *grp)
 {
-//    PFONTINF fi;
     StylePrintTablePrivate *priv;
-   
+    ROWPLAN *plan;
+    guint idx;
+
     priv = style_print_table_get_instance_private (self);
+    plan = ROW_PLAN(priv, grp);
 
+    plan->ncells = grp->celldefs->len;
+    plan->x = g_new0 (double, plan->ncells);
+    plan->textx = g_new0 (double, plan->ncells);
+    plan->textwidth = g_new0 (double, plan->ncells);
+    plan->font = g_new (const PangoFontDescription *, plan->ncells);
+    plan->align = g_new (PangoAlignment, plan->ncells);
+    plan->txtsource = g_new (gint, plan->ncells);
+    plan->colidx = g_new (gint, plan->ncells);
+    plan->text = g_new (const gchar *, plan->ncells);
 
-    if (! cell->pangofont)
+    for (idx = 0; idx < plan->ncells; idx++)
     {
-        cell->pangofont =
-                pango_font_description_copy (priv->defaultcell->pangofont);
+        CELLINF *cell = g_ptr_array_index (grp->celldefs, idx);
 
-        if (! (priv->defaultcell->pangofont))
-        {
-            report_error (self,
-                    "Failed to create Pango Font Description for Cell");
-        }
+        plan->font[idx] = cell->pangofont ? cell->pangofont
+                                : priv->tmpl->defaultcell->pangofont;
+        plan->align[idx] = cell->layoutalign;
+        plan->txtsource[idx] = cell->txtsource;
+        plan->colidx[idx] = -1;
+        plan->text[idx] = cell->celltext;
     }
 }
 
 /* ******************************************************************** *
- * render_cell() - g_ptr_array_foreach() callback to render a single    *
- *          cell.                                                       * 
- * Returns: Height of the rendered cell in points                       *
+ * free_plans() - Free the render plans of all row definitions.         *
  * ******************************************************************** */
 
-static int
-render_cell (StylePrintTable *self, CELLINF *cell, int rownum,
-        double rowtop)
+static void
+free_plans (StylePrintTable *self)
 {
-    char *celltext = NULL;
-    int CellHeight = 0;
-    PangoRectangle log_rect;
-    gboolean deletecelltext = FALSE;
     StylePrintTablePrivate *priv;
-   
-    priv = style_print_table_get_instance_private (self);
+    gint idx;
 
+    priv = style_print_table_get_instance_private (self);
 
-    if (!cell->pangofont)
+    for (idx = 0; idx < priv->tmpl->nrows; idx++)
     {
-        set_cell_font_description (self, cell);
-    }
+        ROWPLAN *plan = &priv->rowplan[idx];
 
-    switch (cell->txtsource)
-    {
-        //GHashTable *cur_row;
+        g_free (plan->x);
+        g_free (plan->textx);
+        g_free (plan->textwidth);
+        g_free (plan->font);
+        g_free (plan->align);
+        g_free (plan->txtsource);
+        g_free (plan->colidx);
+        g_free (plan->text);
 
-        case TSRC_STATIC:
-            celltext = cell->celltext;
-            break;
-        case TSRC_DATA:
-            celltext = g_hash_table_lookup(g_ptr_array_index (priv->pgresult,
-                                                            rownum),
-                                                            cell->celltext);
-            break;
+        g_free (plan->adv);
+
+        if (plan->layout)
+        {
+            guint col;
+
+            for (col = 0; col < plan->ncells; col++)
+            {
+                g_object_unref (plan->layout[col]);
+            }
+
+            g_free (plan->layout);
+        }
+    }
+
+    g_free (priv->rowplan);
+    priv->rowplan = NULL;
+}
+
+/* ******************************************************************** *
+ * set_col_values() - Set the cellwidth and left position for the cells *
+ *      in the render plan for a row definition.  This is done for each *
+ *      printout, not when the template is parsed, since the Page setup *
+ *      might be changed in the meantime.                               *
+ * NOTE: We tried to use gtk_page_setup_get_page_width, (after defining *
+ *      the PageSetup structure, but it gave a value of only a little   *
+ *      more than 10% of what was needed to get the full page width.    *
+ * ******************************************************************** */
+
+static void
+set_col_values (StylePrintTable *self, GRPINF *grp)
+{
+    StylePrintTablePrivate *priv;
+    ROWPLAN *plan;
+    double pagewidth;
+    guint idx;
+   
+    priv = style_print_table_get_instance_private (self);
+    plan = ROW_PLAN(priv, grp);
+    pagewidth = priv->pagewidth;
+
+    //TODO: We may need to add in Left Margin
+    priv->xpos = 0;
+
+    for (idx = 0; idx < plan->ncells; idx++)
+    {
+        CELLINF *cell = g_ptr_array_index (grp->celldefs, idx);
+        double cellwidth = (cell->percent * pagewidth)/100;
+
+        plan->x[idx] = priv->xpos;
+        plan->textx[idx] = priv->xpos + cell->padleft;
+        plan->textwidth[idx] = cellwidth - cell->padleft - cell->padright;
+        priv->xpos += cellwidth;
+    }
+}
+
+/* ******************************************************************** *
+ * get_advances() - Get the advance table for "font" in the current     *
+ *      print context, measuring it if this is its first use.           *
+ * ******************************************************************** */
+
+static ADVTABLE *
+get_advances (StylePrintTable *self, const PangoFontDescription *font)
+{
+    StylePrintTablePrivate *priv;
+    ADVTABLE *tbl;
+
+    priv = style_print_table_get_instance_private (self);
+
+    if (!(tbl = g_hash_table_lookup (priv->advances, font)))
+    {
+        PangoLayout *layout = pango_layout_new (priv->pango);
+
+        pango_layout_set_font_description (layout, font);
+        tbl = _style_print_advances_new (layout);
+        g_object_unref (layout);
+        g_hash_table_insert (priv->advances, (gpointer)font, tbl);
+    }
+
+    return tbl;
+}
+
+/* ******************************************************************** *
+ * make_layouts() - Create the layout for each cell of a row definition *
+ *      and set its font, width and alignment, which do not change      *
+ *      during the printout, so only the text need be set per cell.     *
+ *      Call after set_col_values().                                    *
+ * ******************************************************************** */
+
+static void
+make_layouts (StylePrintTable *self, GRPINF *grp)
+{
+    StylePrintTablePrivate *priv;
+    ROWPLAN *plan;
+    guint col;
+
+    priv = style_print_table_get_instance_private (self);
+    plan = ROW_PLAN(priv, grp);
+
+    if (!plan->layout)
+    {
+        plan->layout = g_new0 (PangoLayout *, plan->ncells);
+        plan->adv = g_new0 (ADVTABLE *, plan->ncells);
+    }
+
+    for (col = 0; col < plan->ncells; col++)
+    {
+        PangoLayout *layout;
+
+        if (plan->layout[col])
+        {
+            g_object_unref (plan->layout[col]);
+        }
+
+        layout = pango_layout_new (priv->pango);
+        pango_layout_set_font_description (layout, plan->font[col]);
+        pango_layout_set_width (layout, plan->textwidth[col] * PANGO_SCALE);
+        pango_layout_set_alignment (layout, plan->align[col]);
+        plan->layout[col] = layout;
+        plan->adv[col] = get_advances (self, plan->font[col]);
+    }
+}
+
+/* ******************************************************************** *
+ * update_layouts() - Bring the layouts of a row definition up to date  *
+ *      with the cairo context of the page being drawn.                 *
+ * ******************************************************************** */
+
+static void
+update_layouts (StylePrintTable *self, GRPINF *grp)
+{
+    StylePrintTablePrivate *priv;
+    ROWPLAN *plan;
+    guint col;
+
+    priv = style_print_table_get_instance_private (self);
+    plan = ROW_PLAN(priv, grp);
+
+    for (col = 0; col < plan->ncells; col++)
+    {
+        pango_cairo_update_layout (priv->cr, plan->layout[col]);
+    }
+}
+
+/* ******************************************************************** *
+ * cell_text() - Get the text of cell "col" of the render plan of a     *
+ *      row, for data row "rownum".  If "*owned" is set to TRUE, the    *
+ *      text was allocated, and must be freed by the caller.            *
+ * Returns: The text (of "*len" bytes), or NULL if none                 *
+ * ******************************************************************** */
+
+static gchar *
+cell_text (StylePrintTable *self, ROWPLAN *plan, guint col, int rownum,
+        gsize *len, gboolean *owned)
+{
+    gchar *celltext = NULL;
+    StylePrintTablePrivate *priv;
+
+    priv = style_print_table_get_instance_private (self);
+    *len = 0;
+    *owned = FALSE;
+
+    switch (plan->txtsource[col])
+    {
+        case TSRC_STATIC:
+            celltext = (gchar *)plan->text[col];
+            break;
+        case TSRC_DATA:
+            return (gchar *)row_slice (self, rownum, plan->colidx[col], len);
         case TSRC_NOW:
             //TODO:
             break;
         case TSRC_PAGE:
             celltext = g_strdup_printf ("Page %d", priv->pageno + 1);
-            deletecelltext = TRUE;
+            *owned = TRUE;
             break;
         case TSRC_PAGEOF:
             celltext = g_strdup_printf ("Page %d of %d", priv->pageno + 1,
                                                             priv->TotPages);
-            deletecelltext = TRUE;
+            *owned = TRUE;
             break;
         case TSRC_PRINTF:
             //TODO:
             break;
     }
 
-    if (celltext && strlen (celltext))
+    if (celltext)
+    {
+        *len = strlen (celltext);
+    }
+
+    return celltext;
+}
+
+/* ******************************************************************** *
+ * render_cell() - Measure cell "col" of the render plan of a row, for  *
+ *          data row "rownum".                                          *
+ * Returns: Height of the cell in points                                *
+ * ******************************************************************** */
+
+static int
+render_cell (StylePrintTable *self, ROWPLAN *plan, guint col, int rownum)
+{
+    gchar *celltext;
+    gsize textlen;
+    int CellHeight = 0;
+    PangoRectangle log_rect;
+    gboolean deletecelltext;
+    StylePrintTablePrivate *priv;
+   
+    priv = style_print_table_get_instance_private (self);
+    celltext = cell_text (self, plan, col, rownum, &textlen, &deletecelltext);
+
+    if (celltext && textlen)
     {
-        PangoLayout *layout =
-                    gtk_print_context_create_pango_layout (priv->context);
-        pango_layout_set_font_description (layout, cell->pangofont);
-        pango_layout_set_width (layout,
-                (cell->cellwidth - cell->padleft - cell->padright) *
-                 PANGO_SCALE);
-        pango_layout_set_alignment (layout, cell->layoutalign);
-        pango_layout_set_text (layout, celltext, -1);
-        pango_layout_get_extents (layout, NULL, &log_rect);
-        CellHeight = log_rect.height;
+        PangoLayout *layout = plan->layout[col];
+        gint width = plan->textwidth[col] * PANGO_SCALE;
+        MEASUREENTRY *ent;
+        gboolean known;
+
+        // Printable ASCII which is sure to fit on one line is one line
+        // high, and a text already measured in this column's font, width
+        // and alignment has a known height.  Neither need be laid out.
+        known = _style_print_advances_measure (plan->adv[col], celltext,
+                                               textlen, width, &CellHeight);
 
-        if (priv->DoPrint)
+        if (priv->measure && !known)
         {
-            cairo_move_to (priv->cr, cell->x + cell->padleft, rowtop);
-            pango_cairo_show_layout (priv->cr, layout);
+            if ((ent = _style_print_measure_cache_lookup (priv->measure,
+                            plan->font[col], width, plan->align[col],
+                            celltext, textlen)))
+            {
+                CellHeight = _style_print_measure_entry_get_height (ent);
+                known = TRUE;
+                ++(priv->measurehits);
+            }
+            else
+            {
+                ++(priv->measuremisses);
+            }
         }
 
-        g_object_unref (layout);
+        if (!known)
+        {
+            pango_layout_set_text (layout, celltext, textlen);
+            pango_layout_get_extents (layout, NULL, &log_rect);
+            CellHeight = log_rect.height;
+
+            if (priv->measure)
+            {
+                _style_print_measure_cache_insert (priv->measure,
+                            plan->font[col], width, plan->align[col],
+                            celltext, textlen, CellHeight);
+            }
+        }
     }
 
     if (deletecelltext)
@@ -1123,6 +1217,85 @@ render_cell (StylePrintTable *self, CELLINF *cell, int rownum,
     return CellHeight/PANGO_SCALE;
 }
 
+/* ******************************************************************** *
+ * draw_cell() - Draw cell "col" of the render plan of a row, for data  *
+ *          row "rownum", with its top at "rowtop".                     *
+ * ******************************************************************** */
+
+static void
+draw_cell (StylePrintTable *self, ROWPLAN *plan, guint col, int rownum,
+        double rowtop)
+{
+    gchar *celltext;
+    gsize textlen;
+    gboolean deletecelltext;
+    StylePrintTablePrivate *priv;
+
+    priv = style_print_table_get_instance_private (self);
+    celltext = cell_text (self, plan, col, rownum, &textlen, &deletecelltext);
+
+    if (celltext && textlen)
+    {
+        PangoLayout *layout = plan->layout[col];
+        gint width = plan->textwidth[col] * PANGO_SCALE;
+        MEASUREENTRY *ent = NULL;
+
+        // A text already cached is drawn with its own layout, which keeps
+        // its shaped glyphs from one time the text is drawn to the next.
+        // Drawing adds nothing to the cache: any other text is drawn with
+        // the column's layout.
+        if (priv->measure)
+        {
+            if ((ent = _style_print_measure_cache_lookup (priv->measure,
+                            plan->font[col], width, plan->align[col],
+                            celltext, textlen)))
+            {
+                ++(priv->measurehits);
+            }
+            else
+            {
+                ++(priv->measuremisses);
+            }
+        }
+
+        if (ent)
+        {
+            layout = _style_print_measure_entry_get_layout (ent, layout);
+        }
+        else
+        {
+            pango_layout_set_text (layout, celltext, textlen);
+        }
+
+        cairo_move_to (priv->cr, plan->textx[col], rowtop);
+        pango_cairo_show_layout (priv->cr, layout);
+    }
+
+    if (deletecelltext)
+    {
+        g_free (celltext);
+    }
+}
+
+/* ******************************************************************** *
+ * add_item() - Append an item to the display list of the page being    *
+ *      laid out.                                                       *
+ * Returns: The item, valid until the next item is added                *
+ * ******************************************************************** */
+
+static DISPITEM *
+add_item (StylePrintTable *self, gint kind, double x, double y,
+        double width, double height, double weight)
+{
+    DISPITEM item = {kind, x, y, width, height, weight, NULL, -1};
+    StylePrintTablePrivate *priv;
+
+    priv = style_print_table_get_instance_private (self);
+    g_array_append_val (priv->curpage, item);
+
+    return &g_array_index (priv->curpage, DISPITEM, priv->curpage->len - 1);
+}
+
 /* ******************************************************************** *
  * hline () - Renders a horizontal line across the page                 *
  * ******************************************************************** */
@@ -1133,15 +1306,7 @@ hline (StylePrintTable *self, double ypos, double weight)
     StylePrintTablePrivate *priv;
    
     priv = style_print_table_get_instance_private (self);
-
-    if (priv->DoPrint)
-    {
-        cairo_set_line_width (priv->cr, weight);
-        cairo_move_to (priv->cr, 0, ypos);
-        cairo_rel_line_to (priv->cr,
-                            gtk_print_context_get_width (priv->context), 0);
-        cairo_stroke (priv->cr);
-    }
+    add_item (self, DL_RULE, 0, ypos, priv->pagewidth, 0, weight);
 
     return 1;
 }
@@ -1208,25 +1373,23 @@ hline (StylePrintTable *self, double ypos, double weight)
 
 static int
 render_row (StylePrintTable *self,
-            GPtrArray *coldefs,
+            ROWPLAN *plan,
             ROWPAD *padding,
             int borderstyle,
             int rownum)
 {
     StylePrintTablePrivate *priv =
                     style_print_table_get_instance_private (self);
-    int colnum;
+    guint colnum;
     int MaxHeight = 0;
     double rowtop = priv->ypos;
+    DISPITEM *item;
 
+    // Padding which is not set (-1) is taken from the default padding
     if (padding)
     {
-        if (padding->top == -1)
-        {
-            padding->top = priv->DefaultPadding->top;
-        }
-
-        rowtop += padding->top;
+        rowtop += (padding->top == -1) ?
+                        priv->tmpl->DefaultPadding->top : padding->top;
     }
 
 /*    if (rowtop >= priv->pageheight)
@@ -1235,13 +1398,11 @@ render_row (StylePrintTable *self,
     }*/
 
     // Upper line for row
-    for (colnum = 0; colnum < coldefs->len; colnum++)
+    for (colnum = 0; colnum < plan->ncells; colnum++)
     {
         int CellHeight;
         
-        CellHeight =
-            render_cell (self, (CELLINF *)(coldefs->pdata[colnum]), rownum,
-                   rowtop);
+        CellHeight = render_cell (self, plan, colnum, rownum);
 
         if (CellHeight > MaxHeight)
         {
@@ -1249,26 +1410,18 @@ render_row (StylePrintTable *self,
         }
     }
 
+    item = add_item (self, DL_ROW, 0, rowtop, 0, MaxHeight, 0);
+    item->plan = plan;
+    item->row = rownum;
+
     // Do the VBars now while "rowtop" still points to the top of the row
     if (borderstyle & BDY_VBAR)
     {
         int idx;
 
-        if (priv->DoPrint)
+        for (idx = 1; idx < plan->ncells; idx++)
         {
-            for (idx = 1; idx < coldefs->len; idx++)
-            {
-                if (priv->DoPrint)
-                {
-                    //int rmargin = gtk_print_context_get_width (priv->context);
-
-                    cairo_set_line_width (priv->cr, 2.0);
-                    cairo_move_to (priv->cr,
-                            ((CELLINF *)(coldefs->pdata[idx]))->x, rowtop);
-                    cairo_rel_line_to (priv->cr, 0, MaxHeight);
-                    cairo_stroke (priv->cr);
-                }
-            }
+            add_item (self, DL_RULE, plan->x[idx], rowtop, 0, MaxHeight, 2.0);
         }
     }
 
@@ -1276,17 +1429,84 @@ render_row (StylePrintTable *self,
 
     if (padding)
     {
-        if (padding->bottom == -1)
-        {
-            padding->bottom = priv->DefaultPadding->bottom;
-        }
-
-        rowtop += padding->bottom;
+        rowtop += (padding->bottom == -1) ?
+                        priv->tmpl->DefaultPadding->bottom : padding->bottom;
     }
 
     return rowtop - priv->ypos;
 }
 
+/* ******************************************************************** *
+ * add_row_height() - Record the height of body row number "row", if    *
+ *      it is the next one.  Each row is laid out once by the dry run,  *
+ *      so the heights are recorded in row order.                       *
+ * ******************************************************************** */
+
+static void
+add_row_height (StylePrintTable *self, gint row, double height)
+{
+    StylePrintTablePrivate *priv;
+    gfloat ht = height;
+    gdouble top;
+
+    priv = style_print_table_get_instance_private (self);
+
+    if (row != (gint)priv->rowheights->len)
+    {
+        return;
+    }
+
+    top = g_array_index (priv->rowtops, gdouble, row) + ht;
+    g_array_append_val (priv->rowheights, ht);
+    g_array_append_val (priv->rowtops, top);
+}
+
+/* ******************************************************************** *
+ * add_group_key() - Record row number "row", which begins a run of     *
+ *      rows of group "grp", as the first row with its value, unless    *
+ *      the value has been seen before.  A NULL value is not recorded,  *
+ *      so that it cannot be found as an empty string.                  *
+ * ******************************************************************** */
+
+static void
+add_group_key (StylePrintTable *self, GRPINF *grp, gint row)
+{
+    StylePrintTablePrivate *priv;
+    GHashTable *keys;
+    const gchar *text;
+    gchar *key;
+    gsize len;
+
+    priv = style_print_table_get_instance_private (self);
+
+    if (!grp->grpcol)
+    {
+        return;
+    }
+
+    if (!(text = row_slice (self, row, GRP_STATE(priv, grp)->grpcolidx,
+                                                                    &len)))
+    {
+        return;
+    }
+
+    if (!(keys = g_hash_table_lookup (priv->grpkeys, grp->grpcol)))
+    {
+        keys = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+        g_hash_table_insert (priv->grpkeys, g_strdup (grp->grpcol), keys);
+    }
+
+    key = g_strndup (text, len);
+
+    if (g_hash_table_contains (keys, key))
+    {
+        g_free (key);
+        return;
+    }
+
+    g_hash_table_insert (keys, key, GINT_TO_POINTER(row));
+}
+
 /* ******************************************************************** *
  * render_row_grp() - Render a series of rows from an array of cell     *
  *          defs.                                                       *
@@ -1297,20 +1517,22 @@ render_row (StylePrintTable *self,
  *          (5) self->layout                                              *
  *          (6) cur_row - The first row to print                        *
  *          (7) end_row - The last row to print (+1)                    *
- *          //(8) TRUE                                                    *
+ *          (8) body - TRUE for the rows of a body, whose heights are   *
+ *              recorded                                                *
  * Returns: The ending row                                              *
  * ******************************************************************** */
 
 static int
 render_row_grp (StylePrintTable *self,       // Global Data storage
-                GPtrArray *col_defs,         // The coldefs array
+                ROWPLAN *plan,               // The row's render plan
                 ROWPAD *padding,
                 int borderstyle,
                 // formatting->body,           // 
                 // formatting
                 PangoLayout *layout,
                 int cur_row,                // The first row to print
-                int end_row)                // The last row to print + 1
+                int end_row,                // The last row to print + 1
+                gboolean body)              // Record the row heights
 {
     StylePrintTablePrivate *priv;
     priv = style_print_table_get_instance_private (self);
@@ -1321,7 +1543,7 @@ render_row_grp (StylePrintTable *self,       // Global Data storage
 
 
     // If no cell defs, return...
-    if (!col_defs)
+    if (!plan)
     {
         return cur_row;
     }
@@ -1352,9 +1574,12 @@ render_row_grp (StylePrintTable *self,       // Global Data storage
 //        max_y -= line_ht * 2;
 //    }
 
-    for (cur_idx = cur_row; cur_idx < end_row; cur_idx++)
+    for (cur_idx = cur_row;
+            (cur_idx < end_row) && have_row (self, cur_idx); cur_idx++)
     {
-        (priv->ypos) += render_row (self, col_defs, padding,
+        double rowtop = priv->ypos;
+
+        (priv->ypos) += render_row (self, plan, padding,
                             borderstyle, cur_idx);
 
         // Render HLINE below each line, if applicable
@@ -1363,6 +1588,11 @@ render_row_grp (StylePrintTable *self,       // Global Data storage
             priv->ypos += hline (self, priv->ypos, 1.0);
         }
 
+        if (body)
+        {
+            add_row_height (self, cur_idx, priv->ypos - rowtop);
+        }
+
         if (priv->ypos >= max_y)
         {
             ++cur_idx;      // Position to next data row for return
@@ -1408,18 +1638,9 @@ render_header (StylePrintTable *self, GRPINF *curhdr)
 
     if (curhdr->celldefs)
     {
-        if (!curhdr->cells_formatted)
-        {
-            //TODO: We may need to add in Left Margin
-            priv->xpos = 0;
-            g_ptr_array_foreach (curhdr->celldefs,
-                    (GFunc)set_col_values, self);
-            curhdr->cells_formatted = TRUE;
-        }
-
-        render_row_grp (self, curhdr->celldefs,
+        render_row_grp (self, ROW_PLAN(priv, curhdr),
                         curhdr->padding, curhdr->borderstyle, priv->layout,
-                        priv->datarow, priv->datarow + 1);
+                        priv->datarow, priv->datarow + 1, FALSE);
     }
 
     if (curhdr->pointsbelow)
@@ -1454,24 +1675,12 @@ render_body (StylePrintTable *self,
         render_header (self, bdy->header);
     }
 
-    if (bdy->celldefs)
-    {
-        if (!bdy->cells_formatted)
-        {
-            //TODO: We may need to add in Left Margin
-            priv->xpos = 0;
-            g_ptr_array_foreach (bdy->celldefs, (GFunc)set_col_values,
-                                self);
-            bdy->cells_formatted = TRUE;
-        }
-    }
-
-    priv->datarow = render_row_grp (self, bdy->celldefs,
+    priv->datarow = render_row_grp (self, ROW_PLAN(priv, bdy),
                 bdy->padding, bdy->borderstyle,
                 //priv->formatting->body,
                 //priv->formatting,
                 priv->layout,
-                priv->datarow, maxrow
+                priv->datarow, maxrow, TRUE
                 );
 }
 
@@ -1518,24 +1727,18 @@ render_group (StylePrintTable *self,
     }*/
 
     // This loop parses the entire range passed to the group.
-    while ((grp_idx < maxrow) && (priv->ypos < priv->pageheight))
+    while ((grp_idx < maxrow) && have_row (self, grp_idx) &&
+                (priv->ypos < priv->pageheight))
     {
-        char *grptxt = g_hash_table_lookup (g_ptr_array_index (priv->pgresult,
-                                                grp_idx),
-                                            curgrp->grpcol);
-
         /* Break the main group down into subgroups (or the body)
-           Do this by comparing the string in the column defining the group.
+           The group index gives the row following the run of rows with
+           the same value in the column defining the group.
            The variable "grp_idx" is the max value (+ 1) for the rows that
            will be members of the subgroup (or body set)
         */
 
-        do {
-            ++grp_idx;
-        } while ((grp_idx < maxrow) && STRMATCH(grptxt,
-                    g_hash_table_lookup (g_ptr_array_index (priv->pgresult,
-                                                grp_idx),
-                                            curgrp->grpcol)));
+        add_group_key (self, curgrp, grp_idx);
+        grp_idx = group_end (self, curgrp, grp_idx, maxrow);
 
         // Print Group Header, if applicable...
 
@@ -1576,25 +1779,16 @@ render_group (StylePrintTable *self,
         }
 
         // Render footers here???
-        if (priv->DoPrint)
+        if (curgrp->borderstyle & (SINGLEBOX | DBLBOX))
         {
-            if (curgrp->borderstyle & (SINGLEBOX | DBLBOX))
-            {
-                cairo_set_line_width (priv->cr, 4.0);
-                cairo_rectangle (priv->cr, 0, grp_top,
-                                   gtk_print_context_get_width (priv->context),
-                                   priv->ypos - grp_top); 
-                cairo_stroke (priv->cr);
-            }
+            add_item (self, DL_BOX, 0, grp_top, priv->pagewidth,
+                        priv->ypos - grp_top, 4.0);
+        }
 
-            if (curgrp->borderstyle & DBLBOX)
-            {
-                cairo_set_line_width (priv->cr, 2.0);
-                cairo_rectangle (priv->cr, 16, grp_top + 16,
-                            gtk_print_context_get_width (priv->context) - 32,
-                            priv->ypos - grp_top - 32); 
-                cairo_stroke (priv->cr);
-            }
+        if (curgrp->borderstyle & DBLBOX)
+        {
+            add_item (self, DL_BOX, 16, grp_top + 16, priv->pagewidth - 32,
+                        priv->ypos - grp_top - 32, 2.0);
         }
 
         if (curgrp->pointsbelow)
@@ -1614,33 +1808,25 @@ static void
 render_page (StylePrintTable *self)
 {
     GRPINF *curgrp;
-    int lastrow;
+    // The rows end wherever the page, or the source, runs out
+    int lastrow = G_MAXINT;
+    guint headers;
     StylePrintTablePrivate *priv;
    
     priv = style_print_table_get_instance_private (self);
 
     priv->ypos = 0;
 
-    if (priv->DoPrint)
-    {
-        lastrow = (int)g_array_index (priv->PageEndRow, gint, priv->pageno);
-    }
-    else
-    {
-        lastrow = priv->pgresult->len;
-    }
+    headers = PAGE_CHECK(priv, priv->pageno)->headers;
 
-    if (!priv->pageno)       // If first page, print Docheader if present
+    if (headers & PAGE_DOCHEADER)   // If first page, print Docheader
     {
-        if (priv->DocHeader)
-        {
-            render_header (self, priv->DocHeader);
-        }
+        render_header (self, priv->tmpl->DocHeader);
     }
 
-    if (priv->PageHeader)
+    if (headers & PAGE_PAGEHEADER)
     {
-        render_header (self, priv->PageHeader);
+        render_header (self, priv->tmpl->PageHeader);
 //        if (priv->PageHeader->celldefs)
 //        {
 //            if (!priv->PageHeader->cells_formatted)
@@ -1658,7 +1844,7 @@ render_page (StylePrintTable *self)
     }
 
     // Now we're ready to render the data...
-    curgrp = priv->grpHd;
+    curgrp = priv->tmpl->grpHd;
 
     if (curgrp->grptype == GRPTY_GROUP)
     {
@@ -1672,76 +1858,501 @@ render_page (StylePrintTable *self)
     }
 }
 
+/* ******************************************************************** *
+ * add_checkpoint() - Record the checkpoint for the page about to be    *
+ *      laid out, which begins at the current data row.                 *
+ * ******************************************************************** */
+
 static void
-style_print_table_draw_page (GtkPrintOperation *op,
-                                GtkPrintContext *context, int page_nr)
+add_checkpoint (StylePrintTable *self)
 {
     StylePrintTablePrivate *priv;
-   
-    priv = style_print_table_get_instance_private (STYLE_PRINT_TABLE(op));
+    PAGECHECK check;
 
-    priv->pageno = page_nr;
-    priv->context = context;
-    priv->pageheight = gtk_print_context_get_height (priv->context);
-//    gtk_print_STYLE_PRINT_TABLE(operation)_set_unit (operation, GTK_UNIT_POINTS);
-    priv->cr = gtk_print_context_get_cairo_context (context);
-    priv->layout = gtk_print_context_create_pango_layout (context);
-    render_page (STYLE_PRINT_TABLE(op));
-    g_object_unref (priv->layout);
+    priv = style_print_table_get_instance_private (self);
+
+    check.startrow = priv->datarow;
+    check.endrow = priv->datarow;
+    check.headers = 0;
+
+    if (!priv->pageno && priv->tmpl->DocHeader)
+    {
+        check.headers |= PAGE_DOCHEADER;
+    }
+
+    if (priv->tmpl->PageHeader)
+    {
+        check.headers |= PAGE_PAGEHEADER;
+    }
+
+    g_array_append_val (priv->pagechecks, check);
+}
+
+/* ******************************************************************** *
+ * draw_row() - Draw the cells of a row of the display list.            *
+ * ******************************************************************** */
+
+static void
+draw_row (StylePrintTable *self, DISPITEM *item)
+{
+    guint col;
+
+    // Only rows which were present when the page was laid out are in the
+    // list, but they may need reading in again
+    if (!have_row (self, item->row))
+    {
+        return;
+    }
+
+    for (col = 0; col < item->plan->ncells; col++)
+    {
+        draw_cell (self, item->plan, col, item->row, item->y);
+    }
+}
+
+/* ******************************************************************** *
+ * set_target() - Set the cairo context the pages are drawn on, and     *
+ *      the size of the printable area.  "pango", if not NULL, is a new  *
+ *      Pango context to lay the pages out in (which set_target() takes *
+ *      over), in which case nothing measured in the old one is kept.   *
+ * ******************************************************************** */
+
+static void
+set_target (StylePrintTable *self, cairo_t *cr, PangoContext *pango,
+        double width, double height)
+{
+    StylePrintTablePrivate *priv;
+
+    priv = style_print_table_get_instance_private (self);
+
+    priv->cr = cr;
+    priv->pagewidth = width;
+    priv->pageheight = height;
+
+    if (!pango)
+    {
+        return;
+    }
+
+    if (priv->pango)
+    {
+        g_object_unref (priv->pango);
+    }
+
+    priv->pango = pango;
+    g_hash_table_remove_all (priv->advances);
+
+    if (priv->measure)
+    {
+        _style_print_measure_cache_free (priv->measure);
+        priv->measure = _style_print_measure_cache_new (priv->measuresize);
+    }
+}
+
+/* ******************************************************************** *
+ * use_print_context() - Lay out and draw the pages for a GTK print     *
+ *      context.                                                        *
+ * Returns: TRUE if it is not the context last used, so the layouts     *
+ *      need making again                                               *
+ * ******************************************************************** */
+
+static gboolean
+use_print_context (StylePrintTable *self, GtkPrintContext *context)
+{
+    StylePrintTablePrivate *priv;
+    gboolean changed;
+
+    priv = style_print_table_get_instance_private (self);
+    changed = (context != priv->context);
+    priv->context = context;
+
+    set_target (self, gtk_print_context_get_cairo_context (context),
+            changed ? gtk_print_context_create_pango_context (context) : NULL,
+            gtk_print_context_get_width (context),
+            gtk_print_context_get_height (context));
+
+    return changed;
+}
+
+/* ******************************************************************** *
+ * replay_page() - Draw page "page_nr" on the current cairo context by  *
+ *      replaying the display list made for it by paginate().  No       *
+ *      layout is done here beyond shaping the texts drawn.  The page   *
+ *      is drawn from its checkpoint alone, so the pages may be drawn   *
+ *      in any order, or only some of them.                             *
+ * ******************************************************************** */
+
+static void
+replay_page (StylePrintTable *self, gint page_nr)
+{
+    StylePrintTablePrivate *priv;
+    GArray *list;
+    guint idx;
+
+    priv = style_print_table_get_instance_private (self);
+
+    priv->pageno = page_nr;
+    priv->datarow = PAGE_CHECK(priv, page_nr)->startrow;
+
+    if (!seek_row (self, priv->datarow))
+    {
+        return;
+    }
+
+    list = g_ptr_array_index (priv->pages, page_nr);
+
+    for (idx = 0; idx < list->len; idx++)
+    {
+        DISPITEM *item = &g_array_index (list, DISPITEM, idx);
+
+        switch (item->kind)
+        {
+            case DL_ROW:
+                draw_row (self, item);
+                break;
+            case DL_RULE:
+                cairo_set_line_width (priv->cr, item->weight);
+                cairo_move_to (priv->cr, item->x, item->y);
+                cairo_rel_line_to (priv->cr, item->width, item->height);
+                cairo_stroke (priv->cr);
+                break;
+            case DL_BOX:
+                cairo_set_line_width (priv->cr, item->weight);
+                cairo_rectangle (priv->cr, item->x, item->y,
+                                    item->width, item->height);
+                cairo_stroke (priv->cr);
+                break;
+        }
+    }
+}
+
+static void
+style_print_table_draw_page (GtkPrintOperation *op,
+                                GtkPrintContext *context, int page_nr)
+{
+    StylePrintTablePrivate *priv;
+    RowFunc func;
+   
+    priv = style_print_table_get_instance_private (STYLE_PRINT_TABLE(op));
+
+    if (!priv->pages || (page_nr >= priv->pages->len))
+    {
+        return;
+    }
+
+    // The cell layouts are kept from one page to the next, and only need
+    // updating for the page's cairo context - unless the print context
+    // itself is not the one they were made for.
+    func = use_print_context (STYLE_PRINT_TABLE(op), context) ?
+                                            make_layouts : update_layouts;
+    for_all_rows (STYLE_PRINT_TABLE(op), func);
+    replay_page (STYLE_PRINT_TABLE(op), page_nr);
 }
 
 /* ************************************************************************ *
- * begin_print() - Called after print settings have been set up.            *
- *      Here we set up the default font, determine the height of a line.    *
- *      We paginate the output by doing a "dry run" through the data        *
+ * paginate() - Set up the default font, determine the height of a line,    *
+ *      and paginate the output by doing a "dry run" through the data,      *
+ *      recording the checkpoint and display list of each page.  Call       *
+ *      after set_target().                                                 *
  * ************************************************************************ */
 
 static void
-style_print_table_begin_print (GtkPrintOperation *po,
-                                 GtkPrintContext *context)
+paginate (StylePrintTable *self)
 {
     PangoLayout *lo;
     PangoRectangle log_rect;
     StylePrintTablePrivate *priv;
    
-    priv = style_print_table_get_instance_private (STYLE_PRINT_TABLE(po));
+    priv = style_print_table_get_instance_private (self);
 
     priv->datarow = 0;
     priv->pageno = 0;
-    priv->context = context;
-    priv->pageheight = gtk_print_context_get_height (priv->context);
     priv->TotPages = 0;
-    priv->DoPrint = FALSE;
-//    gtk_print_operation_set_unit (operation, GTK_UNIT_POINTS);
-    priv->layout = gtk_print_context_create_pango_layout (context);
+    priv->layout = pango_layout_new (priv->pango);
 
     lo = pango_layout_copy (priv->layout);
-    pango_layout_set_font_description (lo, priv->defaultcell->pangofont);
-    pango_layout_set_width (lo, gtk_print_context_get_width (priv->context));
+    pango_layout_set_font_description (lo,
+                                    priv->tmpl->defaultcell->pangofont);
+    pango_layout_set_width (lo, priv->pagewidth);
     pango_layout_set_text (lo, "Ty", -1);
     pango_layout_get_extents (lo, NULL, &log_rect);
     priv->textheight = log_rect.height/PANGO_SCALE;
     g_object_unref (lo);
 
-    priv->PageEndRow = g_array_new (FALSE, FALSE, sizeof(gint));
-
-    while ((priv->datarow) < priv->pgresult->len)
-    {
+    // The cell positions depend on the page width, so are set for each
+    // printout rather than in the (shared) template.
+    for_all_rows (self, set_col_values);
+    for_all_rows (self, make_layouts);
+
+    clear_pagination (self);
+    priv->pagechecks = g_array_new (FALSE, FALSE, sizeof(PAGECHECK));
+    priv->rowheights = g_array_new (FALSE, FALSE, sizeof(gfloat));
+    priv->rowtops = g_array_new (FALSE, TRUE, sizeof(gdouble));
+    g_array_set_size (priv->rowtops, 1);
+    priv->grpkeys = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+                                    (GDestroyNotify)g_hash_table_destroy);
+
+    priv->pages = g_ptr_array_new_with_free_func (
+                                        (GDestroyNotify)g_array_unref);
+
+    // Rows preceding the page being laid out are released as we go,
+    // so only the rows for the current page (and any group which begins
+    // on it) need be held in memory.  What is laid out on each page is
+    // kept in its display list, for replay_page() to replay.
+    while (seek_row (self, priv->datarow))
+    {
+        priv->pageno = priv->TotPages;
+        add_checkpoint (self);
+        priv->curpage = g_array_new (FALSE, FALSE, sizeof(DISPITEM));
+        g_ptr_array_add (priv->pages, priv->curpage);
         priv->ypos = 0;
-        render_page (STYLE_PRINT_TABLE(po));
-        g_array_append_val (priv->PageEndRow, priv->datarow);
+        render_page (self);
+        PAGE_CHECK(priv, priv->pageno)->endrow = priv->datarow;
         ++(priv->TotPages);
     }
 
-    gtk_print_operation_set_n_pages (po,
-            priv->TotPages ? priv->TotPages : 1);
     // Re-initialize Instance variables
     g_object_unref (priv->layout);
-    priv->DoPrint = TRUE;
+    priv->curpage = NULL;
     priv->datarow = 0;
     priv->pageno = 0;
 }
 
+/* ************************************************************************ *
+ * begin_print() - Called after print settings have been set up.            *
+ * ************************************************************************ */
+
+static void
+style_print_table_begin_print (GtkPrintOperation *po,
+                                 GtkPrintContext *context)
+{
+    StylePrintTablePrivate *priv;
+   
+    priv = style_print_table_get_instance_private (STYLE_PRINT_TABLE(po));
+
+//    gtk_print_operation_set_unit (operation, GTK_UNIT_POINTS);
+    use_print_context (STYLE_PRINT_TABLE(po), context);
+    paginate (STYLE_PRINT_TABLE(po));
+    gtk_print_operation_set_n_pages (po,
+            priv->TotPages ? priv->TotPages : 1);
+}
+
+/* ******************************************************************** *
+ * bind_cells() - Resolve the column for each "data" cell in a row      *
+ *      definition to its index in the dataset.  The name of each       *
+ *      column that cannot be found is appended to errs.                *
+ * ******************************************************************** */
+
+static void
+bind_cells (StylePrintTable *self, GRPINF *grp, GString *errs)
+{
+    StylePrintTablePrivate *priv;
+    ROWPLAN *plan;
+    guint idx;
+
+    priv = style_print_table_get_instance_private (self);
+
+    if (!grp || !(plan = ROW_PLAN(priv, grp)))
+    {
+        return;
+    }
+
+    for (idx = 0; idx < plan->ncells; idx++)
+    {
+        if (plan->txtsource[idx] != TSRC_DATA)
+        {
+            continue;
+        }
+
+        plan->colidx[idx] = style_print_dataset_get_column_index (
+                                            priv->dataset, plan->text[idx]);
+
+        if (plan->colidx[idx] < 0)
+        {
+            g_string_append_printf (errs, "Cell data column '%s' not found\n",
+                    plan->text[idx] ? plan->text[idx] : "(none)");
+        }
+    }
+}
+
+/* ******************************************************************** *
+ * bind_columns() - Resolve every column reference in the formatting    *
+ *      tree (cell "celltext" for data cells, and group "groupsource")  *
+ *      to an index in the dataset, so that nothing needs to be looked  *
+ *      up by name while rendering.                                     *
+ * Returns: FALSE (after reporting them) if any columns are not found   *
+ * ******************************************************************** */
+
+static gboolean
+bind_columns (StylePrintTable *self)
+{
+    StylePrintTablePrivate *priv;
+    StylePrintTemplate *tmpl;
+    GRPINF *grp;
+    GString *errs;
+    gboolean ok;
+
+    priv = style_print_table_get_instance_private (self);
+    tmpl = priv->tmpl;
+    errs = g_string_new (NULL);
+
+    bind_cells (self, tmpl->DocHeader, errs);
+    bind_cells (self, tmpl->PageHeader, errs);
+
+    for (grp = tmpl->grpHd; grp; grp = grp->grpchild)
+    {
+        if (grp->grptype == GRPTY_GROUP)
+        {
+            GRP_STATE(priv, grp)->grpcolidx =
+                style_print_dataset_get_column_index (priv->dataset,
+                                                        grp->grpcol);
+
+            if (GRP_STATE(priv, grp)->grpcolidx < 0)
+            {
+                g_string_append_printf (errs,
+                        "Group source column '%s' not found\n",
+                        grp->grpcol ? grp->grpcol : "(none)");
+            }
+        }
+
+        bind_cells (self, grp->header, errs);
+        bind_cells (self, grp, errs);
+    }
+
+    if (!tmpl->grpHd)
+    {
+        g_string_append (errs, "No <group> or <body> is defined\n");
+    }
+
+    if ((ok = (errs->len == 0)) == FALSE)
+    {
+        report_error (self, errs->str);
+    }
+    else
+    {
+        // The group columns are known, so the source can encode them as
+        // it loads them, and the group index can be built.
+        GPtrArray *keys = g_ptr_array_new ();
+
+        for (grp = tmpl->grpHd; grp && (grp->grptype == GRPTY_GROUP);
+                                                    grp = grp->grpchild)
+        {
+            g_ptr_array_add (keys, (gpointer)grp->grpcol);
+        }
+
+        g_ptr_array_add (keys, NULL);
+        style_print_row_source_set_key_columns (priv->source,
+                                    (const gchar * const *)keys->pdata);
+        g_ptr_array_free (keys, TRUE);
+
+        priv->indexed = 0;
+        index_rows (self);
+    }
+
+    g_string_free (errs, TRUE);
+    return ok;
+}
+
+/* ******************************************************************** *
+ * clear_pagination() - Free the checkpoints, row heights and group     *
+ *      keys of the last printout.  These are kept after the printout   *
+ *      ends, for the page lookup functions.                            *
+ * ******************************************************************** */
+
+static void
+clear_pagination (StylePrintTable *self)
+{
+    StylePrintTablePrivate *priv;
+
+    priv = style_print_table_get_instance_private (self);
+
+    if (priv->pagechecks)
+    {
+        g_array_free (priv->pagechecks, TRUE);
+        g_array_free (priv->rowheights, TRUE);
+        g_array_free (priv->rowtops, TRUE);
+        g_hash_table_destroy (priv->grpkeys);
+        priv->pagechecks = NULL;
+        priv->rowheights = NULL;
+        priv->rowtops = NULL;
+        priv->grpkeys = NULL;
+    }
+}
+
+/* ******************************************************************** *
+ * prepare_report() - Set up the render plans and group state for a     *
+ *      printout, and bind the template to the columns of the data.     *
+ *      Call finish_report() afterwards, whatever the result.           *
+ * Returns: FALSE (after reporting it) if the columns cannot be bound   *
+ * ******************************************************************** */
+
+static gboolean
+prepare_report (StylePrintTable *self)
+{
+    StylePrintTablePrivate *priv;
+    gint idx;
+   
+    priv = style_print_table_get_instance_private (self);
+
+    priv->measurehits = 0;
+    priv->measuremisses = 0;
+    priv->measure = priv->measuresize ?
+                _style_print_measure_cache_new (priv->measuresize) : NULL;
+    priv->advances = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                        NULL, (GDestroyNotify)_style_print_advances_free);
+    priv->rowplan = g_new0 (ROWPLAN, priv->tmpl->nrows);
+    for_all_rows (self, plan_row);
+    priv->grpstate = g_new0 (GRPSTATE, priv->tmpl->ngroups);
+
+    for (idx = 0; idx < priv->tmpl->ngroups; idx++)
+    {
+        priv->grpstate[idx].grpcolidx = -1;
+    }
+
+    return bind_columns (self);
+}
+
+/* ******************************************************************** *
+ * finish_report() - Free what the printout allocated, other than the   *
+ *      pagination kept for the page lookup functions.                  *
+ * ******************************************************************** */
+
+static void
+finish_report (StylePrintTable *self)
+{
+    StylePrintTablePrivate *priv;
+    gint idx;
+   
+    priv = style_print_table_get_instance_private (self);
+
+    if (priv->pages)
+    {
+        g_ptr_array_free (priv->pages, TRUE);
+        priv->pages = NULL;
+    }
+
+    for (idx = 0; idx < priv->tmpl->ngroups; idx++)
+    {
+        g_free (priv->grpstate[idx].grplasttxt);
+
+        if (priv->grpstate[idx].grpends)
+        {
+            g_array_free (priv->grpstate[idx].grpends, TRUE);
+        }
+    }
+
+    g_free (priv->grpstate);
+    priv->grpstate = NULL;
+    free_plans (self);
+    _style_print_measure_cache_free (priv->measure);
+    priv->measure = NULL;
+    g_hash_table_destroy (priv->advances);
+    priv->advances = NULL;
+    g_clear_object (&priv->pango);
+    priv->context = NULL;
+    priv->cr = NULL;
+}
+
 /*
  * render_report (StylePrintTable *self)
  * @self: The #StylePrintTable
@@ -1750,68 +2361,311 @@ style_print_table_begin_print (GtkPrintOperation *po,
  *
  */
 
-static void
-render_report (StylePrintTable *self)
+static GtkPrintOperationResult
+render_report (StylePrintTable *self, GtkPrintOperationAction action,
+               GError **error)
 {
-    GError *g_err;
+    GtkPrintOperationResult res = GTK_PRINT_OPERATION_RESULT_ERROR;
     StylePrintTablePrivate *priv;
    
     priv = style_print_table_get_instance_private (self);
 
-
-    gtk_print_operation_run (GTK_PRINT_OPERATION(self),
-            GTK_PRINT_OPERATION_ACTION_PRINT_DIALOG, priv->w_main, &g_err);
+    if (prepare_report (self))
+    {
+        res = gtk_print_operation_run (GTK_PRINT_OPERATION(self),
+                                       action, priv->w_main, error);
+    }
     
-    // Now free up everything that has been allocated...
-    if (priv->PageEndRow)
+    finish_report (self);
+    return res;
+}
+
+/* ******************************************************************** *
+ * export_range() - Paginate the printout for a PDF file "filename",    *
+ *      laid out as GTK would for the operation's default page setup,   *
+ *      and draw pages "first" to "last" (-1 for the last page) to it.  *
+ *      Errors are reported with report_error(), and the file is then   *
+ *      removed, so that no partial PDF is left behind.                 *
+ * ******************************************************************** */
+
+static void
+export_range (StylePrintTable *self, const gchar *filename, gint first,
+        gint last)
+{
+    StylePrintTablePrivate *priv;
+    GtkPageSetup *setup;
+    cairo_surface_t *surface;
+    cairo_t *cr;
+    PangoContext *pango;
+    gint page;
+
+    priv = style_print_table_get_instance_private (self);
+
+    if ((setup = gtk_print_operation_get_default_page_setup (
+                                            GTK_PRINT_OPERATION(self))))
+    {
+        g_object_ref (setup);
+    }
+    else
     {
-        g_array_free (priv->PageEndRow, TRUE);
-        priv->PageEndRow = NULL;
+        setup = gtk_page_setup_new ();
     }
 
-    if (priv->elList)
+    surface = cairo_pdf_surface_create (filename,
+                    gtk_page_setup_get_paper_width (setup, GTK_UNIT_POINTS),
+                    gtk_page_setup_get_paper_height (setup, GTK_UNIT_POINTS));
+    cr = cairo_create (surface);
+
+    if (cairo_surface_status (surface) != CAIRO_STATUS_SUCCESS)
     {
-        g_slist_free (priv->elList);
-        priv->elList = NULL;
+        report_error (self, (gchar *)cairo_status_to_string (
+                                        cairo_surface_status (surface)));
+    }
+    else
+    {
+        // As GTK does, draw within the margins, with text laid out at
+        // 72 dpi, so that a unit is a point
+        cairo_translate (cr,
+                    gtk_page_setup_get_left_margin (setup, GTK_UNIT_POINTS),
+                    gtk_page_setup_get_top_margin (setup, GTK_UNIT_POINTS));
+        pango = pango_cairo_create_context (cr);
+        pango_cairo_context_set_resolution (pango, 72);
+        set_target (self, cr, pango,
+                    gtk_page_setup_get_page_width (setup, GTK_UNIT_POINTS),
+                    gtk_page_setup_get_page_height (setup, GTK_UNIT_POINTS));
+        paginate (self);
+
+        if ((last < 0) || (last >= priv->TotPages))
+        {
+            last = priv->TotPages - 1;
+        }
+
+        if (first > last)
+        {
+            report_error (self, "The pages to export are not in the printout");
+        }
+        else
+        {
+            for (page = first; page <= last; page++)
+            {
+                replay_page (self, page);
+                cairo_show_page (cr);
+            }
+        }
+    }
+
+    cairo_destroy (cr);
+    cairo_surface_finish (surface);
+
+    if (cairo_surface_status (surface) != CAIRO_STATUS_SUCCESS)
+    {
+        report_error (self, (gchar *)cairo_status_to_string (
+                                        cairo_surface_status (surface)));
+    }
+
+    cairo_surface_destroy (surface);
+    g_object_unref (setup);
+
+    if (*priv->error)
+    {
+        g_remove (filename);
+    }
+}
+
+/**
+ * style_print_table_print:
+ * @self: The #StylePrintTable
+ * @wmain: (nullable): The parent window - NULL if none
+ * @tmpl: The #StylePrintTemplate defining the printout
+ * @source: The #StylePrintRowSource providing the data to print
+ *
+ * Print a table formatted as defined by @tmpl, pulling the rows from
+ * @source as the printout proceeds.  The template is not modified, so the
+ * same template may be used for any number of printouts, by any number of
+ * #StylePrintTable objects.
+ */
+
+void
+style_print_table_print (StylePrintTable *self,
+                               GtkWindow *wmain,
+                      StylePrintTemplate *tmpl,
+                     StylePrintRowSource *source)
+{
+    StylePrintTablePrivate *priv;
+    GError *err = NULL;
+
+    g_return_if_fail (STYLE_PRINT_IS_TABLE(self));
+    g_return_if_fail (STYLE_PRINT_IS_TEMPLATE(tmpl));
+
+    priv = style_print_table_get_instance_private (self);
+
+    if (wmain)
+    {
+        priv->w_main = wmain;
+    }
+
+    if (open_source (self, source))
+    {
+        priv->tmpl = g_object_ref (tmpl);
+        render_report (self, GTK_PRINT_OPERATION_ACTION_PRINT_DIALOG, &err);
+        g_clear_object (&priv->tmpl);
+
+        if (err)
+        {
+            report_error (self, err->message);
+            g_error_free (err);
+        }
+    }
+
+    close_source (self);
+}
+
+/**
+ * style_print_table_export_pages:
+ * @self: The #StylePrintTable
+ * @tmpl: The #StylePrintTemplate defining the printout
+ * @source: The #StylePrintRowSource providing the data to print
+ * @filename: The name of the PDF file to write
+ * @first_page: The first page to export, counting from 0
+ * @last_page: The last page to export, or -1 for the last page of the
+ * printout
+ * @error: Return location for a #GError, or NULL
+ *
+ * Write pages @first_page to @last_page of the printout of @source
+ * formatted by @tmpl to the PDF file @filename, with no dialog.  The pages
+ * are laid out for the operation's default page setup (see
+ * gtk_print_operation_set_default_page_setup()), or GTK's default paper
+ * if none is set.  The whole printout is still paginated, but only the
+ * pages exported are drawn, each from the checkpoint recorded for it, so
+ * exporting the last few pages of a long report costs little more than
+ * exporting the first few.
+ *
+ * Errors are returned in @error rather than shown.  If @first_page is past
+ * the end of the printout, or the file cannot be written in full, no file
+ * is left at @filename.
+ *
+ * Returns: TRUE if the pages were written
+ */
+
+gboolean
+style_print_table_export_pages (StylePrintTable *self,
+                             StylePrintTemplate *tmpl,
+                            StylePrintRowSource *source,
+                                    const gchar *filename,
+                                            gint first_page,
+                                            gint last_page,
+                                         GError **error)
+{
+    StylePrintTablePrivate *priv;
+    GError *err = NULL;
+
+    g_return_val_if_fail (STYLE_PRINT_IS_TABLE(self), FALSE);
+    g_return_val_if_fail (STYLE_PRINT_IS_TEMPLATE(tmpl), FALSE);
+    g_return_val_if_fail (filename != NULL, FALSE);
+    g_return_val_if_fail (first_page >= 0, FALSE);
+    g_return_val_if_fail ((last_page < 0) || (last_page >= first_page),
+                          FALSE);
+
+    priv = style_print_table_get_instance_private (self);
+    priv->error = &err;
+
+    if (open_source (self, source))
+    {
+        priv->tmpl = g_object_ref (tmpl);
+
+        if (prepare_report (self))
+        {
+            export_range (self, filename, first_page, last_page);
+        }
+
+        finish_report (self);
+        g_clear_object (&priv->tmpl);
     }
 
-    if (priv->grpHd)
+    close_source (self);
+    priv->error = NULL;
+
+    if (err)
     {
-        GRPINF *grpinf = priv->grpHd;
+        g_propagate_error (error, err);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/* ******************************************************************** *
+ * print_template() - Print the template "tmpl" (if the lookup of the   *
+ *      template succeeded), or report "error".                         *
+ * ******************************************************************** */
+
+static void
+print_template (StylePrintTable *self, GtkWindow *wmain,
+                StylePrintTemplate *tmpl, StylePrintRowSource *source,
+                GError *error)
+{
+    if (!tmpl)
+    {
+        if (wmain)
+        {
+            style_print_table_set_wmain (self, wmain);
+        }
+
+        report_error (self, error->message);
+        g_error_free (error);
+        return;
+    }
+
+    style_print_table_print (self, wmain, tmpl, source);
+    g_object_unref (tmpl);
+}
 
-        while (grpinf)
-        {
-            GRPINF *child;
-            gint mytype = grpinf->grptype;
+/**
+ * style_print_table_from_xmlfile_source:
+ * @self: The StylePrintTable
+ * @wmain: (nullable): The parent window - NULL if none
+ * @source: The #StylePrintRowSource providing the data to print
+ * @filename: The filename to open and read to get the xml definition for the printout.
+ *
+ * Print a tabular form where the xml definition for the output is
+ * contained in a file, and the rows are pulled from @source as the
+ * printout proceeds.
+ */
 
-            if (mytype == GRPTY_GROUP)
-            {
-                g_free (grpinf->padding);
-            }
+void
+style_print_table_from_xmlfile_source (StylePrintTable *self,
+                                             GtkWindow *wmain,
+                                   StylePrintRowSource *source,
+                                                  char *fname)
+{
+    GError *error = NULL;
+    StylePrintTemplate *tmpl;
 
-            if ((mytype == GRPTY_GROUP) || (mytype == GRPTY_CELL))
-            {
-                if (grpinf->pangofont)
-                {
-                    pango_font_description_free (grpinf->pangofont);
-                }
-            }
+    tmpl = style_print_template_lookup_file (fname, &error);
+    print_template (self, wmain, tmpl, source, error);
+}
 
-            if (mytype != GRPTY_CELL)
-            {
-                if (grpinf->celldefs)
-                {
-                    g_ptr_array_free (grpinf->celldefs, TRUE);
-                }
-            }
+/**
+ * style_print_table_from_xmlfile_dataset:
+ * @self: The StylePrintTable
+ * @wmain: (nullable): The parent window - NULL if none
+ * @data: The #StylePrintDataset containing the data to print
+ * @filename: The filename to open and read to get the xml definition for the printout.
+ *
+ * Print a tabular form where the xml definition for the output is
+ * contained in a file, and the data is provided in a #StylePrintDataset.
+ */
 
-            child = grpinf->grpchild;
-            g_free (grpinf);
-            grpinf = child;
-        }
+void
+style_print_table_from_xmlfile_dataset (StylePrintTable *self,
+                                              GtkWindow *wmain,
+                                      StylePrintDataset *data,
+                                                   char *fname)
+{
+    StylePrintRowSource *src = style_print_row_source_new_from_dataset (data);
 
-        priv->grpHd = NULL;
-    }
+    style_print_table_from_xmlfile_source (self, wmain, src, fname);
+    g_object_unref (src);
 }
 
 /**
@@ -1823,6 +2677,11 @@ render_report (StylePrintTable *self)
  *
  * Print a tabular form where the xml definition for the output is
  * contained in a file.
+ *
+ * The data is converted to a #StylePrintDataset before printing.  Where
+ * the data is built by the application, it is more efficient to build a
+ * #StylePrintDataset directly and use
+ * style_print_table_from_xmlfile_dataset().
  */
 
 void
@@ -1831,75 +2690,60 @@ style_print_table_from_xmlfile (StylePrintTable *self,
                                       GPtrArray *data,
                                            char *fname)
 {
-    char buf[3000];
-    FILE *fp;
-    int rdcount;
-    GMarkupParseContext *gmp_contxt;
-    GError *error;
-    StylePrintTablePrivate *priv;
-   
-    priv = style_print_table_get_instance_private (self);
-
-    // If data is empty or not defined, abort with error message
-
-    if ((data == NULL) || (data->len == 0))
-    {
-        GString *errmsg;
-        errmsg = g_string_new (NULL);
-        g_string_printf (errmsg,
-                "Error! Data to print was either not defined or empty");
-        report_error (self, errmsg->str);
-        g_string_free (errmsg, TRUE);
-        return;
-    }
-
-    if (wmain)
-    {
-        priv->w_main = wmain;
-    }
+    StylePrintDataset *ds = style_print_dataset_new_from_ptr_array (data);
 
-    priv->pgresult = data;
-
-//    if (!priv->Page_Setup)
-//    {
-//        set_page_defaults (self);
-//    }
+    style_print_table_from_xmlfile_dataset (self, wmain, ds, fname);
+    g_object_unref (ds);
+}
 
-    if ( ! (fp = fopen (fname, "rb")))
-    {
-        GString *errmsg;
-        errmsg = g_string_new (NULL);
-        g_string_printf (errmsg, "Failed to open file: '%s'\n", fname);
-        report_error (self, errmsg->str);
-        g_string_free (errmsg, TRUE);
-        return;
-    }
+/**
+ * style_print_table_from_xmlstring_source:
+ * @self: The #StylePrintTable
+ * @wmain: (nullable): The parent window - NULL if none
+ * @source: The #StylePrintRowSource providing the data to print
+ * @xml: Pointer to the string containing the xml formatting
+ *
+ * Print a table where the definition for the format is contained in an
+ * xml string, and the rows are pulled from @source as the printout
+ * proceeds.
+ *
+ */
 
-    gmp_contxt =
-        g_markup_parse_context_new (&prsr, G_MARKUP_TREAT_CDATA_AS_TEXT,
-                                        self, NULL);
-    
-    while ((rdcount = fread (buf, 1, sizeof(buf), fp)))
-    {
-        error = NULL;
+void
+style_print_table_from_xmlstring_source (StylePrintTable *self,
+                                               GtkWindow *wmain,
+                                     StylePrintRowSource *source,
+                                                    char *xml)
+{
+    GError *error = NULL;
+    StylePrintTemplate *tmpl;
 
-        if (!g_markup_parse_context_parse (gmp_contxt, buf, rdcount, &error))
-        {
-            report_error (self, error->message);
-        }
-    }
+    tmpl = style_print_template_new_from_string (xml, &error);
+    print_template (self, wmain, tmpl, source, error);
+}
 
-    fclose (fp);
-    reset_default_cell (self);
+/**
+ * style_print_table_from_xmlstring_dataset:
+ * @self: The #StylePrintTable
+ * @wmain: (nullable): The parent window - NULL if none
+ * @data: The #StylePrintDataset containing the data to print
+ * @xml: Pointer to the string containing the xml formatting
+ *
+ * Print a table where the definition for the format is contained in an
+ * xml string, and the data is provided in a #StylePrintDataset.
+ *
+ */
 
-    if ( ! error)
-    {
-        render_report (self);
-    }
+void
+style_print_table_from_xmlstring_dataset (StylePrintTable *self,
+                                                GtkWindow *wmain,
+                                        StylePrintDataset *data,
+                                                     char *xml)
+{
+    StylePrintRowSource *src = style_print_row_source_new_from_dataset (data);
 
-    //free_default_cell();
-    //return STYLE_PRINT_TABLE(tbl)->grpHd; // Temporary - for debugging
-    g_markup_parse_context_free (gmp_contxt);
+    style_print_table_from_xmlstring_source (self, wmain, src, xml);
+    g_object_unref (src);
 }
 
 /**
@@ -1912,6 +2756,8 @@ style_print_table_from_xmlfile (StylePrintTable *self,
  * Print a table where the definition for the format is contained in an
  * xml string.
  *
+ * The data is converted to a #StylePrintDataset before printing.  See
+ * style_print_table_from_xmlstring_dataset().
  */
 
 void
@@ -1920,47 +2766,64 @@ style_print_table_from_xmlstring (  StylePrintTable *self,
                                           GPtrArray *data,
                                                char *xml)
 {
-    GMarkupParseContext *gmp_contxt;
-    GError *error;
-    StylePrintTablePrivate *priv;
-   
-    priv = style_print_table_get_instance_private (self);
+    StylePrintDataset *ds = style_print_dataset_new_from_ptr_array (data);
 
-    // If data is empty or not defined, abort with error message
-
-    if ((data == NULL) || (data->len == 0))
-    {
-        GString *errmsg;
-        errmsg = g_string_new (NULL);
-        g_string_printf (errmsg,
-                "Error! Data to print was either not defined or empty");
-        report_error (self, errmsg->str);
-        g_string_free (errmsg, TRUE);
-        return;
-    }
+    style_print_table_from_xmlstring_dataset (self, wmain, ds, xml);
+    g_object_unref (ds);
+}
 
-    if (wmain)
-    {
-        priv->w_main = wmain;
-    }
+/**
+ * style_print_table_from_array_source:
+ * @self: The #StylePrintTable
+ * @wmain: (nullable): The parent window - NULL if none
+ * @source: The #StylePrintRowSource providing the data to print
+ * @xml: Pointer to the null-terminated array of strings containing the
+ * xml formatting
+ *
+ * Print a table where the definition for the format is contained in a
+ * null-terminated array of strings representing the xml definition for
+ * the printout, and the rows are pulled from @source as the printout
+ * proceeds.
+ *
+ */
 
-    priv->pgresult = data;
+void
+style_print_table_from_array_source (  StylePrintTable  *self,
+                                              GtkWindow  *wmain,
+                                    StylePrintRowSource  *source,
+                                                  gchar **xml)
+{
+    GError *error = NULL;
+    StylePrintTemplate *tmpl;
 
-    gmp_contxt =
-        g_markup_parse_context_new (&prsr, G_MARKUP_TREAT_CDATA_AS_TEXT,
-                self, NULL);
+    tmpl = style_print_template_new_from_array (xml, &error);
+    print_template (self, wmain, tmpl, source, error);
+}
 
-    error = NULL;
+/**
+ * style_print_table_from_array_dataset:
+ * @self: The #StylePrintTable
+ * @wmain: (nullable): The parent window - NULL if none
+ * @data: The #StylePrintDataset containing the data to print
+ * @xml: Pointer to the null-terminated array of strings containing the
+ * xml formatting
+ *
+ * Print a table where the definition for the format is contained in a
+ * null-terminated array of strings representing the xml definition for
+ * the printout, and the data is provided in a #StylePrintDataset.
+ *
+ */
 
-    if (! g_markup_parse_context_parse (gmp_contxt, xml, strlen(xml), &error))
-    {
-        report_error (self, error->message);
-    }
+void
+style_print_table_from_array_dataset (  StylePrintTable  *self,
+                                              GtkWindow  *wmain,
+                                      StylePrintDataset  *data,
+                                                  gchar **xml)
+{
+    StylePrintRowSource *src = style_print_row_source_new_from_dataset (data);
 
-    reset_default_cell (self);
-    render_report (self);
-    //free_default_cell (self);
-    g_markup_parse_context_free (gmp_contxt);
+    style_print_table_from_array_source (self, wmain, src, xml);
+    g_object_unref (src);
 }
 
 /**
@@ -1978,6 +2841,8 @@ style_print_table_from_xmlstring (  StylePrintTable *self,
  * Note: In a C program, the xml would normally be contained in a #GPtrArray,
  * but in this case, the ->pdata should be passed
  *
+ * The data is converted to a #StylePrintDataset before printing.  See
+ * style_print_table_from_array_dataset().
  */
 
 void
@@ -1986,56 +2851,10 @@ style_print_table_from_array (  StylePrintTable  *self,
                                       GPtrArray  *data,
                                           gchar **xml)
 {
-    GMarkupParseContext *gmp_contxt;
-    GError *error;
-    StylePrintTablePrivate *priv;
-    gint idx = 0;
-   
-    priv = style_print_table_get_instance_private (self);
-
-    // If data is empty or not defined, abort with error message
-
-    if ((data == NULL) || (data->len == 0))
-    {
-        GString *errmsg;
-        errmsg = g_string_new (NULL);
-        g_string_printf (errmsg,
-                "Error! Data to print was either not defined or empty");
-        report_error (self, errmsg->str);
-        g_string_free (errmsg, TRUE);
-        return;
-    }
-
-    if (wmain)
-    {
-        priv->w_main = wmain;
-    }
-
-    priv->pgresult = data;
-
-    gmp_contxt =
-        g_markup_parse_context_new (&prsr, G_MARKUP_TREAT_CDATA_AS_TEXT,
-                self, NULL);
-
-    error = NULL;
-
-    while (xml[idx] != NULL)
-    {
-        error = NULL;
-
-        if (!g_markup_parse_context_parse (gmp_contxt, xml[idx],
-                    strlen(xml[idx]), &error))
-        {
-            report_error (self, error->message);
-        }
+    StylePrintDataset *ds = style_print_dataset_new_from_ptr_array (data);
 
-        ++idx;
-    }
-
-    reset_default_cell (self);
-    render_report (self);
-    //free_default_cell (self);
-    g_markup_parse_context_free (gmp_contxt);
+    style_print_table_from_array_dataset (self, wmain, ds, xml);
+    g_object_unref (ds);
 }
 
 /**
@@ -2070,6 +2889,34 @@ style_print_table_set_wmain (StylePrintTable *self, GtkWindow *win)
     priv->w_main = win;
 }
 
+/**
+ * style_print_table_set_spill_file:
+ * @self: The #StylePrintTable instance
+ * @filename: (nullable): The name of the spill file, or NULL to print
+ * directly from the data source
+ *
+ * Causes each subsequent printout to first copy all its rows into the
+ * spill file @filename (see style_print_spill_write()), then print them
+ * from a read-only memory mapping of that file.  Both the pagination pass
+ * and the drawing of the pages then read the values from the page cache
+ * rather than from the heap, and the data source is read only once.
+ *
+ * The file is removed once it has been mapped.
+ */
+
+void
+style_print_table_set_spill_file (StylePrintTable *self,
+                                      const gchar *filename)
+{
+    StylePrintTablePrivate *priv;
+
+    g_return_if_fail (STYLE_PRINT_IS_TABLE(self));
+
+    priv = style_print_table_get_instance_private (self);
+    g_free (priv->spillfile);
+    priv->spillfile = g_strdup (filename);
+}
+
 /**
  * style_print_table_get_wmain:
  * @self: the #StylePrintTable instance
@@ -2087,3 +2934,200 @@ style_print_table_get_wmain (StylePrintTable *self)
     return priv->w_main;
 }
 
+/**
+ * style_print_table_set_measure_cache_size:
+ * @self: The #StylePrintTable instance
+ * @size: The number of cell texts to keep, or 0 for no cache
+ *
+ * Sets the size of the cache of cell text heights used by subsequent
+ * printouts.  The height of each cell text laid out is kept under its
+ * font, width, alignment and text, so that when the same value appears
+ * again in a column with the same attributes - as status codes,
+ * currencies and the like tend to - its height is known without laying it
+ * out again.  This benefits both the pagination pass and the drawing of
+ * the pages.  Once a text in the cache has been drawn, its layout is kept
+ * with its height, so drawing it again only shows the glyphs already
+ * shaped.  When the cache is full, the text used least recently is
+ * dropped.  The default size is 4096.
+ */
+
+void
+style_print_table_set_measure_cache_size (StylePrintTable *self, guint size)
+{
+    StylePrintTablePrivate *priv;
+
+    g_return_if_fail (STYLE_PRINT_IS_TABLE(self));
+
+    priv = style_print_table_get_instance_private (self);
+    priv->measuresize = size;
+}
+
+/**
+ * style_print_table_get_measure_stats:
+ * @self: The #StylePrintTable instance
+ * @hits: (out) (optional): Return location for the number of cell texts
+ * found in the cache
+ * @misses: (out) (optional): Return location for the number of cell texts
+ * not found in the cache
+ *
+ * Gets the use of the cache of cell text heights (see
+ * style_print_table_set_measure_cache_size()) by the current printout, or
+ * the last one if none is in progress.  Both counts are 0 if the cache is
+ * disabled.  Short, single-line ASCII texts are measured without the cache
+ * (from the advance widths of the characters), so are only counted when
+ * the pages are drawn.
+ */
+
+void
+style_print_table_get_measure_stats (StylePrintTable *self, guint64 *hits,
+                                     guint64 *misses)
+{
+    StylePrintTablePrivate *priv;
+
+    g_return_if_fail (STYLE_PRINT_IS_TABLE(self));
+
+    priv = style_print_table_get_instance_private (self);
+
+    if (hits)
+    {
+        *hits = priv->measurehits;
+    }
+
+    if (misses)
+    {
+        *misses = priv->measuremisses;
+    }
+}
+
+/**
+ * style_print_table_get_page_for_row:
+ * @self: The #StylePrintTable instance
+ * @row: The number of a data row, counting from 0
+ *
+ * Finds the page of the current printout, or of the last one if none is in
+ * progress, on which @row is printed.  The pages are searched by their
+ * first rows, so this takes O(log n) for n pages.
+ *
+ * Returns: The page number, counting from 0, or -1 if @row is not printed
+ * or the printout has not been paginated
+ */
+
+gint
+style_print_table_get_page_for_row (StylePrintTable *self, gint row)
+{
+    StylePrintTablePrivate *priv;
+    guint lo = 0,
+          hi;
+
+    g_return_val_if_fail (STYLE_PRINT_IS_TABLE(self), -1);
+
+    priv = style_print_table_get_instance_private (self);
+
+    if (!priv->pagechecks || (row < 0))
+    {
+        return -1;
+    }
+
+    hi = priv->pagechecks->len;
+
+    // Find the first page beginning after "row" - the row is on the one
+    // before it
+    while (lo < hi)
+    {
+        guint mid = (lo + hi) / 2;
+
+        if (PAGE_CHECK(priv, mid)->startrow > row)
+        {
+            hi = mid;
+        }
+        else
+        {
+            lo = mid + 1;
+        }
+    }
+
+    if (!lo || (row >= PAGE_CHECK(priv, lo - 1)->endrow))
+    {
+        return -1;
+    }
+
+    return lo - 1;
+}
+
+/**
+ * style_print_table_get_page_for_key:
+ * @self: The #StylePrintTable instance
+ * @column: The column a group of the printout is formed on (its
+ * "groupsource" attribute)
+ * @key: The value of @column to look for
+ *
+ * Finds the page on which the first group with the value @key in @column
+ * begins, as style_print_table_get_page_for_row() does for its first row.
+ * The first row for each value is recorded as the printout is paginated,
+ * so a preview can jump straight to, say, a given customer.  Groups whose
+ * value is NULL are not recorded, so an empty @key only finds a group
+ * whose value is the empty string.
+ *
+ * Returns: The page number, counting from 0, or -1 if there is no such
+ * group
+ */
+
+gint
+style_print_table_get_page_for_key (StylePrintTable *self,
+                                        const gchar *column,
+                                        const gchar *key)
+{
+    StylePrintTablePrivate *priv;
+    GHashTable *keys;
+    gpointer row;
+
+    g_return_val_if_fail (STYLE_PRINT_IS_TABLE(self), -1);
+    g_return_val_if_fail (column != NULL, -1);
+    g_return_val_if_fail (key != NULL, -1);
+
+    priv = style_print_table_get_instance_private (self);
+
+    if (!priv->grpkeys ||
+            !(keys = g_hash_table_lookup (priv->grpkeys, column)) ||
+            !g_hash_table_lookup_extended (keys, key, NULL, &row))
+    {
+        return -1;
+    }
+
+    return style_print_table_get_page_for_row (self, GPOINTER_TO_INT(row));
+}
+
+/**
+ * style_print_table_get_rows_height:
+ * @self: The #StylePrintTable instance
+ * @first: The first data row
+ * @last: The row following the last one
+ *
+ * Gets the height, in points, that the body rows from @first up to
+ * @last took in the current or last printout, including their padding
+ * and any rule below each, but not the headers between them.  The height
+ * of each row is recorded as the printout is paginated, along with the
+ * running total, so this takes the same time for any number of rows.
+ *
+ * Returns: The height, or 0 if the rows were not all laid out
+ */
+
+gdouble
+style_print_table_get_rows_height (StylePrintTable *self, gint first,
+                                   gint last)
+{
+    StylePrintTablePrivate *priv;
+
+    g_return_val_if_fail (STYLE_PRINT_IS_TABLE(self), 0);
+
+    priv = style_print_table_get_instance_private (self);
+
+    if (!priv->rowheights || (first < 0) || (last < first) ||
+            (last > (gint)priv->rowheights->len))
+    {
+        return 0;
+    }
+
+    return g_array_index (priv->rowtops, gdouble, last) -
+                g_array_index (priv->rowtops, gdouble, first);
+}
@@ -36,6 +36,11 @@ extern "C"
 #include <glib-object.h>
 #include <glib.h>
 #include <libpq-fe.h>
+#include <styleprintdataset.h>
+#include <styleprintrowsource.h>
+#include <styleprintspill.h>
+#include <styleprintcsv.h>
+#include <styleprinttemplate.h>
 
 G_BEGIN_DECLS
 
@@ -174,12 +179,69 @@ void style_print_table_from_array (StylePrintTable  *self,
                                          GPtrArray  *data,
                                              gchar **xml);
 
+void style_print_table_from_xmlfile_dataset (StylePrintTable *self,
+                                                  GtkWindow *wmain,
+                                          StylePrintDataset *data,
+                                                       char *filename);
+
+void style_print_table_from_xmlstring_dataset (StylePrintTable *self,
+                                                    GtkWindow *wmain,
+                                            StylePrintDataset *data,
+                                                         char *xml);
+
+void style_print_table_from_array_dataset (StylePrintTable  *self,
+                                                 GtkWindow  *wmain,
+                                         StylePrintDataset  *data,
+                                                     gchar **xml);
+
+void style_print_table_from_xmlfile_source (StylePrintTable *self,
+                                                 GtkWindow *wmain,
+                                       StylePrintRowSource *source,
+                                                      char *filename);
+
+void style_print_table_from_xmlstring_source (StylePrintTable *self,
+                                                   GtkWindow *wmain,
+                                         StylePrintRowSource *source,
+                                                        char *xml);
+
+void style_print_table_from_array_source (StylePrintTable  *self,
+                                                GtkWindow  *wmain,
+                                      StylePrintRowSource  *source,
+                                                    gchar **xml);
+
+void style_print_table_print (StylePrintTable *self,
+                                   GtkWindow *wmain,
+                          StylePrintTemplate *tmpl,
+                         StylePrintRowSource *source);
+
 void style_print_table_greet(       StylePrintTable *self,
                                               GPtrArray *ary);
 
 StylePrintTable *style_print_table_new(void);
 void style_print_table_set_wmain (StylePrintTable *self, GtkWindow *win);
 GtkWindow * style_print_table_get_wmain (StylePrintTable *self);
+void style_print_table_set_spill_file (StylePrintTable *self,
+                                           const gchar *filename);
+gboolean style_print_table_export_pages (StylePrintTable *self,
+                                     StylePrintTemplate *tmpl,
+                                    StylePrintRowSource *source,
+                                            const gchar *filename,
+                                                    gint first_page,
+                                                    gint last_page,
+                                                 GError **error);
+gint style_print_table_get_page_for_row (StylePrintTable *self,
+                                                    gint row);
+gint style_print_table_get_page_for_key (StylePrintTable *self,
+                                             const gchar *column,
+                                             const gchar *key);
+gdouble style_print_table_get_rows_height (StylePrintTable *self,
+                                                      gint first,
+                                                      gint last);
+void style_print_table_set_measure_cache_size (StylePrintTable *self,
+                                                         guint size);
+void style_print_table_get_measure_stats (StylePrintTable *self,
+                                                  guint64 *hits,
+                                                  guint64 *misses);
 
 #ifdef _cplusplus
 }
@@ -39,25 +39,24 @@ typedef struct pg_mar {
 // Each column of a Header or Body description will contain an array of these.
 typedef struct cell_info {
     int grptype;            // Group-type - Must be FIRST entry in struct
-    PangoFontDescription *pangofont;      // pangofont from this
-    double x,               // X position for the current insert
-           y;               // Y position for the current insert (not used???)
+    const PangoFontDescription *pangofont;    // Shared, from the font pool
+    double y;               // Y position for the current insert (not used???)
     int padleft,            // Padding for left side of cell
         padright;           // Padding for right side of cell
     int borderstyle;        // Border style for group or cell
     double percent;         // percent of page width to use for this cell
     double cellwidth;       // Cell width in POINTS
     int   txtsource;        // Where to get source
-    char  *celltext;        // Text to insert into the cell
-    //gchar *cell_col;        // The col # for cell text (only "data" txtsource)
+    const char *celltext;   // Text to insert into the cell
     PangoAlignment layoutalign;     // Justification - right/left/center
 } CELLINF, *PCELLINF;
 
 typedef struct grp_info {
     int grptype;                    // The group-type - must be the first entry
                                     // to insert into fontdescriptor
-    PangoFontDescription *pangofont; // Font to use for this group, also
-                                    // used for any cells with no font spec
+    const PangoFontDescription *pangofont; // Font to use for this group,
+                                    // also used for any cells with no font
+                                    // spec.  Shared, from the font pool
     int colcount;
     int pointsabove,                // Points for space above the group hdr
         pointsbelow;                // Points for space below the group
@@ -66,19 +65,142 @@ typedef struct grp_info {
     struct grp_info *grpchild;      // NULL if it's body
     ROWPAD *padding;                // Padding around the row;
     struct grp_info *header;        // Display for group-type groups
-    gboolean cells_formatted;       // TRUE if cols have been reformatted 
     GPtrArray *celldefs;            // Pointer to CELLINF array
-    gchar *grpcol;                  // PGresult col number for group text
+    const gchar *grpcol;            // Column name for group text
+    gint   slot;                    // Index of this group's GRPSTATE in a
+                                    // printout (-1 if not a <group>)
+    gint   rowslot;                 // Index of the ROWPLAN for celldefs in
+                                    // a printout (-1 if no cells)
 } GRPINF, *PGRPINF;
 
+// The CELLINF and GRPINF trees belong to a StylePrintTemplate, which may be
+// shared by any number of printouts, and are not modified once parsed.
+// What depends on the print context or the data is kept for each printout
+// by the StylePrintTable, in arrays indexed by the "slot" or "rowslot" of
+// the group.
+
+// The advance widths of the printable ASCII characters in a font
+typedef struct advance_table ADVTABLE;
+
+// The render plan for a row definition: what render_row() needs of each
+// cell, compiled for one printout into an array per field, so the row loop
+// walks contiguous memory rather than the CELLINFs.
+typedef struct row_plan {
+    guint  ncells;
+    double *x;                      // Left edge of each cell
+    double *textx;                  // Left edge of the text (x + padleft)
+    double *textwidth;              // Width of the text in POINTS
+    const PangoFontDescription **font;
+    PangoAlignment *align;
+    gint   *txtsource;              // TSRC_* of each cell
+    gint   *colidx;                 // Dataset column ("data" cells only)
+    const gchar **text;             // "celltext" of each cell
+    PangoLayout **layout;           // Layout for each cell, set up for the
+                                    // print context by make_layouts()
+    ADVTABLE **adv;                 // Advance table for the font of each
+                                    // cell (shared, owned by the table)
+} ROWPLAN;
+
+// An entry in the display list of a page.  The list is made as the page
+// is laid out by begin_print(), and draw_page() only replays it.  A row
+// refers to its render plan and data row rather than holding the text of
+// its cells, so the list stays small, and the data is read again from
+// the row source when the page is drawn.
+enum {
+    DL_ROW = 1,                     // The cells of a row
+    DL_RULE,                        // A horizontal or vertical line
+    DL_BOX                          // A rectangle
+};
+
+typedef struct disp_item {
+    gint   kind;                    // DL_*
+    double x,                       // Top left corner (a row's cells are
+           y;                       // at the "x" of its plan)
+    double width,                   // Size - for a rule, one of these is 0
+           height;
+    double weight;                  // Line width (rules and boxes)
+    ROWPLAN *plan;                  // The row definition (DL_ROW)
+    gint   row;                     // The data row (DL_ROW)
+} DISPITEM;
+
+// The checkpoint made by the dry run at the top of each page: everything
+// needed to draw the page, along with its display list, without the pages
+// before it.  Any group continued from the page before has already been
+// laid out, with its header repeated, in the display list.
+enum {
+    PAGE_DOCHEADER  = 1,            // The document header begins the page
+    PAGE_PAGEHEADER = 1 << 1        // The page header is printed
+};
+
+typedef struct page_check {
+    gint   startrow;                // The first data row on the page
+    gint   endrow;                  // The row following the last one
+    guint  headers;                 // PAGE_* - the headers pending
+} PAGECHECK;
+
+typedef struct grp_state {
+    gint   grpcolidx;               // Dataset column index for grpcol
+    GArray *grpends;                // Group index: the row following each
+                                    // run of rows with the same grpcol
+    StylePrintValue grplast;        // grpcol value of the last row indexed
+    gchar *grplasttxt;              // Copy of the text of grplast
+} GRPSTATE;
+
+struct _StylePrintTemplate
+{
+    GObject parent_instance;
+
+    GRPINF *DocHeader;      // The Document Header (header for first page)
+    GRPINF *PageHeader;     // The Pagheader (header for each page)
+    GRPINF *grpHd;
+    CELLINF *defaultcell;
+    ROWPAD *DefaultPadding;
+    gint nrows;             // Number of row definitions (rowslots)
+    gint ngroups;           // Number of group slots
+    GStringChunk *strings;  // The celltext and grpcol strings, unless they
+                            // point into the mapping or a
+                            // StylePrintStaticTemplate
+    GMappedFile *mapping;   // The file the template was parsed from
+    GHashTable *fonts;      // The font pool: every font description used
+                            // by the template, each held once
+
+    // The file the template was read from, used by the template cache
+    gint64 mtime;
+    goffset size;
+
+    // Only used while parsing
+    GSList *elList;         // The element stack
+    gchar *scan;            // Where to look for the next tag in the mapping
+    gchar *tag;             // The current tag's attributes in the mapping
+    gchar *tagend;          // The '>' which ends the current tag
+};
+
 typedef struct page_def {
     int firstrow,
         lastrow;
 } PG_DEF;
 
-struct xml_udat {
-    int depth;
-    PGRPINF parent;
-    PGRPINF curfmt;
-} XMLData;
 
+// The cache of cell text heights and layouts (styleprintmeasure.c)
+typedef struct measure_cache MEASURECACHE;
+typedef struct measure_entry MEASUREENTRY;
+
+MEASURECACHE *_style_print_measure_cache_new (guint size);
+void _style_print_measure_cache_free (MEASURECACHE *cache);
+MEASUREENTRY *_style_print_measure_cache_lookup (MEASURECACHE *cache,
+                                    const PangoFontDescription *font,
+                                    gint width, PangoAlignment align,
+                                    const gchar *text, gsize len);
+MEASUREENTRY *_style_print_measure_cache_insert (MEASURECACHE *cache,
+                                    const PangoFontDescription *font,
+                                    gint width, PangoAlignment align,
+                                    const gchar *text, gsize len,
+                                    gint height);
+gint _style_print_measure_entry_get_height (MEASUREENTRY *ent);
+PangoLayout *_style_print_measure_entry_get_layout (MEASUREENTRY *ent,
+                                    PangoLayout *proto);
+
+ADVTABLE *_style_print_advances_new (PangoLayout *layout);
+void _style_print_advances_free (ADVTABLE *tbl);
+gboolean _style_print_advances_measure (ADVTABLE *tbl, const gchar *text,
+                                    gsize len, gint width, gint *height);
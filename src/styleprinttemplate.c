@@ -0,0 +1,1695 @@
+/*
+Copyright (c) 2017 David Breeding
+
+This file is part of tableprint.
+
+tableprint is free software: you can redistribute it and/or modify
+it under the terms of the Lesser GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+tableprint is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with tableprint (see the files "COPYING" and "COPYING.LESSER").
+If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* ************************************************************************ *
+ * styleprinttemplate.c - The parsed xml definition of a printout, and a    $
+ * process-wide cache of them                                               $
+ *                                                                          $
+ * The xml is parsed into the same GRPINF/CELLINF tree that the renderer    $
+ * in styleprinttable.c walks.  Once parsed, the tree is never modified:    $
+ * anything which depends on the print context or on the data is kept by   $
+ * the StylePrintTable for the length of one printout, indexed by the       $
+ * "slot" and "rowslot" numbers assigned here.                              $
+ * $Id::                                                                    $
+ * ************************************************************************ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <pango/pango.h>
+#include <glib-object.h>
+#include <glib/gstdio.h>
+#include "styleprinttablepriv.h"
+
+/**
+ * SECTION: styleprinttemplate
+ * @Title: StylePrintTemplate
+ * @Short_description: A parsed, shareable printout definition
+ * @See_also: #StylePrintTable
+ *
+ * A #StylePrintTemplate holds the xml definition of a printout (see
+ * <link linkend="xmldefsintro">the xml specification</link>) in parsed form.
+ * It cannot be changed once created, so a single template can be printed
+ * any number of times, by any number of #StylePrintTable objects, with
+ * style_print_table_print().
+ *
+ * The style_print_template_lookup_*() functions keep the templates they
+ * create in a process-wide cache, so that a definition which is printed
+ * repeatedly is only parsed once.  A file is looked up by its name, and is
+ * parsed again if its modification time or size has changed; a string or
+ * array is looked up by a checksum of its contents.  Nothing is ever
+ * dropped from the cache short of style_print_template_cache_clear(), so
+ * only definitions from a fixed set should be looked up this way.  The
+ * style_print_table_from_xmlfile_*() functions use this cache; the other
+ * style_print_table_from_*() functions, whose xml may be built afresh for
+ * each printout, parse it each time.
+ *
+ * A definition which is built into an application can instead be
+ * compiled into static tables when the application is built, with the
+ * styleprint-compile tool:
+ * |[
+ * styleprint-compile --name=report_template --output=report.c report.xml
+ * ]|
+ * writes "report.c", defining a #StylePrintStaticTemplate named
+ * "report_template".  The application then creates the template with
+ * style_print_template_lookup_static() (or
+ * style_print_template_new_from_static()), and no xml is parsed at run
+ * time:
+ * |[<!-- language="C" -->
+ * extern const StylePrintStaticTemplate report_template;
+ *
+ * tmpl = style_print_template_lookup_static (&report_template);
+ * style_print_table_print (table, window, tmpl, source);
+ * g_object_unref (tmpl);
+ * ]|
+ * The rules in "styleprint-compile.mk", which is installed in the
+ * directory given by the "styleprintdatadir" variable of the package's
+ * pkg-config file, compile each "name.xml" into "name.tpl.c":
+ * |[
+ * STYLEPRINT_DATADIR := $(shell pkg-config --variable=styleprintdatadir styleprinttable)
+ * include $(STYLEPRINT_DATADIR)/styleprint-compile.mk
+ * ]|
+ *
+ * Templates are safe to share between threads: they are not modified once
+ * created, the cache is locked, and each parse keeps its state in the
+ * template being built.
+ */
+
+#define CELLPAD_DFLT 10
+
+struct _StylePrintTemplateClass
+{
+    GObjectClass parent_class;
+};
+
+G_DEFINE_TYPE(StylePrintTemplate, style_print_template, G_TYPE_OBJECT)
+
+static void start_element_main (GMarkupParseContext *, const gchar *,
+        const gchar **, const gchar **, gpointer, GError **);
+static void end_element_main (GMarkupParseContext *, const gchar *,
+                             gpointer, GError **);
+
+static const GMarkupParser prsr = {start_element_main, end_element_main, NULL,
+                        NULL, NULL};
+
+/* The template cache: "file:<name>" or "xml:<checksum>" => template */
+G_LOCK_DEFINE_STATIC (template_cache);
+static GHashTable *TemplateCache = NULL;
+
+static void
+free_celldef (CELLINF *cell)
+{
+    // The font belongs to the template's font pool
+    g_free (cell);
+}
+
+
+/* **************************************************************** *
+ * free_group() - Free a group, its header, and all its descendants *
+ * **************************************************************** */
+
+static void
+free_group (GRPINF *grp)
+{
+    while (grp)
+    {
+        GRPINF *child = grp->grpchild;
+
+        if (grp->header)
+        {
+            free_group (grp->header);
+        }
+
+        if (grp->celldefs)
+        {
+            g_ptr_array_free (grp->celldefs, TRUE);
+        }
+
+        g_free (grp->padding);
+        g_free (grp);
+        grp = child;
+    }
+}
+
+/* **************************************************************** *
+ * intern_font() - Add "font" to the template's font pool, which    *
+ *      takes ownership of it.  Cells and groups with equal fonts   *
+ *      all share the one description, which is never modified,    *
+ *      so the pointer identifies the font.                         *
+ * Returns: The shared description equal to "font"                 *
+ * **************************************************************** */
+
+static const PangoFontDescription *
+intern_font (StylePrintTemplate *self, PangoFontDescription *font)
+{
+    gpointer shared;
+
+    if (g_hash_table_lookup_extended (self->fonts, font, &shared, NULL))
+    {
+        pango_font_description_free (font);
+        return shared;
+    }
+
+    g_hash_table_add (self->fonts, font);
+    return font;
+}
+
+static void
+style_print_template_init (StylePrintTemplate *self)
+{
+    self->fonts = g_hash_table_new_full (
+                        (GHashFunc)pango_font_description_hash,
+                        (GEqualFunc)pango_font_description_equal,
+                        (GDestroyNotify)pango_font_description_free, NULL);
+    self->defaultcell = g_malloc0 (sizeof(CELLINF));
+    self->defaultcell->grptype = GRPTY_CELL;
+    self->defaultcell->pangofont = intern_font (self,
+                            pango_font_description_from_string ("Serif 10"));
+    self->strings = g_string_chunk_new (1024);
+    self->mtime = -1;
+    self->size = -1;
+}
+
+static void
+style_print_template_finalize (GObject *object)
+{
+    StylePrintTemplate *self = STYLE_PRINT_TEMPLATE(object);
+
+    free_group (self->DocHeader);
+    free_group (self->PageHeader);
+    free_group (self->grpHd);
+    free_celldef (self->defaultcell);
+    g_free (self->DefaultPadding);
+    g_hash_table_destroy (self->fonts);
+    g_string_chunk_free (self->strings);
+    g_slist_free (self->elList);
+
+    if (self->mapping)
+    {
+        g_mapped_file_unref (self->mapping);
+    }
+
+    G_OBJECT_CLASS(style_print_template_parent_class)->finalize (object);
+}
+
+static void
+style_print_template_class_init (StylePrintTemplateClass *class)
+{
+    GObjectClass *gobject_class = (GObjectClass *) class;
+
+    gobject_class->finalize = style_print_template_finalize;
+}
+
+/* The vocabulary of the xml definition: element and attribute names, and
+ * the values of enumerated attributes.  Names are looked up with
+ * lookup_keyword(), which must be kept in step with this list. */
+
+enum {
+    KW_NONE = 0,
+    // Elements
+    KW_CELL, KW_DEFAULTCELL, KW_GROUP, KW_HEADER, KW_BODY, KW_FONT,
+    KW_DOCHEADER, KW_PAGEHEADER, KW_PADDING, KW_DEFAULTPADDING,
+    // <cell> attributes and their values
+    KW_PERCENT, KW_CELLWIDTH, KW_TEXTSOURCE, KW_CELLTEXT, KW_ALIGN,
+    KW_DATA, KW_STATIC, KW_NOW, KW_PRINTF, KW_PAGEOF, KW_L, KW_C, KW_R,
+    // <group> attributes and their values
+    KW_GROUPSOURCE, KW_POINTSABOVE, KW_POINTSBELOW, KW_OUTERBORDER,
+    KW_CELLBORDER, KW_SINGLEBAR, KW_DOUBLEBAR, KW_SINGLEBARHEAVY,
+    KW_SINGLEBOX, KW_DOUBLEBOX, KW_HLINE, KW_VBAR, KW_BOXED,
+    // <padding> attributes
+    KW_PADLEFT, KW_PADRIGHT, KW_PADTOP, KW_PADBOTTOM, KW_LEFT, KW_RIGHT,
+    // <font> attributes and their values
+    KW_FAMILY, KW_SIZE, KW_STYLE, KW_WEIGHT, KW_VARIANT, KW_STRETCH,
+    KW_NORMAL, KW_OBLIQUE, KW_ITALIC,
+    KW_THIN, KW_ULTRALIGHT, KW_LIGHT, KW_BOOK, KW_MEDIUM, KW_SEMIBOLD,
+    KW_BOLD, KW_ULTRABOLD, KW_HEAVY, KW_ULTRAHEAVY,
+    KW_SMALL_CAPS,
+    KW_ULTRA_CONDENSED, KW_EXTRA_CONDENSED, KW_CONDENSED,
+    KW_SEMI_CONDENSED, KW_SEMI_EXPANDED, KW_EXPANDED, KW_EXTRA_EXPANDED,
+    KW_ULTRA_EXPANDED
+};
+
+/* Within a case of lookup_keyword(), the length and first character of
+ * "name" are known to match "word" */
+#define KW_MATCH(name,word,kw) \
+    if (memcmp ((name) + 1, (word) + 1, sizeof (word) - 2) == 0) return (kw)
+
+/* **************************************************************** *
+ * lookup_keyword() - Find the KW_* value for a name in the xml     *
+ *      vocabulary, dispatching on its length and first character   *
+ *      so that at most a few names are compared.                   *
+ * Returns: The KW_* value, or KW_NONE if "name" is not a keyword   *
+ * **************************************************************** */
+
+static gint
+lookup_keyword (const gchar *name)
+{
+    switch (strlen (name))
+    {
+        case 1:
+            switch (name[0])
+            {
+                case 'c': return KW_C;
+                case 'l': return KW_L;
+                case 'r': return KW_R;
+            }
+
+            break;
+        case 3:
+            switch (name[0])
+            {
+                case 'n':
+                    KW_MATCH (name, "now", KW_NOW);
+                    break;
+            }
+
+            break;
+        case 4:
+            switch (name[0])
+            {
+                case 'b':
+                    KW_MATCH (name, "body", KW_BODY);
+                    KW_MATCH (name, "bold", KW_BOLD);
+                    KW_MATCH (name, "book", KW_BOOK);
+                    break;
+                case 'c':
+                    KW_MATCH (name, "cell", KW_CELL);
+                    break;
+                case 'd':
+                    KW_MATCH (name, "data", KW_DATA);
+                    break;
+                case 'f':
+                    KW_MATCH (name, "font", KW_FONT);
+                    break;
+                case 'l':
+                    KW_MATCH (name, "left", KW_LEFT);
+                    break;
+                case 's':
+                    KW_MATCH (name, "size", KW_SIZE);
+                    break;
+                case 't':
+                    KW_MATCH (name, "thin", KW_THIN);
+                    break;
+                case 'v':
+                    KW_MATCH (name, "vbar", KW_VBAR);
+                    break;
+            }
+
+            break;
+        case 5:
+            switch (name[0])
+            {
+                case 'a':
+                    KW_MATCH (name, "align", KW_ALIGN);
+                    break;
+                case 'b':
+                    KW_MATCH (name, "boxed", KW_BOXED);
+                    break;
+                case 'g':
+                    KW_MATCH (name, "group", KW_GROUP);
+                    break;
+                case 'h':
+                    KW_MATCH (name, "heavy", KW_HEAVY);
+                    KW_MATCH (name, "hline", KW_HLINE);
+                    break;
+                case 'l':
+                    KW_MATCH (name, "light", KW_LIGHT);
+                    break;
+                case 'r':
+                    KW_MATCH (name, "right", KW_RIGHT);
+                    break;
+                case 's':
+                    KW_MATCH (name, "style", KW_STYLE);
+                    break;
+            }
+
+            break;
+        case 6:
+            switch (name[0])
+            {
+                case 'f':
+                    KW_MATCH (name, "family", KW_FAMILY);
+                    break;
+                case 'h':
+                    KW_MATCH (name, "header", KW_HEADER);
+                    break;
+                case 'i':
+                    KW_MATCH (name, "italic", KW_ITALIC);
+                    break;
+                case 'm':
+                    KW_MATCH (name, "medium", KW_MEDIUM);
+                    break;
+                case 'n':
+                    KW_MATCH (name, "normal", KW_NORMAL);
+                    break;
+                case 'p':
+                    KW_MATCH (name, "padtop", KW_PADTOP);
+                    KW_MATCH (name, "pageof", KW_PAGEOF);
+                    KW_MATCH (name, "printf", KW_PRINTF);
+                    break;
+                case 's':
+                    KW_MATCH (name, "static", KW_STATIC);
+                    break;
+                case 'w':
+                    KW_MATCH (name, "weight", KW_WEIGHT);
+                    break;
+            }
+
+            break;
+        case 7:
+            switch (name[0])
+            {
+                case 'o':
+                    KW_MATCH (name, "oblique", KW_OBLIQUE);
+                    break;
+                case 'p':
+                    KW_MATCH (name, "padding", KW_PADDING);
+                    KW_MATCH (name, "padleft", KW_PADLEFT);
+                    KW_MATCH (name, "percent", KW_PERCENT);
+                    break;
+                case 's':
+                    KW_MATCH (name, "stretch", KW_STRETCH);
+                    break;
+                case 'v':
+                    KW_MATCH (name, "variant", KW_VARIANT);
+                    break;
+            }
+
+            break;
+        case 8:
+            switch (name[0])
+            {
+                case 'c':
+                    KW_MATCH (name, "celltext", KW_CELLTEXT);
+                    break;
+                case 'e':
+                    KW_MATCH (name, "expanded", KW_EXPANDED);
+                    break;
+                case 'p':
+                    KW_MATCH (name, "padright", KW_PADRIGHT);
+                    break;
+                case 's':
+                    KW_MATCH (name, "semibold", KW_SEMIBOLD);
+                    break;
+            }
+
+            break;
+        case 9:
+            switch (name[0])
+            {
+                case 'c':
+                    KW_MATCH (name, "cellwidth", KW_CELLWIDTH);
+                    KW_MATCH (name, "condensed", KW_CONDENSED);
+                    break;
+                case 'd':
+                    KW_MATCH (name, "docheader", KW_DOCHEADER);
+                    KW_MATCH (name, "doublebar", KW_DOUBLEBAR);
+                    KW_MATCH (name, "doublebox", KW_DOUBLEBOX);
+                    break;
+                case 'p':
+                    KW_MATCH (name, "padbottom", KW_PADBOTTOM);
+                    break;
+                case 's':
+                    KW_MATCH (name, "singlebar", KW_SINGLEBAR);
+                    KW_MATCH (name, "singlebox", KW_SINGLEBOX);
+                    break;
+                case 'u':
+                    KW_MATCH (name, "ultrabold", KW_ULTRABOLD);
+                    break;
+            }
+
+            break;
+        case 10:
+            switch (name[0])
+            {
+                case 'c':
+                    KW_MATCH (name, "cellborder", KW_CELLBORDER);
+                    break;
+                case 'p':
+                    KW_MATCH (name, "pageheader", KW_PAGEHEADER);
+                    break;
+                case 's':
+                    KW_MATCH (name, "small-caps", KW_SMALL_CAPS);
+                    break;
+                case 't':
+                    KW_MATCH (name, "textsource", KW_TEXTSOURCE);
+                    break;
+                case 'u':
+                    KW_MATCH (name, "ultraheavy", KW_ULTRAHEAVY);
+                    KW_MATCH (name, "ultralight", KW_ULTRALIGHT);
+                    break;
+            }
+
+            break;
+        case 11:
+            switch (name[0])
+            {
+                case 'd':
+                    KW_MATCH (name, "defaultcell", KW_DEFAULTCELL);
+                    break;
+                case 'g':
+                    KW_MATCH (name, "groupsource", KW_GROUPSOURCE);
+                    break;
+                case 'o':
+                    KW_MATCH (name, "outerborder", KW_OUTERBORDER);
+                    break;
+                case 'p':
+                    KW_MATCH (name, "pointsabove", KW_POINTSABOVE);
+                    KW_MATCH (name, "pointsbelow", KW_POINTSBELOW);
+                    break;
+            }
+
+            break;
+        case 13:
+            switch (name[0])
+            {
+                case 's':
+                    KW_MATCH (name, "semi-expanded", KW_SEMI_EXPANDED);
+                    break;
+            }
+
+            break;
+        case 14:
+            switch (name[0])
+            {
+                case 'd':
+                    KW_MATCH (name, "defaultpadding", KW_DEFAULTPADDING);
+                    break;
+                case 'e':
+                    KW_MATCH (name, "extra-expanded", KW_EXTRA_EXPANDED);
+                    break;
+                case 's':
+                    KW_MATCH (name, "semi-condensed", KW_SEMI_CONDENSED);
+                    KW_MATCH (name, "singlebarheavy", KW_SINGLEBARHEAVY);
+                    break;
+                case 'u':
+                    KW_MATCH (name, "ultra-expanded", KW_ULTRA_EXPANDED);
+                    break;
+            }
+
+            break;
+        case 15:
+            switch (name[0])
+            {
+                case 'e':
+                    KW_MATCH (name, "extra-condensed", KW_EXTRA_CONDENSED);
+                    break;
+                case 'u':
+                    KW_MATCH (name, "ultra-condensed", KW_ULTRA_CONDENSED);
+                    break;
+            }
+
+            break;
+    }
+
+    return KW_NONE;
+}
+
+/* **************************************************************** *
+ * name_to_pango_style() - Converts a name (text string) to a       *
+ *          numeric Pango Style.                                    *
+ * **************************************************************** */
+
+PangoStyle
+name_to_pango_style (const char *name)
+{
+    switch (lookup_keyword (name))
+    {
+        case KW_OBLIQUE:    return PANGO_STYLE_OBLIQUE;
+        case KW_ITALIC:     return PANGO_STYLE_ITALIC;
+        default:            return PANGO_STYLE_NORMAL;
+    }
+}
+
+/* **************************************************************** *
+ * name_to_pango_weight() - Converts a name string to a PangoWeight *
+ * **************************************************************** */
+
+PangoWeight
+name_to_pango_weight (const char *name)
+{
+    switch (lookup_keyword (name))
+    {
+        case KW_THIN:       return PANGO_WEIGHT_THIN;
+        case KW_ULTRALIGHT: return PANGO_WEIGHT_ULTRALIGHT;
+        case KW_LIGHT:      return PANGO_WEIGHT_LIGHT;
+        case KW_BOOK:       return PANGO_WEIGHT_BOOK;
+        case KW_MEDIUM:     return PANGO_WEIGHT_MEDIUM;
+        case KW_SEMIBOLD:   return PANGO_WEIGHT_SEMIBOLD;
+        case KW_BOLD:       return PANGO_WEIGHT_BOLD;
+        case KW_ULTRABOLD:  return PANGO_WEIGHT_ULTRABOLD;
+        case KW_HEAVY:      return PANGO_WEIGHT_HEAVY;
+        case KW_ULTRAHEAVY: return PANGO_WEIGHT_ULTRAHEAVY;
+        default:            return PANGO_WEIGHT_NORMAL;
+    }
+}
+
+PangoVariant
+name_to_pango_variant (const char *name)
+{
+    switch (lookup_keyword (name))
+    {
+        case KW_SMALL_CAPS: return PANGO_VARIANT_SMALL_CAPS;
+        default:            return PANGO_VARIANT_NORMAL;
+    }
+}
+
+PangoStretch
+name_to_pango_stretch (const char *name)
+{
+    switch (lookup_keyword (name))
+    {
+        case KW_ULTRA_CONDENSED:    return PANGO_STRETCH_ULTRA_CONDENSED;
+        case KW_EXTRA_CONDENSED:    return PANGO_STRETCH_EXTRA_CONDENSED;
+        case KW_CONDENSED:          return PANGO_STRETCH_CONDENSED;
+        case KW_SEMI_CONDENSED:     return PANGO_STRETCH_SEMI_CONDENSED;
+        case KW_SEMI_EXPANDED:      return PANGO_STRETCH_SEMI_EXPANDED;
+        case KW_EXPANDED:           return PANGO_STRETCH_EXPANDED;
+        case KW_EXTRA_EXPANDED:     return PANGO_STRETCH_EXTRA_EXPANDED;
+        case KW_ULTRA_EXPANDED:     return PANGO_STRETCH_ULTRA_EXPANDED;
+        default:                    return PANGO_STRETCH_NORMAL;
+    }
+}
+
+PangoAlignment
+name_to_layout_align (const char *name)
+{
+    switch (lookup_keyword (name))
+    {
+        case KW_C:          return PANGO_ALIGN_CENTER;
+        case KW_R:          return PANGO_ALIGN_RIGHT;
+        default:            return PANGO_ALIGN_LEFT;
+    }
+}
+
+/* **************************************************************** *
+ * find_tag() - Locate the start tag of "element_name" in the       *
+ *      mapped file, for map_attrib().  Each search begins where    *
+ *      the last one left off, so the tag found is never beyond     *
+ *      the one the parser has just read.                           *
+ * **************************************************************** */
+
+static void
+find_tag (StylePrintTemplate *self, const gchar *element_name)
+{
+    gchar *end = g_mapped_file_get_contents (self->mapping) +
+                    g_mapped_file_get_length (self->mapping),
+          *p = self->scan;
+    gsize len = strlen (element_name);
+
+    self->tag = self->tagend = NULL;
+
+    while (p && (p = memchr (p, '<', end - p)))
+    {
+        ++p;
+
+        if (((gsize)(end - p) > len) && !memcmp (p, element_name, len) &&
+                p[len] && strchr (" \t\r\n/>", p[len]))
+        {
+            self->scan = p;
+            self->tag = p + len;
+            self->tagend = memchr (self->tag, '>', end - self->tag);
+            break;
+        }
+    }
+}
+
+/* **************************************************************** *
+ * map_attrib() - Find the value of attribute "name" of the current *
+ *      tag in the mapped file.  The value is used only if it was   *
+ *      written without entities, so that the bytes in the file are *
+ *      the value itself.  The closing quote is replaced by a NUL,  *
+ *      which is safe as the parser has already read past it.      *
+ * Returns: The value in the mapping, or NULL if not usable         *
+ * **************************************************************** */
+
+static gchar *
+map_attrib (StylePrintTemplate *self, const gchar *name, const gchar *val)
+{
+    gsize nlen = strlen (name),
+          vlen = strlen (val);
+    gchar *p,
+          *q,
+          quote;
+
+    if (!self->tagend)
+    {
+        return NULL;
+    }
+
+    for (p = self->tag; (gsize)(self->tagend - p) > nlen; p++)
+    {
+        if (!g_ascii_isspace (p[-1]) || memcmp (p, name, nlen))
+        {
+            continue;
+        }
+
+        for (q = p + nlen; g_ascii_isspace (*q); q++);
+
+        if (*q++ != '=')
+        {
+            continue;
+        }
+
+        while (g_ascii_isspace (*q))
+        {
+            ++q;
+        }
+
+        quote = *q++;
+
+        if (((quote == '"') || (quote == '\'')) &&
+                ((gsize)(self->tagend - q) > vlen) &&
+                !memcmp (q, val, vlen) && (q[vlen] == quote))
+        {
+            q[vlen] = '\0';
+
+            // The mapping is private, so writing to a page gives the
+            // template its own copy.  Touch every page of the value so
+            // that it stays intact if the file is rewritten in place.
+            for (p = q; p < q + vlen; p += 4096)
+            {
+                *(volatile gchar *)p = *p;
+            }
+
+            return q;
+        }
+    }
+
+    return NULL;
+}
+
+/* **************************************************************** *
+ * intern_attrib() - Get a copy of "val", the value of attribute    *
+ *      "name", which lasts as long as the template.  It points     *
+ *      into the mapped file if possible, otherwise into "strings". *
+ * **************************************************************** */
+
+static const gchar *
+intern_attrib (StylePrintTemplate *self, const gchar *name, const gchar *val)
+{
+    const gchar *str = self->mapping ? map_attrib (self, name, val) : NULL;
+
+    return str ? str : g_string_chunk_insert_const (self->strings, val);
+}
+
+/* **************************************************************** *
+ * add_cell_attribs() - Add attributes to a cell definition.  This  *
+ *      portion is broken out of append_cell_defs() in order to     *
+ *      handle attribute settings for cells that are not made up    *
+ *      of arrays, such as "defaultcell".                           *
+ * **************************************************************** */
+
+static void
+add_cell_attribs (StylePrintTemplate *self, CELLINF *cell,
+                  const gchar **attrib_names, const gchar **attrib_vals)
+{
+    int idx = 0;
+
+    while (attrib_names[idx])
+    {
+        const char *val = attrib_vals[idx];
+
+        switch (lookup_keyword (attrib_names[idx]))
+        {
+            case KW_PERCENT:
+                cell->percent = strtof (val, NULL);
+                break;
+            case KW_CELLWIDTH:
+                cell->cellwidth = strtof (val, NULL);
+                break;
+            case KW_TEXTSOURCE:
+                switch (lookup_keyword (val))
+                {
+                    case KW_DATA:   cell->txtsource = TSRC_DATA;    break;
+                    case KW_STATIC: cell->txtsource = TSRC_STATIC;  break;
+                    case KW_NOW:    cell->txtsource = TSRC_NOW;     break;
+                    case KW_PRINTF: cell->txtsource = TSRC_PRINTF;  break;
+                    case KW_PAGEOF: cell->txtsource = TSRC_PAGEOF;  break;
+                    //TODO: add error reporting...
+                }
+
+                break;
+            case KW_CELLTEXT:
+                cell->celltext = intern_attrib (self, attrib_names[idx], val);
+                break;
+            case KW_ALIGN:
+                cell->layoutalign = name_to_layout_align (val);
+                break;
+            // TODO: add error reporting
+        }
+
+        ++idx;
+    }
+}
+
+/* **************************************************************** *
+ * append_cell_defs() : Populate a cell definition in the row       *
+ *          array, and append this new cell onto the array of cells *
+ *  If the array has not already been created, it is now created.   *
+ * **************************************************************** */
+
+static CELLINF *
+append_cell_def (StylePrintTemplate *self, const gchar **attrib_names,
+                    const gchar **attrib_vals, GRPINF *parentgrp)
+{
+    CELLINF *mycell;
+
+    if (!parentgrp->celldefs)
+    {
+        parentgrp->celldefs = g_ptr_array_new_with_free_func (
+                (GDestroyNotify)free_celldef);
+        parentgrp->rowslot = self->nrows++;
+    }
+
+    mycell = g_malloc0 (sizeof(CELLINF));
+    mycell->grptype = GRPTY_CELL;
+    mycell->padleft = CELLPAD_DFLT;
+    mycell->padright = CELLPAD_DFLT;
+
+    mycell->pangofont = parentgrp->pangofont ? parentgrp->pangofont
+                                             : self->defaultcell->pangofont;
+
+    add_cell_attribs (self, mycell, attrib_names, attrib_vals);
+    g_ptr_array_add (parentgrp->celldefs, mycell);
+
+    return mycell;
+}
+
+/* **************************************************************** *
+ * allocate_new_group() - Allocates space for a new group, body,    *
+ *          header group and initializes it.                        *
+ * Passed : (1) - Pointer to the group under which this will exist  *
+ *          (2) - The GRPTY_* of this grouping.                     *
+ * Returns: Pointer to this new group's definition.                 *
+ * **************************************************************** */
+
+
+static GRPINF *
+allocate_new_group (StylePrintTemplate *self, const char **attrib_names,
+                    const char **attrib_vals, GRPINF *parent, int grptype)
+{
+    int grpidx = 0;
+    GRPINF *newgrp = g_malloc0 (sizeof(GRPINF));
+
+    if ((grptype == GRPTY_GROUP) || (grptype == GRPTY_BODY))
+    {
+        if (!parent && !self->grpHd)
+        {
+            self->grpHd = (GRPINF *)newgrp;
+            newgrp = self->grpHd;
+        }
+    }
+
+    newgrp->grptype = grptype;
+
+    newgrp->pangofont = (parent && parent->pangofont) ? parent->pangofont
+                                            : self->defaultcell->pangofont;
+
+    if (parent)
+    {
+        newgrp->grpparent = parent;
+    }
+
+    newgrp->slot = (grptype == GRPTY_GROUP) ? self->ngroups++ : -1;
+    newgrp->rowslot = -1;
+
+    while (attrib_names[grpidx])
+    {
+        const char *val = attrib_vals[grpidx];
+
+        switch (lookup_keyword (attrib_names[grpidx]))
+        {
+            case KW_GROUPSOURCE:
+                newgrp->grpcol = intern_attrib (self, attrib_names[grpidx],
+                                                val);
+                break;
+            case KW_POINTSABOVE:
+                newgrp->pointsabove = atoi (val);
+                break;
+            case KW_POINTSBELOW:
+                newgrp->pointsbelow = atoi (val);
+                break;
+            case KW_OUTERBORDER:
+                switch (lookup_keyword (val))
+                {
+                    case KW_SINGLEBAR:
+                        newgrp->borderstyle = SINGLEBAR;
+                        break;
+                    case KW_DOUBLEBAR:
+                        newgrp->borderstyle = DBLBAR;
+                        break;
+                    case KW_SINGLEBARHEAVY:
+                        newgrp->borderstyle = SINGLEBAR_HVY;
+                        break;
+                    case KW_SINGLEBOX:
+                        newgrp->borderstyle = SINGLEBOX;
+                        break;
+                    case KW_DOUBLEBOX:
+                        newgrp->borderstyle = DBLBOX;
+                        break;
+                }
+
+                break;
+
+            // We may wish to move this into the body allocation segment
+            case KW_CELLBORDER:
+                switch (lookup_keyword (val))
+                {
+                    case KW_HLINE:
+                        newgrp->borderstyle = BDY_HLINE;
+                        break;
+                    case KW_VBAR:
+                        newgrp->borderstyle = BDY_VBAR;
+                        break;
+                    case KW_BOXED:
+                        newgrp->borderstyle = BDY_HLINE | BDY_VBAR;
+                        break;
+                }
+
+                break;
+        }
+
+        ++grpidx;
+    }
+
+    return newgrp;
+}
+
+static ROWPAD *
+set_padding_attribs (ROWPAD *pad,
+                     const char **attrib_names, const char **attrib_vals)
+{
+    int idx = 0;
+
+    while (attrib_names[idx])
+    {
+        switch (lookup_keyword (attrib_names[idx]))
+        {
+            case KW_PADLEFT:
+                pad->left = atoi (attrib_vals[idx]);
+                break;
+            case KW_PADRIGHT:
+                pad->right = atoi (attrib_vals[idx]);
+                break;
+            case KW_PADTOP:
+                pad->top = atoi (attrib_vals[idx]);
+                break;
+            case KW_PADBOTTOM:
+                pad->bottom = atoi (attrib_vals[idx]);
+                break;
+            //TODO: else error???
+        }
+
+        ++idx;
+    }
+
+    return pad;
+}
+
+static void
+start_element_main (GMarkupParseContext *context,
+                    const gchar  *element_name,
+                    const gchar **attrib_names,
+                    const gchar **attrib_vals,
+                       gpointer   myself,
+                         GError **error)
+{
+    gpointer newgrp = NULL;
+    GRPINF *parent = NULL;
+    StylePrintTemplate *self = STYLE_PRINT_TEMPLATE(myself);
+
+    if (self->mapping)
+    {
+        find_tag (self, element_name);
+    }
+
+    if (self->elList)
+    {
+        parent = g_slist_nth(self->elList, 0)->data;
+    }
+
+    switch (lookup_keyword (element_name))
+    {
+        PangoFontDescription *font;
+        int idx;
+
+        case KW_CELL:
+            if (parent)
+            {
+                newgrp =
+                    append_cell_def (self,
+                            attrib_names, attrib_vals, (GRPINF *)parent);
+            }
+            else
+            {
+                // Error
+            }
+
+            break;
+        case KW_DEFAULTCELL:
+            add_cell_attribs (self, self->defaultcell,
+                              attrib_names, attrib_vals);
+            newgrp = self->defaultcell;
+            break;
+        case KW_GROUP:
+            newgrp = allocate_new_group ( self,
+                    attrib_names, attrib_vals, (GRPINF *)parent, GRPTY_GROUP);
+            if (parent)
+            {
+                ((GRPINF *)parent)->grpchild = newgrp;
+            }
+            else
+            {
+                 self->grpHd = (GRPINF *)newgrp;
+            }
+
+            break;
+        case KW_HEADER:
+            if (parent)
+            {
+                newgrp = allocate_new_group (self,
+                            attrib_names, attrib_vals, parent, GRPTY_HEADER);
+                ((GRPINF *)parent)->header = newgrp;
+            }
+
+            break;
+        case KW_BODY:
+            newgrp = allocate_new_group (self,
+                    attrib_names, attrib_vals, (GRPINF *)parent, GRPTY_BODY);
+            if (parent)
+            {
+                ((GRPINF *)parent)->grpchild = newgrp;
+            }
+            else
+            {
+                 self->grpHd = (GRPINF *)newgrp;
+            }
+
+            break;
+        case KW_FONT:
+            // The font of the enclosing group or cell is replaced by a
+            // modified copy - the shared description itself is left alone
+            if (!parent)
+            {
+                break;
+            }
+
+            font = pango_font_description_copy (parent->pangofont ?
+                            parent->pangofont : self->defaultcell->pangofont);
+
+            for (idx = 0; attrib_names[idx]; idx++)
+            {
+                const char *val = attrib_vals[idx];
+
+                switch (lookup_keyword (attrib_names[idx]))
+                {
+                    case KW_FAMILY:
+                        pango_font_description_set_family (font, val);
+                        break;
+                    case KW_SIZE:
+                        pango_font_description_set_size (font,
+                                    atoi(val) * PANGO_SCALE);
+                        break;
+                    case KW_STYLE:
+                        pango_font_description_set_style (font,
+                                    name_to_pango_style (val));
+                        break;
+                    case KW_WEIGHT:
+                        pango_font_description_set_weight (font,
+                                    name_to_pango_weight (val));
+                        break;
+                    case KW_VARIANT:
+                        pango_font_description_set_variant (font,
+                                    name_to_pango_variant (val));
+                        break;
+                    case KW_STRETCH:
+                        pango_font_description_set_stretch (font,
+                                    name_to_pango_stretch (val));
+                        break;
+                }
+            }
+
+            parent->pangofont = intern_font (self, font);
+            newgrp = parent;
+            break;
+        case KW_DOCHEADER:
+            if (! self->DocHeader)
+            {
+                 self->DocHeader =
+                        allocate_new_group ( self, attrib_names, attrib_vals,
+                                NULL, GRPTY_DOCHD);
+            }
+
+            newgrp =  self->DocHeader;
+            break;
+        case KW_PAGEHEADER:
+            if (! self->PageHeader)
+            {
+                 self->PageHeader =
+                        allocate_new_group ( self, attrib_names, attrib_vals,
+                                NULL, GRPTY_PAGEHEADER);
+            }
+
+            newgrp =  self->PageHeader;
+            break;
+        case KW_PADDING:
+            if (!parent)
+            {
+                break;
+            }
+
+            switch (parent->grptype)
+            {
+                case GRPTY_GROUP:
+
+                    if (!parent->padding)
+                    {
+                        ROWPAD *pads = g_malloc0(sizeof(ROWPAD));
+                        // Init all to -1 to flag "not set"
+                        pads->left = -1;
+                        pads->right = -1;
+                        pads->top = -1;
+                        pads->bottom = -1;
+                        parent->padding = pads;
+                    }
+
+                    newgrp = set_padding_attribs (parent->padding,
+                                                  attrib_names,
+                                                  attrib_vals);
+                    break;
+                case GRPTY_CELL:
+                    newgrp = parent;
+
+                    for (idx = 0; attrib_names[idx]; idx++)
+                    {
+                        switch (lookup_keyword (attrib_names[idx]))
+                        {
+                            case KW_LEFT:
+                                ((CELLINF *)newgrp)->padleft =
+                                                atoi (attrib_vals[idx]);
+                                break;
+                            case KW_RIGHT:
+                                ((CELLINF *)newgrp)->padright =
+                                                atoi (attrib_vals[idx]);
+                                break;
+                        }
+                    }
+
+                    break;
+                default:
+                    newgrp = parent;
+                    break;
+            }
+
+            break;
+        case KW_DEFAULTPADDING:
+            // TODO: if parent, error???
+
+            if (! self->DefaultPadding)
+            {
+                self->DefaultPadding = g_malloc0 (sizeof(ROWPAD));
+            }
+
+            self->DefaultPadding = set_padding_attribs (
+                        self->DefaultPadding, attrib_names, attrib_vals);
+            newgrp = self->DefaultPadding;
+            break;
+    }
+
+    if (newgrp)
+    {
+        self->elList = g_slist_prepend(self->elList, newgrp);
+    }
+    // Trying to elimintate this feature
+    //g_markup_parse_context_push (context, &sub_prs, newgrp);
+}
+
+static void
+end_element_main (GMarkupParseContext  *context,
+                          const gchar  *element_name,
+                             gpointer   tpl,
+                              GError  **error)
+{
+    StylePrintTemplate *self = STYLE_PRINT_TEMPLATE(tpl);
+
+    // Pop this item off the List
+    if (self->elList)
+    {
+        self->elList = g_slist_delete_link (self->elList,
+                                            g_slist_nth(self->elList, 0));
+    }
+}
+
+
+/* **************************************************************** *
+ * template_parse() - Parse the xml definition into "self".  "xml"  *
+ *      is a NULL-terminated array of strings which together make   *
+ *      up the definition.  If "len" is not -1, "xml" holds just    *
+ *      the one string, of "len" bytes.                             *
+ * Returns: "self", or NULL (setting "error" and dropping "self")   *
+ *      on failure                                                  *
+ * **************************************************************** */
+
+static StylePrintTemplate *
+template_parse (StylePrintTemplate *self, const gchar * const *xml,
+                gssize len, GError **error)
+{
+    GMarkupParseContext *gmp_contxt;
+    gboolean ok = TRUE;
+    gint idx;
+
+    gmp_contxt = g_markup_parse_context_new (&prsr,
+                        G_MARKUP_TREAT_CDATA_AS_TEXT, self, NULL);
+
+    for (idx = 0; ok && xml[idx]; idx++)
+    {
+        ok = g_markup_parse_context_parse (gmp_contxt, xml[idx], len, error);
+    }
+
+    if (ok)
+    {
+        ok = g_markup_parse_context_end_parse (gmp_contxt, error);
+    }
+
+    g_markup_parse_context_free (gmp_contxt);
+    g_slist_free (self->elList);
+    self->elList = NULL;
+    self->scan = self->tag = self->tagend = NULL;
+
+    if (!ok)
+    {
+        g_object_unref (self);
+        return NULL;
+    }
+
+    // Padding which is "not set" is taken from here when rendering
+    if (!self->DefaultPadding)
+    {
+        self->DefaultPadding = g_malloc0 (sizeof(ROWPAD));
+    }
+
+    return self;
+}
+
+/**
+ * style_print_template_new_from_file:
+ * @filename: The name of the file containing the xml definition
+ * @error: Return location for a #GError, or NULL
+ *
+ * Maps and parses the xml definition for a printout from a file.  Text
+ * attributes such as "celltext" and "groupsource" point into the mapping
+ * where they can, so the mapping is kept for the life of the template.
+ * The template is not added to the template cache.
+ *
+ * Returns: (transfer full) (nullable): A new #StylePrintTemplate, or NULL
+ * if the file could not be read or parsed
+ */
+
+StylePrintTemplate *
+style_print_template_new_from_file (const gchar *filename, GError **error)
+{
+    StylePrintTemplate *self;
+    struct stat st;
+    const gchar *xml[2] = {NULL, NULL};
+    gint fd,
+         saved_errno;
+
+    g_return_val_if_fail (filename != NULL, NULL);
+
+    if ((fd = g_open (filename, O_RDONLY, 0)) < 0)
+    {
+        saved_errno = errno;
+        g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (saved_errno),
+                     "Failed to open file '%s': %s", filename,
+                     g_strerror (saved_errno));
+        return NULL;
+    }
+
+    self = g_object_new (STYLE_PRINT_TYPE_TEMPLATE, NULL);
+
+    // The file is identified by its state when mapped, so that if it
+    // changes afterwards, it is read again on the next lookup.
+    if (fstat (fd, &st) == 0)
+    {
+        self->mtime = st.st_mtime;
+        self->size = st.st_size;
+    }
+
+    // Writable, so that strings can be terminated in place - the mapping
+    // is private, and nothing is ever written back to the file.
+    self->mapping = g_mapped_file_new_from_fd (fd, TRUE, error);
+    close (fd);
+
+    if (!self->mapping)
+    {
+        g_object_unref (self);
+        return NULL;
+    }
+
+    // The whole file is parsed in one call.  An empty file maps to NULL,
+    // which is left for the parser to report as an empty document.
+    self->scan = g_mapped_file_get_contents (self->mapping);
+    xml[0] = self->scan ? self->scan : "";
+
+    return template_parse (self, xml, g_mapped_file_get_length (self->mapping),
+                           error);
+}
+
+/**
+ * style_print_template_new_from_string:
+ * @xml: The xml definition
+ * @error: Return location for a #GError, or NULL
+ *
+ * Parses the xml definition for a printout contained in a string.  The
+ * template is not added to the template cache.
+ *
+ * Returns: (transfer full) (nullable): A new #StylePrintTemplate, or NULL
+ * if the xml could not be parsed
+ */
+
+StylePrintTemplate *
+style_print_template_new_from_string (const gchar *xml, GError **error)
+{
+    const gchar *ary[2] = {xml, NULL};
+
+    g_return_val_if_fail (xml != NULL, NULL);
+
+    return template_parse (g_object_new (STYLE_PRINT_TYPE_TEMPLATE, NULL),
+                           ary, -1, error);
+}
+
+/**
+ * style_print_template_new_from_array:
+ * @xml: (array zero-terminated=1): A NULL-terminated array of strings
+ * which together make up the xml definition
+ * @error: Return location for a #GError, or NULL
+ *
+ * Parses the xml definition for a printout contained in an array of
+ * strings.  The template is not added to the template cache.
+ *
+ * Returns: (transfer full) (nullable): A new #StylePrintTemplate, or NULL
+ * if the xml could not be parsed
+ */
+
+StylePrintTemplate *
+style_print_template_new_from_array (gchar **xml, GError **error)
+{
+    g_return_val_if_fail (xml != NULL, NULL);
+
+    return template_parse (g_object_new (STYLE_PRINT_TYPE_TEMPLATE, NULL),
+                           (const gchar * const *)xml, -1, error);
+}
+
+/* **************************************************************** *
+ * static_font() - Get the pooled font description for "font", or  *
+ *      "dflt" if it is NULL.                                       *
+ * **************************************************************** */
+
+static const PangoFontDescription *
+static_font (StylePrintTemplate *self, const gchar *font,
+             const PangoFontDescription *dflt)
+{
+    return font ? intern_font (self, pango_font_description_from_string (font))
+                : dflt;
+}
+
+/* **************************************************************** *
+ * static_group() - Build the GRPINF for a group in static tables,  *
+ *      with its header and descendants.  The strings are not       *
+ *      copied: they remain in the tables.                          *
+ * **************************************************************** */
+
+static GRPINF *
+static_group (StylePrintTemplate *self, const StylePrintStaticGroup *sg,
+              GRPINF *parent)
+{
+    GRPINF *grp = g_malloc0 (sizeof(GRPINF));
+    guint idx;
+
+    grp->grptype = sg->grptype;
+    grp->pangofont = static_font (self, sg->font, parent ? parent->pangofont
+                                            : self->defaultcell->pangofont);
+    grp->grpcol = sg->grpcol;
+    grp->pointsabove = sg->pointsabove;
+    grp->pointsbelow = sg->pointsbelow;
+    grp->borderstyle = sg->borderstyle;
+    grp->grpparent = parent;
+    grp->slot = (grp->grptype == GRPTY_GROUP) ? self->ngroups++ : -1;
+    grp->rowslot = -1;
+
+    if (sg->padding)
+    {
+        grp->padding = g_malloc (sizeof(ROWPAD));
+        grp->padding->left = sg->padding[0];
+        grp->padding->top = sg->padding[1];
+        grp->padding->right = sg->padding[2];
+        grp->padding->bottom = sg->padding[3];
+    }
+
+    if (sg->ncells)
+    {
+        grp->celldefs = g_ptr_array_new_full (sg->ncells,
+                                        (GDestroyNotify)free_celldef);
+        grp->rowslot = self->nrows++;
+    }
+
+    for (idx = 0; idx < sg->ncells; idx++)
+    {
+        const StylePrintStaticCell *sc = &sg->cells[idx];
+        CELLINF *cell = g_malloc0 (sizeof(CELLINF));
+
+        cell->grptype = GRPTY_CELL;
+        cell->pangofont = static_font (self, sc->font, grp->pangofont);
+        cell->txtsource = sc->txtsource;
+        cell->celltext = sc->celltext;
+        cell->percent = sc->percent;
+        cell->cellwidth = sc->cellwidth;
+        cell->padleft = sc->padleft;
+        cell->padright = sc->padright;
+        cell->borderstyle = sc->borderstyle;
+        cell->layoutalign = sc->align;
+        g_ptr_array_add (grp->celldefs, cell);
+    }
+
+    if (sg->header)
+    {
+        grp->header = static_group (self, sg->header, grp);
+    }
+
+    if (sg->child)
+    {
+        grp->grpchild = static_group (self, sg->child, grp);
+    }
+
+    return grp;
+}
+
+/**
+ * style_print_template_new_from_static:
+ * @tables: The printout definition, as written by styleprint-compile
+ *
+ * Creates a template from a definition compiled into static tables by the
+ * styleprint-compile tool, without parsing any xml.  The strings in
+ * @tables are used in place, so @tables must remain valid for as long as
+ * the template exists - normally they are the application's static data.
+ * The template is not added to the template cache.
+ *
+ * Returns: (transfer full): A new #StylePrintTemplate
+ */
+
+StylePrintTemplate *
+style_print_template_new_from_static (const StylePrintStaticTemplate *tables)
+{
+    StylePrintTemplate *self;
+
+    g_return_val_if_fail (tables != NULL, NULL);
+
+    self = g_object_new (STYLE_PRINT_TYPE_TEMPLATE, NULL);
+
+    if (tables->defaultfont)
+    {
+        self->defaultcell->pangofont = intern_font (self,
+                    pango_font_description_from_string (tables->defaultfont));
+    }
+
+    self->DefaultPadding = g_malloc0 (sizeof(ROWPAD));
+
+    if (tables->defaultpadding)
+    {
+        self->DefaultPadding->left = tables->defaultpadding[0];
+        self->DefaultPadding->top = tables->defaultpadding[1];
+        self->DefaultPadding->right = tables->defaultpadding[2];
+        self->DefaultPadding->bottom = tables->defaultpadding[3];
+    }
+
+    if (tables->docheader)
+    {
+        self->DocHeader = static_group (self, tables->docheader, NULL);
+    }
+
+    if (tables->pageheader)
+    {
+        self->PageHeader = static_group (self, tables->pageheader, NULL);
+    }
+
+    if (tables->body)
+    {
+        self->grpHd = static_group (self, tables->body, NULL);
+    }
+
+    return self;
+}
+
+/* **************************************************************** *
+ * cache_get() - Find the template cached under "key".              *
+ * Returns: A new reference to the template, or NULL if none        *
+ * **************************************************************** */
+
+static StylePrintTemplate *
+cache_get (const gchar *key)
+{
+    StylePrintTemplate *tpl = NULL;
+
+    G_LOCK (template_cache);
+
+    if (TemplateCache && (tpl = g_hash_table_lookup (TemplateCache, key)))
+    {
+        g_object_ref (tpl);
+    }
+
+    G_UNLOCK (template_cache);
+    return tpl;
+}
+
+/* **************************************************************** *
+ * cache_put() - Cache "tpl" under "key", replacing any template    *
+ *      already cached under it.  The cache takes ownership of key. *
+ * **************************************************************** */
+
+static void
+cache_put (gchar *key, StylePrintTemplate *tpl)
+{
+    G_LOCK (template_cache);
+
+    if (!TemplateCache)
+    {
+        TemplateCache = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                                g_free, g_object_unref);
+    }
+
+    g_hash_table_replace (TemplateCache, key, g_object_ref (tpl));
+    G_UNLOCK (template_cache);
+}
+
+/**
+ * style_print_template_lookup_file:
+ * @filename: The name of the file containing the xml definition
+ * @error: Return location for a #GError, or NULL
+ *
+ * Gets the template for the xml definition in the file @filename from the
+ * template cache.  If it is not cached, or the file has been modified
+ * since it was cached, the file is parsed, and the new template replaces
+ * the cached one.
+ *
+ * Returns: (transfer full) (nullable): The #StylePrintTemplate, or NULL if
+ * the file could not be read or parsed
+ */
+
+StylePrintTemplate *
+style_print_template_lookup_file (const gchar *filename, GError **error)
+{
+    StylePrintTemplate *tpl;
+    GStatBuf st;
+    gchar *key;
+
+    g_return_val_if_fail (filename != NULL, NULL);
+
+    key = g_strconcat ("file:", filename, NULL);
+
+    if ((tpl = cache_get (key)))
+    {
+        if ((g_stat (filename, &st) == 0) && (tpl->mtime == st.st_mtime) &&
+                (tpl->size == st.st_size))
+        {
+            g_free (key);
+            return tpl;
+        }
+
+        g_object_unref (tpl);
+    }
+
+    if ((tpl = style_print_template_new_from_file (filename, error)))
+    {
+        cache_put (key, tpl);
+    }
+    else
+    {
+        g_free (key);
+    }
+
+    return tpl;
+}
+
+/* **************************************************************** *
+ * lookup_checksum() - Get the template for the xml in the array    *
+ *      "xml" from the cache, keyed by a checksum of its contents,  *
+ *      parsing and caching it if it is not there.                  *
+ * **************************************************************** */
+
+static StylePrintTemplate *
+lookup_checksum (const gchar * const *xml, GError **error)
+{
+    StylePrintTemplate *tpl;
+    GChecksum *sum;
+    gchar *key;
+    gint idx;
+
+    sum = g_checksum_new (G_CHECKSUM_SHA256);
+
+    for (idx = 0; xml[idx]; idx++)
+    {
+        g_checksum_update (sum, (const guchar *)xml[idx], -1);
+    }
+
+    key = g_strconcat ("xml:", g_checksum_get_string (sum), NULL);
+    g_checksum_free (sum);
+
+    if ((tpl = cache_get (key)))
+    {
+        g_free (key);
+        return tpl;
+    }
+
+    if ((tpl = template_parse (g_object_new (STYLE_PRINT_TYPE_TEMPLATE, NULL),
+                               xml, -1, error)))
+    {
+        cache_put (key, tpl);
+    }
+    else
+    {
+        g_free (key);
+    }
+
+    return tpl;
+}
+
+/**
+ * style_print_template_lookup_string:
+ * @xml: The xml definition
+ * @error: Return location for a #GError, or NULL
+ *
+ * Gets the template for the xml definition @xml from the template cache,
+ * parsing it and adding it to the cache if it is not there.  The template
+ * stays cached until style_print_template_cache_clear(), so a definition
+ * built at run time should be parsed with
+ * style_print_template_new_from_string() instead.
+ *
+ * Returns: (transfer full) (nullable): The #StylePrintTemplate, or NULL if
+ * the xml could not be parsed
+ */
+
+StylePrintTemplate *
+style_print_template_lookup_string (const gchar *xml, GError **error)
+{
+    const gchar *ary[2] = {xml, NULL};
+
+    g_return_val_if_fail (xml != NULL, NULL);
+
+    return lookup_checksum (ary, error);
+}
+
+/**
+ * style_print_template_lookup_array:
+ * @xml: (array zero-terminated=1): A NULL-terminated array of strings
+ * which together make up the xml definition
+ * @error: Return location for a #GError, or NULL
+ *
+ * Gets the template for the xml definition in the array @xml from the
+ * template cache, parsing it and adding it to the cache if it is not
+ * there.  As with style_print_template_lookup_string(), the template stays
+ * cached until style_print_template_cache_clear().
+ *
+ * Returns: (transfer full) (nullable): The #StylePrintTemplate, or NULL if
+ * the xml could not be parsed
+ */
+
+StylePrintTemplate *
+style_print_template_lookup_array (gchar **xml, GError **error)
+{
+    g_return_val_if_fail (xml != NULL, NULL);
+
+    return lookup_checksum ((const gchar * const *)xml, error);
+}
+
+/**
+ * style_print_template_lookup_static:
+ * @tables: The printout definition, as written by styleprint-compile
+ *
+ * Gets the template for the compiled definition @tables from the template
+ * cache, creating it with style_print_template_new_from_static() if it is
+ * not there.  The tables are identified by their address.
+ *
+ * Returns: (transfer full): The #StylePrintTemplate
+ */
+
+StylePrintTemplate *
+style_print_template_lookup_static (const StylePrintStaticTemplate *tables)
+{
+    StylePrintTemplate *tpl;
+    gchar *key;
+
+    g_return_val_if_fail (tables != NULL, NULL);
+
+    key = g_strdup_printf ("static:%p", (gconstpointer)tables);
+
+    if ((tpl = cache_get (key)))
+    {
+        g_free (key);
+        return tpl;
+    }
+
+    tpl = style_print_template_new_from_static (tables);
+    cache_put (key, tpl);
+    return tpl;
+}
+
+/**
+ * style_print_template_cache_clear:
+ *
+ * Drops every template from the template cache.  Templates still in use
+ * remain valid until they are unreferenced.
+ */
+
+void
+style_print_template_cache_clear (void)
+{
+    G_LOCK (template_cache);
+
+    if (TemplateCache)
+    {
+        g_hash_table_remove_all (TemplateCache);
+    }
+
+    G_UNLOCK (template_cache);
+}
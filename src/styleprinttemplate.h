@@ -0,0 +1,158 @@
+/*
+Copyright (c) 2017 David Breeding
+
+This file is part of tableprint.
+
+tableprint is free software: you can redistribute it and/or modify
+it under the terms of the Lesser GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+tableprint is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with tableprint (see the files "COPYING" and "COPYING.LESSER").
+If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* ************************************************************************ *
+ * styleprinttemplate.h - Header file for StylePrintTemplate, the parsed    *
+ * xml definition of a printout                                             *
+ * ************************************************************************ */
+
+#ifndef __STYLE_PRINT_TEMPLATE_H
+#define __STYLE_PRINT_TEMPLATE_H
+
+#ifdef _cplusplus
+extern "C"
+{       //}     // To make vim quit trying to indent...
+#endif
+
+#include <glib-object.h>
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+#define STYLE_PRINT_TYPE_TEMPLATE (style_print_template_get_type())
+
+G_DECLARE_FINAL_TYPE(StylePrintTemplate, style_print_template, STYLE_PRINT, TEMPLATE, GObject)
+
+/**
+ * StylePrintStaticCell:
+ * @font: The font, in the form read by pango_font_description_from_string()
+ * @txtsource: Where the text comes from - one of the #DataSources
+ * @celltext: The text, or the column name for a #TSRC_DATA cell
+ * @percent: The percent of the page width used by the cell
+ * @cellwidth: The "cellwidth" attribute
+ * @padleft: Padding for the left side of the cell
+ * @padright: Padding for the right side of the cell
+ * @borderstyle: The border style
+ * @align: The #PangoAlignment of the text
+ *
+ * A cell of a #StylePrintStaticGroup.
+ */
+
+typedef struct _StylePrintStaticCell {
+    const gchar *font;
+    gint         txtsource;
+    const gchar *celltext;
+    gdouble      percent;
+    gdouble      cellwidth;
+    gint         padleft;
+    gint         padright;
+    gint         borderstyle;
+    gint         align;
+} StylePrintStaticCell;
+
+typedef struct _StylePrintStaticGroup StylePrintStaticGroup;
+
+/**
+ * StylePrintStaticGroup:
+ * @grptype: The kind of group - one of the #GRPTY values
+ * @font: (nullable): The font, in the form read by
+ * pango_font_description_from_string()
+ * @grpcol: (nullable): The column the group is formed on (the
+ * "groupsource" attribute)
+ * @pointsabove: Points of space above the group
+ * @pointsbelow: Points of space below the group
+ * @borderstyle: The border style
+ * @padding: (nullable) (array fixed-size=4): The left, top, right and
+ * bottom padding, -1 for any not set
+ * @header: (nullable): The header of the group
+ * @child: (nullable): The group or body within this group
+ * @cells: (array length=ncells): The cells of the row
+ * @ncells: The number of @cells
+ *
+ * A group, body or header of a #StylePrintStaticTemplate.
+ */
+
+struct _StylePrintStaticGroup {
+    gint                         grptype;
+    const gchar                 *font;
+    const gchar                 *grpcol;
+    gint                         pointsabove;
+    gint                         pointsbelow;
+    gint                         borderstyle;
+    const gdouble               *padding;
+    const StylePrintStaticGroup *header;
+    const StylePrintStaticGroup *child;
+    const StylePrintStaticCell  *cells;
+    guint                        ncells;
+};
+
+/**
+ * StylePrintStaticTemplate:
+ * @defaultfont: The font of the default cell
+ * @defaultpadding: (array fixed-size=4): The default left, top, right and
+ * bottom padding
+ * @docheader: (nullable): The header for the first page
+ * @pageheader: (nullable): The header for each page
+ * @body: (nullable): The outermost group, or the body
+ *
+ * A printout definition held in static tables, as written by the
+ * styleprint-compile tool.
+ */
+
+typedef struct _StylePrintStaticTemplate {
+    const gchar                 *defaultfont;
+    const gdouble               *defaultpadding;
+    const StylePrintStaticGroup *docheader;
+    const StylePrintStaticGroup *pageheader;
+    const StylePrintStaticGroup *body;
+} StylePrintStaticTemplate;
+
+StylePrintTemplate *style_print_template_new_from_file (
+                                                const gchar  *filename,
+                                                     GError **error);
+StylePrintTemplate *style_print_template_new_from_string (
+                                                const gchar  *xml,
+                                                     GError **error);
+StylePrintTemplate *style_print_template_new_from_array (
+                                                      gchar **xml,
+                                                     GError **error);
+StylePrintTemplate *style_print_template_new_from_static (
+                            const StylePrintStaticTemplate *tables);
+
+StylePrintTemplate *style_print_template_lookup_file (
+                                                const gchar  *filename,
+                                                     GError **error);
+StylePrintTemplate *style_print_template_lookup_string (
+                                                const gchar  *xml,
+                                                     GError **error);
+StylePrintTemplate *style_print_template_lookup_array (
+                                                      gchar **xml,
+                                                     GError **error);
+StylePrintTemplate *style_print_template_lookup_static (
+                            const StylePrintStaticTemplate *tables);
+void style_print_template_cache_clear (void);
+
+G_END_DECLS
+
+#ifdef _cplusplus
+}
+#endif
+
+#endif      //ifndef __STYLE_PRINT_TEMPLATE_H